@@ -0,0 +1,76 @@
+#!/bin/sh
+# -------------------------------------------------------------------------
+# Mesure des performances des exercices 03 à 12, 15 à 23 sous simavr.
+#
+# Usage : bench/run.sh [durée simulée en secondes]
+#
+# Chaque exercice est compilé dans l'environnement `bench` de PlatformIO
+# (macro BENCH définie), puis exécuté par le banc de mesure. L'exercice 15
+# est mesuré pour des rampes de 8, 64 et 512 LEDs : la ligne ledWrite()
+# donne alors la durée d'émission d'un motif, et son nombre d'occurrences
+# le nombre de rafraîchissements de la rampe. L'exercice 05 est mesuré
+# avec et sans digitalWrite() (macro LED_DIGITAL_WRITE), et l'exercice 18
+# avec et sans ses compteurs de performances (macro PERF), pour en évaluer
+# le coût.
+#
+# Le relevé est aussi enregistré dans bench/results.txt, pour être validé
+# avec le code qu'il mesure.
+# -------------------------------------------------------------------------
+
+set -e
+
+cd "$(dirname "$0")/.."
+
+SECONDS_SIMULATED=${1:-30}
+RESULTS=bench/results.txt
+
+# Exécution du dernier programme compilé, sous le libellé $1.
+measure() {
+    echo | tee -a "$RESULTS"
+    bench/simavr/chaser_bench .pio/build/bench/firmware.elf "$SECONDS_SIMULATED" \
+        | sed "1s|.*|$1|" | tee -a "$RESULTS"
+}
+
+make -s -C bench/simavr
+
+echo "Relevé de bench/run.sh : $SECONDS_SIMULATED s simulées par exercice" > "$RESULTS"
+
+for header in \
+    03-two-way-scanning.h \
+    04-revised-blink.h \
+    06-simple-animation.h \
+    07-animations-v1.h \
+    08-animations-v2.h \
+    09-compressed-animations.h \
+    10-procedural-animations.h \
+    11-timer-player.h \
+    12-bcm-brightness.h \
+    16-layered-players.h \
+    17-tickless-sleep.h \
+    19-compiled-show.h \
+    20-generated-animations.h \
+    21-microsecond-timebase.h \
+    22-frame-durations.h \
+    23-playlist.h
+do
+    PLATFORMIO_BUILD_FLAGS="-D EXERCISE=\\\"$header\\\"" pio run -s -e bench
+    measure "$header"
+done
+
+for digital_write in 0 1
+do
+    PLATFORMIO_BUILD_FLAGS="-D EXERCISE=\\\"05-binary-counter.h\\\" -D LED_DIGITAL_WRITE=$digital_write" pio run -s -e bench
+    measure "05-binary-counter.h (LED_DIGITAL_WRITE=$digital_write)"
+done
+
+for leds in 8 64 512
+do
+    PLATFORMIO_BUILD_FLAGS="-D EXERCISE=\\\"15-shift-register-spi.h\\\" -D SHIFT_LEDS=$leds" pio run -s -e bench
+    measure "15-shift-register-spi.h ($leds LEDs)"
+done
+
+for perf in 1 0
+do
+    PLATFORMIO_BUILD_FLAGS="-D EXERCISE=\\\"18-perf-counters.h\\\" -D PERF=$perf" pio run -s -e bench
+    measure "18-perf-counters.h (PERF=$perf)"
+done
@@ -0,0 +1,287 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Banc de mesure des performances sous simavr (ATmega328P à 16 MHz)
+ * -------------------------------------------------------------------------
+ *
+ * Usage : chaser_bench firmware.elf [durée simulée en secondes]
+ *
+ * Le firmware doit être compilé avec la macro BENCH (environnement `bench`
+ * de PlatformIO). Les marqueurs définis dans lib/Bench/src/Bench.h sont
+ * écrits dans le registre GPIOR0 : chaque écriture est datée au cycle
+ * d'horloge près, ce qui permet de mesurer :
+ *
+ *   - la durée d'une itération de loop(),
+ *   - la durée d'un appel à ledWrite(),
+ *   - la durée d'un appel à playAnimation(), en isolant le pire cas
+ *     observé lors d'un changement d'animation,
+ *   - la période effective d'affichage des motifs, comparée à la période
+ *     attendue par le programme,
+ *   - pour un programme qui programme la durée de chaque motif dans le
+ *     Timer1 (marqueur BENCH_FRAME_TIMER1), la durée effective de chaque
+ *     motif comparée, durée par durée, à celle que donnent les registres
+ *     OCR1A et TCCR1B.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sim_avr.h>
+#include <sim_elf.h>
+
+#include "../../lib/Bench/src/Bench.h"
+
+#define FREQUENCY 16000000UL
+
+// Adresses des registres GPIOR dans l'espace des données de l'ATmega328P.
+#define GPIOR0_ADDR 0x3e
+#define GPIOR1_ADDR 0x4a
+#define GPIOR2_ADDR 0x4b
+
+// Adresses des registres du Timer1.
+#define TCCR1B_ADDR 0x81
+#define OCR1AL_ADDR 0x88
+#define OCR1AH_ADDR 0x89
+
+// Nombre maximal de durées distinctes programmées dans le Timer1.
+#define MAX_PERIODS 32
+
+/**
+ * @brief Statistiques d'une durée mesurée en cycles d'horloge.
+ */
+typedef struct {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+} stat_t;
+
+static void statAdd(stat_t *s, const uint64_t value) {
+    if (s->count == 0 || value < s->min) s->min = value;
+    if (value > s->max) s->max = value;
+    s->sum += value;
+    s->count++;
+}
+
+static void statPrint(const char *label, const stat_t *s) {
+    if (s->count == 0) {
+        printf("  %-28s -\n", label);
+        return;
+    }
+    printf("  %-28s n=%-8llu min=%-7llu moy=%-9.1f max=%llu cycles\n", label,
+           (unsigned long long) s->count, (unsigned long long) s->min,
+           (double) s->sum / s->count, (unsigned long long) s->max);
+}
+
+/**
+ * @brief Écarts observés pour l'une des durées programmées dans le Timer1
+ *        (en cycles d'horloge).
+ */
+typedef struct {
+    uint32_t intended;     // Durée programmée : (OCR1A + 1) × pré-diviseur.
+    uint64_t count;
+    uint64_t sum;          // Cumul des durées effectives.
+    int64_t  min;          // Plus petit écart.
+    int64_t  max;          // Plus grand écart.
+} period_t;
+
+static int periodCompare(const void *a, const void *b) {
+    const uint32_t x = ((const period_t *) a)->intended;
+    const uint32_t y = ((const period_t *) b)->intended;
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * @brief État du banc de mesure.
+ */
+static struct {
+
+    uint64_t loop_at;      // Date de la dernière entrée dans loop().
+    uint64_t write_at;     // Date de la dernière entrée dans ledWrite().
+    uint64_t play_at;      // Date de la dernière entrée dans playAnimation().
+    int      boundary;     // Une animation a été lancée pendant playAnimation().
+
+    uint64_t frame_at;     // Date du dernier affichage de motif.
+    uint16_t frame_ms;     // Période attendue avant le motif suivant.
+
+    stat_t   loop;
+    stat_t   write;
+    stat_t   play;
+    stat_t   play_boundary;
+
+    uint64_t frames;
+    double   intended_ms;  // Cumul des périodes attendues.
+    double   actual_ms;    // Cumul des périodes effectives.
+    double   max_late_ms;  // Plus grand retard observé sur un motif.
+
+    uint64_t period_at;    // Date du dernier motif programmé dans le Timer1.
+    uint32_t period;       // Durée programmée de ce motif (cycles).
+    period_t periods[MAX_PERIODS];
+    int      num_periods;
+
+} bench;
+
+/**
+ * @brief Écarts d'une durée programmée (NULL si la table est pleine).
+ */
+static period_t *periodFind(const uint32_t intended) {
+    for (int i=0; i<bench.num_periods; i++) {
+        if (bench.periods[i].intended == intended) return &bench.periods[i];
+    }
+    if (bench.num_periods == MAX_PERIODS) return NULL;
+    period_t *p = &bench.periods[bench.num_periods++];
+    p->intended = intended;
+    return p;
+}
+
+/**
+ * @brief Durée programmée dans le Timer1 (en cycles d'horloge).
+ */
+static uint32_t timer1Cycles(const avr_t *avr) {
+    static const uint16_t PRESCALER[] = { 0, 1, 8, 64, 256, 1024, 0, 0 };
+    const uint32_t compare = avr->data[OCR1AL_ADDR] | (avr->data[OCR1AH_ADDR] << 8);
+    return (compare + 1) * PRESCALER[avr->data[TCCR1B_ADDR] & 0x07];
+}
+
+/**
+ * @brief Traitement d'un marqueur écrit dans GPIOR0.
+ */
+static void onMarker(avr_t *avr, avr_io_addr_t addr, uint8_t v, void *param) {
+
+    (void) param;
+    avr->data[addr] = v;
+
+    const uint64_t now = avr->cycle;
+
+    switch (v) {
+
+        case BENCH_LOOP:
+            if (bench.loop_at) statAdd(&bench.loop, now - bench.loop_at);
+            bench.loop_at = now;
+            break;
+
+        case BENCH_WRITE_BEGIN:
+            bench.write_at = now;
+            break;
+
+        case BENCH_WRITE_END:
+            statAdd(&bench.write, now - bench.write_at);
+            break;
+
+        case BENCH_PLAY_BEGIN:
+            bench.play_at  = now;
+            bench.boundary = 0;
+            break;
+
+        case BENCH_ANIMATION:
+            bench.boundary = 1;
+            break;
+
+        case BENCH_PLAY_END:
+            statAdd(bench.boundary ? &bench.play_boundary : &bench.play, now - bench.play_at);
+            break;
+
+        case BENCH_FRAME:
+            if (bench.frame_at) {
+                const double actual_ms = (double) (now - bench.frame_at) * 1000.0 / FREQUENCY;
+                const double late_ms   = actual_ms - bench.frame_ms;
+                bench.intended_ms += bench.frame_ms;
+                bench.actual_ms   += actual_ms;
+                if (late_ms > bench.max_late_ms) bench.max_late_ms = late_ms;
+                bench.frames++;
+            }
+            bench.frame_at = now;
+            bench.frame_ms = avr->data[GPIOR1_ADDR] | (avr->data[GPIOR2_ADDR] << 8);
+            break;
+
+        case BENCH_FRAME_TIMER1:
+            if (bench.period_at) {
+                period_t *p = periodFind(bench.period);
+                if (p) {
+                    const int64_t error = (int64_t) (now - bench.period_at) - bench.period;
+                    if (p->count == 0 || error < p->min) p->min = error;
+                    if (p->count == 0 || error > p->max) p->max = error;
+                    p->sum += now - bench.period_at;
+                    p->count++;
+                }
+            }
+            bench.period_at = now;
+            bench.period    = timer1Cycles(avr);
+            break;
+
+    }
+
+}
+
+int main(int argc, char **argv) {
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s firmware.elf [secondes]\n", argv[0]);
+        return 1;
+    }
+
+    const double seconds = argc > 2 ? atof(argv[2]) : 30.0;
+
+    elf_firmware_t firmware;
+    memset(&firmware, 0, sizeof(firmware));
+
+    if (elf_read_firmware(argv[1], &firmware) != 0) {
+        fprintf(stderr, "%s : lecture du firmware impossible\n", argv[1]);
+        return 1;
+    }
+
+    avr_t *avr = avr_make_mcu_by_name("atmega328p");
+    if (avr == NULL) {
+        fprintf(stderr, "atmega328p : microcontrôleur inconnu de simavr\n");
+        return 1;
+    }
+
+    avr_init(avr);
+    firmware.frequency = FREQUENCY;
+    avr_load_firmware(avr, &firmware);
+
+    avr_register_io_write(avr, GPIOR0_ADDR, onMarker, NULL);
+
+    const uint64_t end = (uint64_t) (seconds * FREQUENCY);
+    int state = cpu_Running;
+
+    while (avr->cycle < end && state != cpu_Done && state != cpu_Crashed) {
+        state = avr_run(avr);
+    }
+
+    printf("%s (%.1f s simulées)\n", argv[1], (double) avr->cycle / FREQUENCY);
+
+    statPrint("loop()",                    &bench.loop);
+    statPrint("ledWrite()",                &bench.write);
+    statPrint("playAnimation()",           &bench.play);
+    statPrint("playAnimation() [bascule]", &bench.play_boundary);
+
+    if (bench.frames) {
+        printf("  %-28s n=%-8llu attendue=%.3f ms  effective=%.3f ms  retard max=%.3f ms  dérive=%+.1f ms\n",
+               "période des motifs", (unsigned long long) bench.frames,
+               bench.intended_ms / bench.frames, bench.actual_ms / bench.frames,
+               bench.max_late_ms, bench.actual_ms - bench.intended_ms);
+    } else {
+        printf("  %-28s -\n", "période des motifs");
+    }
+
+    qsort(bench.periods, bench.num_periods, sizeof(period_t), periodCompare);
+
+    for (int i=0; i<bench.num_periods; i++) {
+        const period_t *p = &bench.periods[i];
+        printf("  durée Timer1 %12.4f µs  n=%-8llu effective=%.4f µs  écart min=%+.4f µs max=%+.4f µs\n",
+               p->intended * 1e6 / FREQUENCY, (unsigned long long) p->count,
+               (double) p->sum / p->count * 1e6 / FREQUENCY,
+               p->min * 1e6 / FREQUENCY, p->max * 1e6 / FREQUENCY);
+    }
+
+    return state == cpu_Crashed ? 1 : 0;
+
+}
@@ -11,6 +11,7 @@
  */
 
 #include <Arduino.h>
+#include <Bench.h>
 
 /**
  * @brief Nombre de LEDs.
@@ -95,6 +96,8 @@ void setup() {
  */
 void loop() {
 
+    BENCH_MARK(BENCH_LOOP);
+
     // On calcule la durée en millisecondes qui s'est écoulée
     // depuis le dernier décalage opéré sur le chenillard,
     // c'est-à-dire la dernière fois qu'on a allumé une LED.
@@ -114,6 +117,7 @@ void loop() {
 
         // Puis on applique le décalage (dans le bon sens) et on allume la nouvelle LED.
         digitalWrite(LED_PIN[active_pin += direction], HIGH);
+        BENCH_FRAME_PERIOD(FLASH_DURATION_MS);
         // L'instruction ci-dessus est une forme condensée de la séquence suivante :
         //   active_pin = active_pin + direction;
         //   digitalWrite(LED_PIN[active_pin], HIGH);
@@ -11,6 +11,7 @@
  */
 
 #include <Arduino.h>
+#include <Bench.h>
 
 /**
  * @brief Définition de la broche de commande de la LED.
@@ -82,6 +83,8 @@ void setup() {
  */
 void loop() {
 
+    BENCH_MARK(BENCH_LOOP);
+
     // ------------------------------------------
     // Le code est, cette fois-ci, non bloquant !
     // ------------------------------------------
@@ -11,6 +11,21 @@
  */
 
 #include <Arduino.h>
+#include <Bench.h>
+
+/**
+ * @brief Écriture des LEDs une à une avec digitalWrite(), comme dans les
+ *        exercices précédents.
+ * 
+ * @note Cette version est conservée pour être comparée à l'écriture directe
+ *       sur les ports au banc de mesure (bench/run.sh). Elle se choisit à la
+ *       compilation, sans modifier ce fichier :
+ * 
+ *           -D LED_DIGITAL_WRITE=1
+ */
+#ifndef LED_DIGITAL_WRITE
+#define LED_DIGITAL_WRITE 0
+#endif
 
 /**
  * @brief Nombre de LEDs.
@@ -20,7 +35,7 @@ const uint8_t NUM_LEDS = 8;
 /**
  * @brief Broches de commande des LEDs.
  */
-const uint8_t LED_PIN[] = { 5, 6, 7, 8, 9, 10, 11, 12 };
+constexpr uint8_t LED_PIN[] = { 5, 6, 7, 8, 9, 10, 11, 12 };
 
 /**
  * @brief Durée pendant laquelle on affiche la valeur courante du compteur.
@@ -37,6 +52,57 @@ uint32_t last_step_ms = 0;
  */
 uint8_t counter = 0;
 
+/**
+ * @brief Bit du port D ou du port B qui commande une broche numérique.
+ * 
+ * @note Sur l'ATmega328P des cartes Uno et Nano, les broches D0 à D7 sont
+ *       câblées sur les bits 0 à 7 du port D, et les broches D8 à D13 sur
+ *       les bits 0 à 5 du port B. Ces fonctions sont évaluées à la compilation.
+ */
+constexpr uint8_t portDBit(const uint8_t pin) { return pin < 8 ? 1 << pin : 0; }
+constexpr uint8_t portBBit(const uint8_t pin) { return pin >= 8 && pin < 14 ? 1 << (pin - 8) : 0; }
+
+/**
+ * @brief Masques des bits des ports D et B occupés par les LEDs.
+ */
+constexpr uint8_t portDMask(const uint8_t i = 0) { return i < NUM_LEDS ? portDBit(LED_PIN[i]) | portDMask(i + 1) : 0; }
+constexpr uint8_t portBMask(const uint8_t i = 0) { return i < NUM_LEDS ? portBBit(LED_PIN[i]) | portBMask(i + 1) : 0; }
+
+/**
+ * @brief Décalage qui amène le bit d'indice `i` du motif sur le bit du port
+ *        qui commande la LED d'indice `i` (calculé sur la première LED du port).
+ */
+constexpr int8_t portDShift(const uint8_t i = 0) { return i == NUM_LEDS ? 0 : LED_PIN[i] < 8 ? LED_PIN[i] - i : portDShift(i + 1); }
+constexpr int8_t portBShift(const uint8_t i = 0) { return i == NUM_LEDS ? 0 : portBBit(LED_PIN[i]) ? LED_PIN[i] - 8 - i : portBShift(i + 1); }
+
+/**
+ * @brief Vérifie que chaque LED est bien raccordée à l'un des deux ports.
+ */
+constexpr bool ledsOnPorts(const uint8_t i = 0) { return i == NUM_LEDS || ((portDBit(LED_PIN[i]) | portBBit(LED_PIN[i])) && ledsOnPorts(i + 1)); }
+
+/**
+ * @brief Vérifie que le motif se transpose sur chaque port par un simple décalage.
+ * 
+ * @note C'est le cas lorsque les LEDs d'un même port sont branchées dans l'ordre
+ *       sur des bits consécutifs, comme sur notre montage (D5 à D12).
+ */
+constexpr bool ledsShiftable(const uint8_t i = 0) {
+    return i == NUM_LEDS || ((LED_PIN[i] < 8 ? LED_PIN[i] - i == portDShift() : LED_PIN[i] - 8 - i == portBShift()) && ledsShiftable(i + 1));
+}
+
+/**
+ * @brief Décalage (à gauche si `s` est positif, à droite sinon) d'un motif binaire.
+ */
+constexpr uint8_t shiftPattern(const uint8_t pattern, const int8_t s) { return s >= 0 ? pattern << s : pattern >> -s; }
+
+static_assert(ledsOnPorts(), "Chaque LED doit être branchée sur l'une des broches D0 à D13.");
+
+const uint8_t LED_PORTD_MASK  = portDMask();
+const uint8_t LED_PORTB_MASK  = portBMask();
+const int8_t  LED_PORTD_SHIFT = portDShift();
+const int8_t  LED_PORTB_SHIFT = portBShift();
+const bool    LED_SHIFTABLE   = ledsShiftable();
+
 /**
  * @brief Affichage d'un entier sur la rampe de LEDs.
  * 
@@ -48,154 +114,206 @@ uint8_t counter = 0;
  * 
  *       - si le bit d'indice i vaut 0, alors la LED d'indice i est éteinte
  *       - si le bit d'indice i vaut 1, alors la LED d'indice i est allumée
+ * 
+ * @note Plutôt que d'appeler digitalWrite() pour chacune des LEDs, on calcule
+ *       directement les nouvelles valeurs des registres PORTD et PORTB, que l'on
+ *       écrit chacun en une seule fois. Chaque appel à digitalWrite() consulte
+ *       les tables de correspondance des broches, désactive l'éventuelle sortie
+ *       PWM et suspend les interruptions, pour chacune des 8 LEDs. L'écriture
+ *       directe sur les ports se réduit à une lecture, un masque et une
+ *       écriture par port. Le banc de mesure (bench/run.sh) donne la durée
+ *       de ledWrite() au cycle près, avec et sans LED_DIGITAL_WRITE.
+ * 
+ *       Les interruptions sont suspendues le temps de la lecture-modification-
+ *       écriture des ports, pour ne pas écraser une broche qu'une routine
+ *       d'interruption modifierait entre-temps.
  */
 void ledWrite(uint8_t n) {
 
-    // On parcourt, un à un, chaque bit qui compose le codage binaire
-    // de l'entier que l'on souhaite afficher. Cela revient finalement
-    // à parcourir chaque LED de la rampe :
-    for (uint8_t i=0; i<NUM_LEDS; i++) {
+    BENCH_MARK(BENCH_WRITE_BEGIN);
 
-        // L'astuce consiste ici à isoler le bit qui nous intéresse (donc
-        // celui d'indice `i`) en combinant astucieusement les opérateurs
-        // binaires suivants :
-        // 
-        // -----------------------------------------------------------------
-        // Opérateur de décalage à droite : a >> b
-        // -----------------------------------------------------------------
-        // 
-        // Si on considère la représentation binaire de l'entier `a`, cet
-        // opérateur permet de décaler tous les bits qui composent `a` de
-        // `b` crans vers la droite :
-        // 
-        // Exemple : 24 >> 2
-        // 
-        // Commençons par détailler le codage binaire du nombre 24 :
-        // 
-        // +-------------------------------+
-        // |        indices des bits       |  qui correspondent à des puissances de 2
-        // +-------------------------------+
-        // | 7 | 6 | 5 | 4 | 3 | 2 | 1 | 0 |
-        // +-------------------------------+        4    3
-        // | 0 | 0 | 0 | 1 | 1 | 0 | 0 | 0 |  24 = 2  + 2  = 2^4 + 2^3
-        // +-------------------------------+
-        // |        valeurs des bits       |
-        // +-------------------------------+
-        // 
-        // Si maintenant on opère sur 24 un décalage à droite de 2 bits :
-        // 
-        // +-------------------------------+
-        // | 0 | 0 | 0 | 1 | 1 | 0 | 0 | 0 |  24
-        // +-------------------------------+             2    1
-        // | 0 | 0 | 0 | 0 | 0 | 1 | 1 | 0 |  24 >> 2 = 2  + 2  = 2^2 + 2^1 = 4 + 2 = 6
-        // +-------------------------------+
-        // 
-        // Les bits de droite sont "perdus" et des bits à 0 "apparaissent" à gauche.
-        // 
-        // -----------------------------------------------------------------
-        //  Opérateur binaire AND : a & b
-        // -----------------------------------------------------------------
-        // 
-        // Si on considère les représentations binaires des entiers `a` et `b`,
-        // cet opérateur permet d'effectuer une opération logique, bit à bit,
-        // sur `a` et `b` selon la table de correspondance suivante :
-        // 
-        // +---------------+
-        // | x | y | x & y |
-        // +---------------+
-        // | 0 | 0 |   0   |
-        // | 0 | 1 |   0   |
-        // | 1 | 0 |   0   |
-        // | 1 | 1 |   1   |
-        // +---------------+
-        // 
-        // Exemple : 37 & 7
-        // 
-        // +-------------------------------+
-        // | 0 | 0 | 1 | 0 | 0 | 1 | 0 | 1 |  a = 37
-        // +-------------------------------+
-        // | 0 | 0 | 0 | 0 | 0 | 1 | 1 | 1 |  b =  7
-        // +===============================+
-        // | 0 | 0 | 0 | 0 | 0 | 1 | 0 | 1 |  a & b = 5
-        // +-------------------------------+
-        //           ^           ^   ^   ^
-        //           |           `---+---'
-        //           |               |
-        // ce bit de a est masqué    |
-        //    par celui de b         |
-        //                           |
-        //                   alors que ceux-ci
-        //                   demeurent visibles
-        // 
-        // L'opérateur & fonctionne ainsi comme un masque et ne laisse entrevoir
-        // que les bits de `a` qui correspondent aux bits à 1 de `b`.
-        // 
-        // -----------------------------------------------------------------
-        // Combinaison des opérateurs >> et &
-        // -----------------------------------------------------------------
-        // 
-        // Par conséquent, en combinant ces deux opérateurs, on peut aisément
-        // isoler un bit en particulier sur la représentation binaire d'un
-        // entier. Supposons que l'on souhaite isoler le bit d'indice 2 de
-        // l'entier 37 :
-        // 
-        // +-------------------------------+
-        // | 7 | 6 | 5 | 4 | 3 | 2 | 1 | 0 |  indices des bits
-        // +-------------------------------+
-        // | 0 | 0 | 1 | 0 | 0 | 1 | 0 | 1 |  37
-        // +-------------------------------+
-        //                       ^
-        //           le bit qui nous intéresse
-        // 
-        // Il suffira simplement d'opérer un décalage à droite de 2 bits :
-        // 
-        // +-------------------------------+
-        // | 7 | 6 | 5 | 4 | 3 | 2 | 1 | 0 |  indices des bits
-        // +-------------------------------+
-        // | 0 | 0 | 0 | 0 | 1 | 0 | 0 | 1 |  37 >> 2
-        // +-------------------------------+
-        //                               ^
-        // Puis d'appliquer un masque sur le bit d'indice 0 :
-        // 
-        // +-------------------------------+
-        // | 0 | 0 | 0 | 0 | 1 | 0 | 0 | 1 |  37 >> 2
-        // +-------------------------------+
-        // | 0 | 0 | 0 | 0 | 0 | 0 | 0 | 1 |  1  (masque de lecture du bit d'indice 0)
-        // +===============================+
-        // | 0 | 0 | 0 | 0 | 0 | 0 | 0 | 1 |  (37 >> 2) & 1 = 1
-        // +-------------------------------+
-        //                               ^
-        // On obtient 1 comme résultat final, qui correspond bien à la valeur
-        // du bit d'indice 2 de l'entier de départ 37.
-        // 
-        // Plus généralement, si on souhaite obtenir la valeur du
-        // bit d'indice `i` d'un entier quelconque `n`, il suffit
-        // d'appliquer l'opération suivante :
-        // 
-        //     (n >> i) & 1
-        // 
-        // Lorsque l'on code des expressions faisant intervenir des opérateurs
-        // binaires, on préfèrera souvent les écrire sous la forme :
-        // 
-        //     (n >> i) & 0b1
-        // ou  (n >> i) & 0x1
-        // 
-        // L'opérande `1` de masquage est ainsi écrit sous sa forme :
-        //     0b1 (binaire)
-        // ou  0x1 (hexadécimale)
-        // 
-        // Mais cela revient strictement à la même chose !
+#if LED_DIGITAL_WRITE
 
+    for (uint8_t i=0; i<NUM_LEDS; i++) {
         digitalWrite(LED_PIN[i], (n >> i) & 0x1);
+    }
+
+#else
+
+    uint8_t portd = 0;
+    uint8_t portb = 0;
+
+    // Si le câblage le permet, le motif est simplement décalé sur chaque port.
+    // La condition est évaluée à la compilation : seule l'une des deux branches
+    // subsiste dans le code généré.
+    if (LED_SHIFTABLE) {
+
+        portd = shiftPattern(n, LED_PORTD_SHIFT) & LED_PORTD_MASK;
+        portb = shiftPattern(n, LED_PORTB_SHIFT) & LED_PORTB_MASK;
+
+    // Sinon, on reporte chaque bit du motif sur le bit du port correspondant :
+    } else {
+
+        // On parcourt, un à un, chaque bit qui compose le codage binaire
+        // de l'entier que l'on souhaite afficher. Cela revient finalement
+        // à parcourir chaque LED de la rampe :
+        for (uint8_t i=0; i<NUM_LEDS; i++) {
+
+            // L'astuce consiste ici à isoler le bit qui nous intéresse (donc
+            // celui d'indice `i`) en combinant astucieusement les opérateurs
+            // binaires suivants :
+            // 
+            // -----------------------------------------------------------------
+            // Opérateur de décalage à droite : a >> b
+            // -----------------------------------------------------------------
+            // 
+            // Si on considère la représentation binaire de l'entier `a`, cet
+            // opérateur permet de décaler tous les bits qui composent `a` de
+            // `b` crans vers la droite :
+            // 
+            // Exemple : 24 >> 2
+            // 
+            // Commençons par détailler le codage binaire du nombre 24 :
+            // 
+            // +-------------------------------+
+            // |        indices des bits       |  qui correspondent à des puissances de 2
+            // +-------------------------------+
+            // | 7 | 6 | 5 | 4 | 3 | 2 | 1 | 0 |
+            // +-------------------------------+        4    3
+            // | 0 | 0 | 0 | 1 | 1 | 0 | 0 | 0 |  24 = 2  + 2  = 2^4 + 2^3
+            // +-------------------------------+
+            // |        valeurs des bits       |
+            // +-------------------------------+
+            // 
+            // Si maintenant on opère sur 24 un décalage à droite de 2 bits :
+            // 
+            // +-------------------------------+
+            // | 0 | 0 | 0 | 1 | 1 | 0 | 0 | 0 |  24
+            // +-------------------------------+             2    1
+            // | 0 | 0 | 0 | 0 | 0 | 1 | 1 | 0 |  24 >> 2 = 2  + 2  = 2^2 + 2^1 = 4 + 2 = 6
+            // +-------------------------------+
+            // 
+            // Les bits de droite sont "perdus" et des bits à 0 "apparaissent" à gauche.
+            // 
+            // -----------------------------------------------------------------
+            //  Opérateur binaire AND : a & b
+            // -----------------------------------------------------------------
+            // 
+            // Si on considère les représentations binaires des entiers `a` et `b`,
+            // cet opérateur permet d'effectuer une opération logique, bit à bit,
+            // sur `a` et `b` selon la table de correspondance suivante :
+            // 
+            // +---------------+
+            // | x | y | x & y |
+            // +---------------+
+            // | 0 | 0 |   0   |
+            // | 0 | 1 |   0   |
+            // | 1 | 0 |   0   |
+            // | 1 | 1 |   1   |
+            // +---------------+
+            // 
+            // Exemple : 37 & 7
+            // 
+            // +-------------------------------+
+            // | 0 | 0 | 1 | 0 | 0 | 1 | 0 | 1 |  a = 37
+            // +-------------------------------+
+            // | 0 | 0 | 0 | 0 | 0 | 1 | 1 | 1 |  b =  7
+            // +===============================+
+            // | 0 | 0 | 0 | 0 | 0 | 1 | 0 | 1 |  a & b = 5
+            // +-------------------------------+
+            //           ^           ^   ^   ^
+            //           |           `---+---'
+            //           |               |
+            // ce bit de a est masqué    |
+            //    par celui de b         |
+            //                           |
+            //                   alors que ceux-ci
+            //                   demeurent visibles
+            // 
+            // L'opérateur & fonctionne ainsi comme un masque et ne laisse entrevoir
+            // que les bits de `a` qui correspondent aux bits à 1 de `b`.
+            // 
+            // -----------------------------------------------------------------
+            // Combinaison des opérateurs >> et &
+            // -----------------------------------------------------------------
+            // 
+            // Par conséquent, en combinant ces deux opérateurs, on peut aisément
+            // isoler un bit en particulier sur la représentation binaire d'un
+            // entier. Supposons que l'on souhaite isoler le bit d'indice 2 de
+            // l'entier 37 :
+            // 
+            // +-------------------------------+
+            // | 7 | 6 | 5 | 4 | 3 | 2 | 1 | 0 |  indices des bits
+            // +-------------------------------+
+            // | 0 | 0 | 1 | 0 | 0 | 1 | 0 | 1 |  37
+            // +-------------------------------+
+            //                       ^
+            //           le bit qui nous intéresse
+            // 
+            // Il suffira simplement d'opérer un décalage à droite de 2 bits :
+            // 
+            // +-------------------------------+
+            // | 7 | 6 | 5 | 4 | 3 | 2 | 1 | 0 |  indices des bits
+            // +-------------------------------+
+            // | 0 | 0 | 0 | 0 | 1 | 0 | 0 | 1 |  37 >> 2
+            // +-------------------------------+
+            //                               ^
+            // Puis d'appliquer un masque sur le bit d'indice 0 :
+            // 
+            // +-------------------------------+
+            // | 0 | 0 | 0 | 0 | 1 | 0 | 0 | 1 |  37 >> 2
+            // +-------------------------------+
+            // | 0 | 0 | 0 | 0 | 0 | 0 | 0 | 1 |  1  (masque de lecture du bit d'indice 0)
+            // +===============================+
+            // | 0 | 0 | 0 | 0 | 0 | 0 | 0 | 1 |  (37 >> 2) & 1 = 1
+            // +-------------------------------+
+            //                               ^
+            // On obtient 1 comme résultat final, qui correspond bien à la valeur
+            // du bit d'indice 2 de l'entier de départ 37.
+            // 
+            // Plus généralement, si on souhaite obtenir la valeur du
+            // bit d'indice `i` d'un entier quelconque `n`, il suffit
+            // d'appliquer l'opération suivante :
+            // 
+            //     (n >> i) & 1
+            // 
+            // Lorsque l'on code des expressions faisant intervenir des opérateurs
+            // binaires, on préfèrera souvent les écrire sous la forme :
+            // 
+            //     (n >> i) & 0b1
+            // ou  (n >> i) & 0x1
+            // 
+            // L'opérande `1` de masquage est ainsi écrit sous sa forme :
+            //     0b1 (binaire)
+            // ou  0x1 (hexadécimale)
+            // 
+            // Mais cela revient strictement à la même chose !
+
+            if ((n >> i) & 0x1) {
+                portd |= portDBit(LED_PIN[i]);
+                portb |= portBBit(LED_PIN[i]);
+            }
+
+            // Notez qu'on pourrait tout aussi bien procéder de la
+            // manière suivante, en opérant un décalage à gauche :
+            // 
+            //   if (n & (1 << i)) { ... }
+            // 
+            // Je vous laisse y réfléchir ;-)
+        }
 
-        // Notez qu'on pourrait tout aussi bien procéder de la
-        // manière suivante, en opérant un décalage à gauche :
-        // 
-        //   digitalWrite(LED_PIN[i], n & (1 << i));
-        // 
-        // Je vous laisse y réfléchir ;-)
     }
 
+    const uint8_t sreg = SREG;
+    cli();
+    PORTD = (PORTD & ~LED_PORTD_MASK) | portd;
+    PORTB = (PORTB & ~LED_PORTB_MASK) | portb;
+    SREG = sreg;
+
+#endif
+
+    BENCH_MARK(BENCH_WRITE_END);
+
 }
 
 /**
@@ -220,6 +338,8 @@ void setup() {
  */
 void loop() {
 
+    BENCH_MARK(BENCH_LOOP);
+
     // On détermine la date courante.
     uint32_t now = millis();
 
@@ -230,6 +350,7 @@ void loop() {
         // Alors on affiche la valeur courante du compteur
         // et on l'incrémente d'une unité juste après :
         ledWrite(counter++);
+        BENCH_FRAME_PERIOD(STEP_DURATION_MS);
         // L'instruction ci-dessus est une forme condensée de la séquence suivante :
         //   ledWrite(counter);
         //   counter = counter + 1;
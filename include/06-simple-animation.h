@@ -11,16 +11,18 @@
  */
 
 #include <Arduino.h>
+#include <Bench.h>
+#include <Chaser.h>
 
 /**
- * @brief Nombre de LEDs.
- */
-const uint8_t NUM_LEDS = 8;
-
-/**
- * @brief Broches de commande des LEDs.
+ * @brief Rampe de LEDs, décrite par ses broches de commande (de la LED
+ *        d'indice 0 à la LED d'indice 7).
+ * 
+ * @note L'exercice 05 détaille le calcul des masques et des décalages des
+ *       ports déduits de ce câblage : la classe Chaser l'effectue désormais
+ *       à la compilation (voir lib/Chaser).
  */
-const uint8_t LED_PIN[] = { 5, 6, 7, 8, 9, 10, 11, 12 };
+typedef Chaser<5, 6, 7, 8, 9, 10, 11, 12> Leds;
 
 /**
  * @brief Nombre d'étapes que comporte l'animation.
@@ -88,12 +90,18 @@ uint32_t last_animation_step_ms = 0;
  * @brief Affichage d'un motif binaire 8-bits sur le chenillard à 8 LEDs.
  * 
  * @param n entier compris dans l'intervalle [0,255].
+ * 
+ * @note Comme dans l'exercice 05, les registres PORTD et PORTB sont écrits
+ *       directement, chacun en une seule fois, plutôt que LED par LED avec
+ *       digitalWrite().
  */
-void ledWrite(uint8_t n) {
+void ledWrite(const Leds::Frame n) {
 
-    for (uint8_t i=0; i<NUM_LEDS; i++) {
-        digitalWrite(LED_PIN[i], n & (1 << i));
-    }
+    BENCH_MARK(BENCH_WRITE_BEGIN);
+
+    Leds::write(n);
+
+    BENCH_MARK(BENCH_WRITE_END);
 
 }
 
@@ -103,9 +111,7 @@ void ledWrite(uint8_t n) {
 void setup() {
 
     // Configuration des broches de commande des LEDs.
-    for (uint8_t i=0; i<NUM_LEDS; i++) {
-        pinMode(LED_PIN[i], OUTPUT);
-    }
+    Leds::begin();
 
     // On initialise la date de démarrage de l'afficheur.
     last_animation_step_ms = millis();
@@ -120,6 +126,8 @@ void setup() {
  */
 void loop() {
 
+    BENCH_MARK(BENCH_LOOP);
+
     // On détermine la date courante :
     uint32_t now = millis();
 
@@ -130,6 +138,7 @@ void loop() {
         // Alors on affiche le motif binaire qui correspond à
         // l'étape courante de l'animation :
         ledWrite(ANIMATION[animation_step]);
+        BENCH_FRAME_PERIOD(ANIMATION_STEP_DURATION_MS);
 
         // Puis on passe à l'étape suivante :
         ++animation_step %= ANIMATION_STEPS;
@@ -11,20 +11,26 @@
  */
 
 #include <Arduino.h>
+#include <Bench.h>
+#include <Chaser.h>
 
 // ----------------------------------------------------------------------------
 // Définition des constantes et variables globales
 // ----------------------------------------------------------------------------
 
 /**
- * @brief Nombre de LEDs.
+ * @brief Rampe de LEDs, décrite par ses broches de commande (de la LED
+ *        d'indice 0 à la LED d'indice 7).
+ * 
+ * @note Les masques des ports et la séquence d'initialisation sont déduits
+ *       du câblage à la compilation (voir lib/Chaser).
  */
-const uint8_t NUM_LEDS = 8;
+typedef Chaser<5, 6, 7, 8, 9, 10, 11, 12> Leds;
 
 /**
- * @brief Broches de commande des LEDs.
+ * @brief Nombre de LEDs.
  */
-const uint8_t LED_PIN[] = { 5, 6, 7, 8, 9, 10, 11, 12 };
+const uint8_t NUM_LEDS = Leds::size;
 
 /**
  * @brief Nombre d'animations prédéfinies dans l'enchaînement proposé.
@@ -45,8 +51,14 @@ const uint8_t NUM_ANIMATIONS = 8;
  *       
  *       On fait ici le choix de définir au sein d'un même tableau l'ensemble
  *       des animations que nous allons enchaîner les unes après les autres.
+ * 
+ *       Le mot-clef PROGMEM demande au compilateur de laisser le tableau en
+ *       mémoire flash. Sans lui, toute donnée constante est recopiée au
+ *       démarrage dans les 2 Ko de mémoire vive (SRAM) du micro-contrôleur.
+ *       En contrepartie, le tableau doit être lu avec pgm_read_byte(). Il en
+ *       va de même pour les tableaux de description des animations qui suivent.
  */
-const uint8_t ANIMATION_FRAME[] = {
+const uint8_t ANIMATION_FRAME[] PROGMEM = {
     
     // animation #0
 
@@ -169,7 +181,7 @@ const uint8_t ANIMATION_FRAME[] = {
  * @note Cet indice permet de repérer le motif de départ de chaque
  *       animation dans le tableau `ANIMATION_FRAME`.
  */
-const uint8_t ANIMATION_START[] = {
+const uint8_t ANIMATION_START[] PROGMEM = {
      0, // animation #0
     14, // animation #1
     20, // animation #2
@@ -183,7 +195,7 @@ const uint8_t ANIMATION_START[] = {
 /**
  * @brief Définition du nombre de motifs que comporte chaque animation.
  */
-const uint8_t ANIMATION_FRAMES[] = {
+const uint8_t ANIMATION_FRAMES[] PROGMEM = {
     14, // animation #0
      6, // animation #1
     10, // animation #2
@@ -199,7 +211,7 @@ const uint8_t ANIMATION_FRAMES[] = {
  * 
  * @note Ces durées sont exprimées en millisecondes.
  */
-const uint8_t ANIMATION_DELAY_MS[] = {
+const uint8_t ANIMATION_DELAY_MS[] PROGMEM = {
      40, // animation #0
      50, // animation #1
      50, // animation #2
@@ -213,7 +225,7 @@ const uint8_t ANIMATION_DELAY_MS[] = {
 /**
  * @brief Définition du nombre de répétitions à appliquer à chaque animation.
  */
-const uint8_t ANIMATION_REPEAT[] = {
+const uint8_t ANIMATION_REPEAT[] PROGMEM = {
      4, // animation #0
      8, // animation #1
      5, // animation #2
@@ -275,9 +287,7 @@ uint32_t player_last_ms;
  */
 void initLeds() {
 
-    for (uint8_t i=0; i<NUM_LEDS; i++) {
-        pinMode(LED_PIN[i], OUTPUT);
-    }
+    Leds::begin();
 
 }
 
@@ -285,12 +295,22 @@ void initLeds() {
  * @brief Affichage d'un motif binaire 8-bits sur le chenillard à 8 LEDs.
  * 
  * @param n Entier compris dans l'intervalle [0,255].
+ * 
+ * @note Comme dans l'exercice 05, les registres PORTD et PORTB sont écrits
+ *       directement, chacun en une seule fois, plutôt que LED par LED avec
+ *       digitalWrite().
+ * 
+ *       Le câblage étant connu à la compilation, la classe Chaser effectue
+ *       ce calcul sans boucle ni lecture en table : un décalage et un masque
+ *       par port suffisent lorsque les LEDs sont branchées dans l'ordre.
  */
-void ledWrite(const uint8_t pattern) {
+void ledWrite(const Leds::Frame pattern) {
 
-    for (uint8_t i=0; i<NUM_LEDS; i++) {
-        digitalWrite(LED_PIN[i], pattern & (1 << i));
-    }
+    BENCH_MARK(BENCH_WRITE_BEGIN);
+
+    Leds::write(pattern);
+
+    BENCH_MARK(BENCH_WRITE_END);
 
 }
 
@@ -308,11 +328,13 @@ void ledWrite(const uint8_t pattern) {
  */
 void startAnimation(const uint8_t index) {
 
+    BENCH_MARK(BENCH_ANIMATION);
+
     animation_id       = index;
-    animation_start    = ANIMATION_START[index];
-    animation_frames   = ANIMATION_FRAMES[index];
-    animation_delay_ms = ANIMATION_DELAY_MS[index];
-    animation_repeat   = ANIMATION_REPEAT[index];
+    animation_start    = pgm_read_byte(&ANIMATION_START[index]);
+    animation_frames   = pgm_read_byte(&ANIMATION_FRAMES[index]);
+    animation_delay_ms = pgm_read_byte(&ANIMATION_DELAY_MS[index]);
+    animation_repeat   = pgm_read_byte(&ANIMATION_REPEAT[index]);
 
     player_frame  = 0;
     player_repeat = 0;
@@ -324,8 +346,10 @@ void startAnimation(const uint8_t index) {
  */
 void playAnimation() {
 
+    BENCH_MARK(BENCH_PLAY_BEGIN);
+
     // Lecture du motif binaire en cours à afficher sur la rampe de LEDs :
-    const uint8_t frame = ANIMATION_FRAME[animation_start + player_frame];
+    const uint8_t frame = pgm_read_byte(&ANIMATION_FRAME[animation_start + player_frame]);
 
     // Affichage du motif en cours sur la rampe de LEDs :
     ledWrite(frame);
@@ -366,6 +390,8 @@ void playAnimation() {
 
     }
 
+    BENCH_MARK(BENCH_PLAY_END);
+
 }
 
 // ----------------------------------------------------------------------------
@@ -390,11 +416,14 @@ void setup() {
  */
 void loop() {
 
+    BENCH_MARK(BENCH_LOOP);
+
     const uint32_t now = millis();
 
     if (now - player_last_ms > animation_delay_ms) {
 
         playAnimation();
+        BENCH_FRAME_PERIOD(animation_delay_ms);
 
         player_last_ms = now;
 
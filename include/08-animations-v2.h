@@ -11,25 +11,29 @@
  */
 
 #include <Arduino.h>
+#include <Bench.h>
+#include <Chaser.h>
+#include <Scheduler.h>
+#include <ShowBuilder.h>
+#include <Transition.h>
 
 // ----------------------------------------------------------------------------
 // Définition des constantes et variables globales
 // ----------------------------------------------------------------------------
 
 /**
- * @brief Nombre de LEDs.
- */
-const uint8_t NUM_LEDS = 8;
-
-/**
- * @brief Broches de commande des LEDs.
+ * @brief Rampe de LEDs, décrite par ses broches de commande (de la LED
+ *        d'indice 0 à la LED d'indice 7).
+ * 
+ * @note Les masques des ports et la séquence d'initialisation sont déduits
+ *       du câblage à la compilation (voir lib/Chaser).
  */
-const uint8_t LED_PIN[] = { 5, 6, 7, 8, 9, 10, 11, 12 };
+typedef Chaser<5, 6, 7, 8, 9, 10, 11, 12> Leds;
 
 /**
- * @brief Nombre d'animations prédéfinies dans l'enchaînement proposé.
+ * @brief Nombre de LEDs.
  */
-const uint8_t NUM_ANIMATIONS = 8;
+const uint8_t NUM_LEDS = Leds::size;
 
 /**
  * @brief Définition des motifs constituant chaque animation.
@@ -43,164 +47,194 @@ const uint8_t NUM_ANIMATIONS = 8;
  *       l'animation qu'elle participe à décrire. On parlera également de
  *       "frame" pour reprendre un anglicisme usuel.
  *       
- *       On fait ici le choix de définir au sein d'un même tableau l'ensemble
- *       des animations que nous allons enchaîner les unes après les autres.
+ *       Chaque animation est déclarée ici par sa propre liste de motifs. Ces
+ *       listes ne servent qu'à la compilation : elles sont ensuite mises bout
+ *       à bout dans un même tableau, rangé en mémoire flash (voir plus bas).
  */
-const uint8_t ANIMATION_FRAME[] = {
-    
-    // animation #0
-
-    0b10000000, //
-    0b01000000, //
-    0b00100000, //
-    0b00010000, //
-    0b00001000, //
-    0b00000100, //
-    0b00000010, // 14 frames
-    0b00000001, //
-    0b00000010, //
-    0b00000100, //
-    0b00001000, //
-    0b00010000, //
-    0b00100000, //
-    0b01000000, //
-
-    // animation #1
-
-    0b10000001, //
-    0b01000010, //
-    0b00100100, // 6 frames
-    0b00011000, //
-    0b00100100, //
-    0b01000010, //
-
-    // animation #2
-
-    0b11100000, //
-    0b01110000, //
-    0b00111000, //
-    0b00011100, //
-    0b00001110, // 10 frames
-    0b00000111, //
-    0b00001110, //
-    0b00011100, //
-    0b00111000, //
-    0b01110000, //
-
-    // animation #3
-
-    0b00000000, //
-    0b00011000, //
-    0b00111100, //
-    0b01111110, // 8 frames
-    0b11111111, //
-    0b01111110, //
-    0b00111100, //
-    0b00011000, //
-
-    // animation #4
-
-    0b01010101,// 2 frames
-    0b10101010,// 
-
-    // animation #5
-
-    0b00010001, //
-    0b00100010, // 4 frames
-    0b01000100, //
-    0b10001000, //
-
-    // animation #6
-
-    0b00000001, //
-    0b00000010, //
-    0b00000100, //
-    0b00001000, // 8 frames
-    0b00010000, //
-    0b00100000, //
-    0b01000000, //
-    0b10000000, //
-
-    // animation #7
-
-    0b00000000, //
-    0b00010000, //
-    0b00001000, //
-    0b00010000, //
-    0b00100000, //
-    0b00010000, //
-    0b00001000, //
-    0b00000100, //
-    0b00001000, //
-    0b00010000, //
-    0b00100000, //
-    0b01000000, //
-    0b00100000, //
-    0b00010000, //
-    0b00001000, //
-    0b00000100, //
-    0b00000010, //
-    0b00000100, // 37 frames
-    0b00001000, //
-    0b00010000, //
-    0b00100000, //
-    0b01000000, //
-    0b10000000, //
-    0b01000000, //
-    0b00100000, //
-    0b00010000, //
-    0b00001000, //
-    0b00000100, //
-    0b00000010, //
-    0b00000001, //
-    0b00000010, //
-    0b00000100, //
-    0b00001000, //
-    0b00010000, //
-    0b00100000, //
-    0b01000000, //
-    0b10000000  //
+constexpr uint8_t BALAYAGE[] = {
+    0b10000000,
+    0b01000000,
+    0b00100000,
+    0b00010000,
+    0b00001000,
+    0b00000100,
+    0b00000010,
+    0b00000001,
+    0b00000010,
+    0b00000100,
+    0b00001000,
+    0b00010000,
+    0b00100000,
+    0b01000000
+};
+
+constexpr uint8_t MIROIR[] = {
+    0b10000001,
+    0b01000010,
+    0b00100100,
+    0b00011000,
+    0b00100100,
+    0b01000010
+};
+
+constexpr uint8_t TRAIN[] = {
+    0b11100000,
+    0b01110000,
+    0b00111000,
+    0b00011100,
+    0b00001110,
+    0b00000111,
+    0b00001110,
+    0b00011100,
+    0b00111000,
+    0b01110000
+};
+
+constexpr uint8_t PULSATION[] = {
+    0b00000000,
+    0b00011000,
+    0b00111100,
+    0b01111110,
+    0b11111111,
+    0b01111110,
+    0b00111100,
+    0b00011000
+};
+
+constexpr uint8_t ALTERNANCE[] = {
+    0b01010101,
+    0b10101010
+};
+
+constexpr uint8_t VAGUE[] = {
+    0b00010001,
+    0b00100010,
+    0b01000100,
+    0b10001000
+};
 
+constexpr uint8_t MONTEE[] = {
+    0b00000001,
+    0b00000010,
+    0b00000100,
+    0b00001000,
+    0b00010000,
+    0b00100000,
+    0b01000000,
+    0b10000000
+};
+
+constexpr uint8_t REBONDS[] = {
+    0b00000000,
+    0b00010000,
+    0b00001000,
+    0b00010000,
+    0b00100000,
+    0b00010000,
+    0b00001000,
+    0b00000100,
+    0b00001000,
+    0b00010000,
+    0b00100000,
+    0b01000000,
+    0b00100000,
+    0b00010000,
+    0b00001000,
+    0b00000100,
+    0b00000010,
+    0b00000100,
+    0b00001000,
+    0b00010000,
+    0b00100000,
+    0b01000000,
+    0b10000000,
+    0b01000000,
+    0b00100000,
+    0b00010000,
+    0b00001000,
+    0b00000100,
+    0b00000010,
+    0b00000001,
+    0b00000010,
+    0b00000100,
+    0b00001000,
+    0b00010000,
+    0b00100000,
+    0b01000000,
+    0b10000000
 };
 
 /**
  * @brief Définition de la structure de données d'une animation.
  * 
  * @note Pour caractériser précisément chaque animation comme une séquence
- *       périodique de frames (définies par ailleurs dans le tableau précédent),
+ *       périodique de frames (rangées par ailleurs dans un tableau commun),
  *       on crée une structure de données générique pour les décrire toutes :
  */
 struct Animation {
-    uint8_t start;          // Indice du motif de départ dans le tableau.
-    uint8_t frames;         // Nombre de motifs constituant la séquence.
-    uint8_t frame_delay_ms; // Durée d'affichage de chaque motif exprimée en millisecondes.
-    uint8_t repeat;         // Nombre de répétitions de la séquence.
+    uint16_t   start;          // Indice du motif de départ dans le tableau.
+    uint8_t    frames;         // Nombre de motifs constituant la séquence.
+    uint8_t    frame_delay_ms; // Durée d'affichage de chaque motif exprimée en millisecondes.
+    uint8_t    repeat;         // Nombre de répétitions de la séquence.
+    Transition transition;     // Transition qui amène cette animation (voir lib/Transition).
 };
 
 /**
  * @brief Définition des animations périodiques que l'on souhaite enchaîner.
  * 
- * @note Maintenant que nous avons défini la structure générique commune à toutes
- *       les animations, il ne nous reste plus qu'à définir concrètement chacune
- *       d'entre elles :
+ * @note Les animations sont énumérées dans leur ordre de lecture, chacune avec
+ *       ses paramètres. Le tableau des motifs et les descripteurs sont
+ *       construits à la compilation (voir lib/ShowBuilder) : les champs
+ *       `start` et `frames` de chaque descripteur, comme le nombre
+ *       d'animations, sont déduits des listes de motifs, et n'ont donc plus
+ *       à être tenus à jour à la main. Une durée ou un nombre de répétitions
+ *       nul est refusé par le compilateur.
  */
-const Animation animation[] = {
+constexpr auto SHOW = show::build<Animation>(
 //
-//     +---------------- start
-//     |   +------------ frames
-//     |   |    +------- frame_delay_ms
-//     |   |    |   +--- repeat
-//     |   |    |   |
-//     v   v    v   v
-    {  0, 14,  40,  4 }, // animation #0
-    { 14,  6,  50,  8 }, // animation #1
-    { 20, 10,  50,  5 }, // animation #2
-    { 30,  8,  50,  6 }, // animation #3
-    { 38,  2, 120, 10 }, // animation #4
-    { 40,  4,  80,  8 }, // animation #5
-    { 44,  8,  60,  7 }, // animation #6
-    { 52, 37,  40,  1 }  // animation #7
-};
+//             +-------------------------- motifs
+//             |            +------------- frame_delay_ms
+//             |            |    +-------- repeat
+//             |            |    |   +---- transition
+//             |            |    |   |
+//             v            v    v   v
+    show::play(BALAYAGE,    40,  4, DISSOLVE  ), // animation #0
+    show::play(MIROIR,      50,  8, WIPE_OUT  ), // animation #1
+    show::play(TRAIN,       50,  5, SLIDE_DOWN), // animation #2
+    show::play(PULSATION,   50,  6, WIPE_OUT  ), // animation #3
+    show::play(ALTERNANCE, 120, 10, DISSOLVE  ), // animation #4
+    show::play(VAGUE,       80,  8, WIPE_UP   ), // animation #5
+    show::play(MONTEE,      60,  7, SLIDE_UP  ), // animation #6
+    show::play(REBONDS,     40,  1, WIPE_DOWN )  // animation #7
+);
+
+static_assert(show::valid(SHOW.animation, SHOW.animation.size, SHOW.frames.size), "Descripteurs d'animation incohérents.");
+
+/**
+ * @brief Nombre d'animations prédéfinies dans l'enchaînement proposé.
+ */
+const uint8_t NUM_ANIMATIONS = SHOW.animation.size;
+
+/**
+ * @brief Motifs de toutes les animations, mis bout à bout.
+ * 
+ * @note Le mot-clef PROGMEM demande au compilateur de laisser le tableau en
+ *       mémoire flash. Sans lui, toute donnée constante est recopiée au
+ *       démarrage dans les 2 Ko de mémoire vive (SRAM) du micro-contrôleur.
+ *       En contrepartie, le tableau ne peut plus être lu directement : il
+ *       faut passer par la fonction readFrame() définie plus bas.
+ * 
+ *       Seules ces copies en mémoire flash subsistent dans le programme : la
+ *       construction elle-même n'a lieu qu'à la compilation.
+ */
+const auto ANIMATION_FRAME PROGMEM = SHOW.frames;
+
+/**
+ * @brief Descripteurs des animations, dans l'ordre de lecture.
+ * 
+ * @note Comme les motifs, ces descripteurs sont conservés en mémoire flash.
+ */
+const auto animation PROGMEM = SHOW.animation;
 
 /**
  * @brief Définition du séquenceur d'animation.
@@ -210,10 +244,13 @@ const Animation animation[] = {
  *       lecture périodique des animations et la gestion des paramètres afférents.
  */
 struct Player {
-    uint8_t  animation_id; // Indice de l'animation en cours.
-    uint8_t  repeat;       // Nombre de répétitions effectuées.
-    uint8_t  frame;        // Indice du motif binaire relatif à l'animation en cours.
-    uint32_t last_ms;      // Date du dernier affichage opéré sur la rampe de LEDs.
+    uint8_t   animation_id; // Indice de l'animation en cours.
+    uint8_t   repeat;       // Nombre de répétitions effectuées.
+    uint8_t   frame;        // Indice du motif binaire relatif à l'animation en cours.
+    Deadline  deadline;     // Date à laquelle le prochain motif doit être affiché.
+    Animation animation;    // Copie en SRAM du descripteur de l'animation en cours.
+    uint8_t   step;         // Étape de la transition en cours (TRANSITION_STEPS si aucune).
+    uint8_t   last;         // Dernier motif affiché par l'animation précédente.
 };
 
 /**
@@ -222,10 +259,13 @@ struct Player {
  * @note Tous les paramètres sont initialisés à zéro par défaut.
  */
 Player player = {
-    0, // animation_id
-    0, // repeat
-    0, // frame
-    0  // last_ms
+    0,                // animation_id
+    0,                // repeat
+    0,                // frame
+    {},               // deadline
+    {},               // animation
+    TRANSITION_STEPS, // step
+    0                 // last
 };
 
 // ----------------------------------------------------------------------------
@@ -237,9 +277,7 @@ Player player = {
  */
 void initLeds() {
 
-    for (uint8_t i=0; i<NUM_LEDS; i++) {
-        pinMode(LED_PIN[i], OUTPUT);
-    }
+    Leds::begin();
 
 }
 
@@ -247,12 +285,49 @@ void initLeds() {
  * @brief Affichage d'un motif binaire 8-bits sur le chenillard à 8 LEDs.
  * 
  * @param n Entier compris dans l'intervalle [0,255].
+ * 
+ * @note Comme dans l'exercice 05, les registres PORTD et PORTB sont écrits
+ *       directement, chacun en une seule fois, plutôt que LED par LED avec
+ *       digitalWrite().
+ * 
+ *       Le câblage étant connu à la compilation, la classe Chaser effectue
+ *       ce calcul sans boucle ni lecture en table : un décalage et un masque
+ *       par port suffisent lorsque les LEDs sont branchées dans l'ordre.
  */
-void ledWrite(const uint8_t pattern) {
+void ledWrite(const Leds::Frame pattern) {
 
-    for (uint8_t i=0; i<NUM_LEDS; i++) {
-        digitalWrite(LED_PIN[i], pattern & (1 << i));
-    }
+    BENCH_MARK(BENCH_WRITE_BEGIN);
+
+    Leds::write(pattern);
+
+    BENCH_MARK(BENCH_WRITE_END);
+
+}
+
+// ----------------------------------------------------------------------------
+// Lecture des données en mémoire flash
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Lecture d'un motif binaire en mémoire flash.
+ * 
+ * @param index Indice du motif dans le tableau `ANIMATION_FRAME`.
+ */
+uint8_t readFrame(const uint16_t index) {
+
+    return pgm_read_byte(&ANIMATION_FRAME[index]);
+
+}
+
+/**
+ * @brief Lecture du descripteur d'une animation en mémoire flash.
+ * 
+ * @param index      Indice de l'animation (0 ≤ index < NUM_ANIMATIONS).
+ * @param pAnimation Structure de données en SRAM qui reçoit la copie.
+ */
+void readAnimation(const uint8_t index, Animation * const pAnimation) {
+
+    memcpy_P(pAnimation, &animation[index], sizeof(Animation));
 
 }
 
@@ -266,13 +341,19 @@ void ledWrite(const uint8_t pattern) {
  * @param index Indice de l'animation à lancer (0 ≤ index < NUM_ANIMATIONS)
  * 
  * @note On effectue l'initialisation des propriétés du séquenceur avec les données
- *       de prise en charge de la nouvelle animation qui va démarrer.
+ *       de prise en charge de la nouvelle animation qui va démarrer. Le descripteur
+ *       de l'animation est recopié une fois pour toutes depuis la mémoire flash.
  */
 void startAnimation(const uint8_t index) {
 
+    BENCH_MARK(BENCH_ANIMATION);
+
     player.animation_id = index;
     player.repeat       = 0;
     player.frame        = 0;
+    player.step         = TRANSITION_STEPS;
+
+    readAnimation(index, &player.animation);
 
 }
 
@@ -281,17 +362,35 @@ void startAnimation(const uint8_t index) {
  */
 void playAnimation() {
 
+    BENCH_MARK(BENCH_PLAY_BEGIN);
+
     // Définition d'un pointeur sur la structure de donnée qui décrit
-    // l'animation courante, permettant d'accéder directement à ses
-    // propriétés sans faire de copie locale.
+    // l'animation courante (la copie détenue par le séquenceur),
+    // permettant d'accéder directement à ses propriétés sans faire
+    // de copie locale.
     // 
     // Le mot-clef `const` utilisé 2 fois ici déclare que :
     //   1. la structure de données pointée est constante,
     //   2. le pointeur lui-même est de valeur constante,
-    const Animation * const pAnimation = &animation[player.animation_id];
+    const Animation * const pAnimation = &player.animation;
+
+    // Si une transition est en cours, on affiche l'étape suivante, calculée
+    // à partir du dernier motif de l'animation précédente et du premier motif
+    // de la nouvelle animation. La tête de lecture ne bouge pas tant que la
+    // transition n'est pas terminée.
+    if (player.step + 1 < TRANSITION_STEPS) {
+
+        player.step++;
+
+        ledWrite(transitionFrame(pAnimation->transition, player.last, readFrame(pAnimation->start), player.step));
+
+        BENCH_MARK(BENCH_PLAY_END);
+        return;
+
+    }
 
     // Lecture du motif binaire en cours à afficher sur la rampe de LEDs :
-    const uint8_t frame = ANIMATION_FRAME[pAnimation->start + player.frame];
+    const uint8_t frame = readFrame(pAnimation->start + player.frame);
 
     // Affichage du motif en cours sur la rampe de LEDs :
     ledWrite(frame);
@@ -329,10 +428,19 @@ void playAnimation() {
             // Il ne reste plus qu'à lancer la nouvelle animation :
             startAnimation(player.animation_id);
 
+            // Sans oublier d'amorcer la transition qui y mène, à partir
+            // du motif qui vient d'être affiché :
+            if (player.animation.transition != CUT) {
+                player.step = 0;
+                player.last = frame;
+            }
+
         }
 
     }
 
+    BENCH_MARK(BENCH_PLAY_END);
+
 }
 
 // ----------------------------------------------------------------------------
@@ -346,7 +454,7 @@ void setup() {
 
     initLeds();
     startAnimation(0);
-    player.last_ms = millis();
+    deadlineStart(player.deadline, millis(), player.animation.frame_delay_ms);
 
 }
 
@@ -357,22 +465,35 @@ void setup() {
  */
 void loop() {
 
+    BENCH_MARK(BENCH_LOOP);
+
     const uint32_t now = millis();
 
     // Définition d'un pointeur sur la structure de donnée qui décrit
-    // l'animation courante, permettant d'accéder directement à ses
-    // propriétés sans faire de copie locale.
+    // l'animation courante (la copie détenue par le séquenceur),
+    // permettant d'accéder directement à ses propriétés sans faire
+    // de copie locale.
     // 
     // Le mot-clef `const` utilisé 2 fois ici déclare que :
     //   1. la structure de données pointée est constante,
     //   2. le pointeur lui-même est de valeur constante,
-    const Animation * const pAnimation = &animation[player.animation_id];
+    const Animation * const pAnimation = &player.animation;
+
+    // L'échéance suivante est calculée à partir de l'échéance atteinte, et non
+    // de la date à laquelle la boucle s'en aperçoit : les retards de la boucle
+    // ne s'accumulent pas au fil des motifs. Après un retard important, les
+    // motifs en attente sont affichés coup sur coup jusqu'à ce que l'animation
+    // ait rattrapé son horaire (politique CATCH_UP).
+    if (deadlineReached(player.deadline, now)) {
 
-    if (now - player.last_ms > pAnimation->frame_delay_ms) {
+        // Le motif affiché reste en place pendant la durée prévue par son
+        // animation, même si la tête de lecture passe à l'animation suivante :
+        const uint8_t frame_delay_ms = pAnimation->frame_delay_ms;
 
         playAnimation();
+        BENCH_FRAME_PERIOD(frame_delay_ms);
 
-        player.last_ms = now;
+        deadlineAdvance(player.deadline, now, frame_delay_ms, CATCH_UP);
 
     }
 
@@ -0,0 +1,406 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Séquenceur d'animations compressées
+ * -------------------------------------------------------------------------
+ */
+
+#include <Arduino.h>
+#include <Bench.h>
+#include <Chaser.h>
+
+// ----------------------------------------------------------------------------
+// Définition des constantes et variables globales
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Rampe de LEDs, décrite par ses broches de commande (de la LED
+ *        d'indice 0 à la LED d'indice 7).
+ * 
+ * @note Les masques des ports et la séquence d'initialisation sont déduits
+ *       du câblage à la compilation (voir lib/Chaser).
+ */
+typedef Chaser<5, 6, 7, 8, 9, 10, 11, 12> Leds;
+
+/**
+ * @brief Nombre de LEDs.
+ */
+const uint8_t NUM_LEDS = Leds::size;
+
+/**
+ * @brief Nombre d'animations prédéfinies dans l'enchaînement proposé.
+ */
+const uint8_t NUM_ANIMATIONS = 8;
+
+/**
+ * @brief Codes des opérations de décompression.
+ * 
+ * @note Chaque animation n'est plus décrite par la liste exhaustive de ses motifs,
+ *       mais par une suite d'opérations qui calculent chaque motif à partir du
+ *       précédent (qui vaut 0 au début de l'animation). Une opération occupe un
+ *       octet d'en-tête `ooonnnnn`, éventuellement suivi d'octets de données :
+ * 
+ *       +------------------+---------+-----------------------------------------+
+ *       | 000nnnnn         | HOLD    | répète le motif précédent, n+1 fois     |
+ *       | 001nnnnn         | SHL     | décalage à gauche d'un bit, n+1 fois    |
+ *       | 010nnnnn         | SHR     | décalage à droite d'un bit, n+1 fois    |
+ *       | 011nnnnn         | ROL     | rotation à gauche d'un bit, n+1 fois    |
+ *       | 100nnnnn         | ROR     | rotation à droite d'un bit, n+1 fois    |
+ *       | 101nnnnn mask    | XOR     | ou exclusif avec `mask`, n+1 fois       |
+ *       | 110nnnnn f0...fn | LITERAL | les n+1 motifs qui suivent, tels quels  |
+ *       | 111p0bbb         | TOGGLE  | inverse le bit b, ou les bits b et b+1  |
+ *       |                  |         | si p = 1 (un seul motif)                |
+ *       +------------------+---------+-----------------------------------------+
+ * 
+ *       Les motifs qui se répètent, ou qui se déduisent du précédent par un
+ *       décalage ou par l'inversion de quelques bits, ne coûtent ainsi presque
+ *       plus rien en mémoire flash.
+ */
+const uint8_t OP_HOLD    = 0;
+const uint8_t OP_SHL     = 1;
+const uint8_t OP_SHR     = 2;
+const uint8_t OP_ROL     = 3;
+const uint8_t OP_ROR     = 4;
+const uint8_t OP_XOR     = 5;
+const uint8_t OP_LITERAL = 6;
+const uint8_t OP_TOGGLE  = 7;
+
+/**
+ * @brief Séquences compressées de l'ensemble des animations.
+ * 
+ * @note Ce tableau a été produit par l'encodeur `tools/show_codec.py` à partir
+ *       des motifs de l'exercice précédent (`tools/examples/show-08.txt`) :
+ *       41 octets au lieu de 89.
+ */
+const uint8_t ANIMATION_STREAM[] PROGMEM = {
+
+    // animation #0 : 14 motifs (TOGGLE 0x80, SHR x7, SHL x6)
+
+    0xe7, 0x46, 0x25,
+
+    // animation #1 : 6 motifs (LITERAL x6)
+
+    0xc5, 0x81, 0x42, 0x24, 0x18, 0x24, 0x42,
+
+    // animation #2 : 10 motifs (XOR 0xe0 x1, SHR x5, SHL x4)
+
+    0xa0, 0xe0, 0x44, 0x23,
+
+    // animation #3 : 8 motifs (LITERAL x8)
+
+    0xc7, 0x00, 0x18, 0x3c, 0x7e, 0xff, 0x7e, 0x3c,
+    0x18,
+
+    // animation #4 : 2 motifs (LITERAL x2)
+
+    0xc1, 0x55, 0xaa,
+
+    // animation #5 : 4 motifs (XOR 0x11 x1, SHL x3)
+
+    0xa0, 0x11, 0x22,
+
+    // animation #6 : 8 motifs (TOGGLE 0x01, SHL x7)
+
+    0xe0, 0x26,
+
+    // animation #7 : 37 motifs (HOLD x1, TOGGLE 0x10, SHR x1, SHL x2, SHR x3,
+    //                           SHL x4, SHR x5, SHL x6, SHR x7, SHL x7)
+
+    0x00, 0xe4, 0x40, 0x21, 0x42, 0x23, 0x44, 0x25,
+    0x46, 0x26
+
+};
+
+/**
+ * @brief Définition de la structure de données d'une animation.
+ * 
+ * @note La structure est la même qu'à l'exercice précédent, si ce n'est que
+ *       `start` désigne maintenant la position du premier octet de la séquence
+ *       compressée dans le tableau `ANIMATION_STREAM`.
+ */
+struct Animation {
+    uint16_t start;          // Position du début de la séquence compressée dans le tableau.
+    uint8_t  frames;         // Nombre de motifs constituant la séquence.
+    uint8_t  frame_delay_ms; // Durée d'affichage de chaque motif exprimée en millisecondes.
+    uint8_t  repeat;         // Nombre de répétitions de la séquence.
+};
+
+/**
+ * @brief Définition des animations périodiques que l'on souhaite enchaîner.
+ */
+const Animation animation[] PROGMEM = {
+//
+//     +---------------- start
+//     |   +------------ frames
+//     |   |    +------- frame_delay_ms
+//     |   |    |   +--- repeat
+//     |   |    |   |
+//     v   v    v   v
+    {  0, 14,  40,  4 }, // animation #0
+    {  3,  6,  50,  8 }, // animation #1
+    { 10, 10,  50,  5 }, // animation #2
+    { 14,  8,  50,  6 }, // animation #3
+    { 23,  2, 120, 10 }, // animation #4
+    { 26,  4,  80,  8 }, // animation #5
+    { 29,  8,  60,  7 }, // animation #6
+    { 31, 37,  40,  1 }  // animation #7
+};
+
+/**
+ * @brief Définition du décodeur de séquences compressées.
+ */
+struct Decoder {
+    uint16_t cursor;  // Position de lecture dans le tableau `ANIMATION_STREAM`.
+    uint8_t  op;      // Opération en cours.
+    uint8_t  run;     // Nombre de motifs qu'il reste à produire par l'opération en cours.
+    uint8_t  mask;    // Masque de l'opération en cours (XOR et TOGGLE).
+    uint8_t  pattern; // Dernier motif décodé, prêt à être affiché.
+};
+
+/**
+ * @brief Définition du séquenceur d'animation.
+ */
+struct Player {
+    uint8_t   animation_id; // Indice de l'animation en cours.
+    uint8_t   repeat;       // Nombre de répétitions effectuées.
+    uint8_t   frame;        // Indice du motif binaire relatif à l'animation en cours.
+    uint32_t  last_ms;      // Date du dernier affichage opéré sur la rampe de LEDs.
+    Animation animation;    // Copie en SRAM du descripteur de l'animation en cours.
+    Decoder   decoder;      // Décodeur de la séquence de l'animation en cours.
+};
+
+/**
+ * @brief Initalisation du séquenceur.
+ * 
+ * @note Tous les paramètres sont initialisés à zéro par défaut.
+ */
+Player player = {
+    0,  // animation_id
+    0,  // repeat
+    0,  // frame
+    0,  // last_ms
+    {}, // animation
+    {}  // decoder
+};
+
+// ----------------------------------------------------------------------------
+// Gestion des LEDs
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Initialisation des broches de commande des LEDs.
+ */
+void initLeds() {
+
+    Leds::begin();
+
+}
+
+/**
+ * @brief Affichage d'un motif binaire 8-bits sur le chenillard à 8 LEDs.
+ * 
+ * @param n Entier compris dans l'intervalle [0,255].
+ * 
+ * @note Comme dans l'exercice 05, les registres PORTD et PORTB sont écrits
+ *       directement, chacun en une seule fois, plutôt que LED par LED avec
+ *       digitalWrite().
+ * 
+ *       Le câblage étant connu à la compilation, la classe Chaser effectue
+ *       ce calcul sans boucle ni lecture en table : un décalage et un masque
+ *       par port suffisent lorsque les LEDs sont branchées dans l'ordre.
+ */
+void ledWrite(const Leds::Frame pattern) {
+
+    BENCH_MARK(BENCH_WRITE_BEGIN);
+
+    Leds::write(pattern);
+
+    BENCH_MARK(BENCH_WRITE_END);
+
+}
+
+// ----------------------------------------------------------------------------
+// Décompression des séquences de motifs
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Lecture du prochain octet de la séquence compressée en mémoire flash.
+ */
+uint8_t readStream() {
+
+    return pgm_read_byte(&ANIMATION_STREAM[player.decoder.cursor++]);
+
+}
+
+/**
+ * @brief Lecture du descripteur d'une animation en mémoire flash.
+ * 
+ * @param index      Indice de l'animation (0 ≤ index < NUM_ANIMATIONS).
+ * @param pAnimation Structure de données en SRAM qui reçoit la copie.
+ */
+void readAnimation(const uint8_t index, Animation * const pAnimation) {
+
+    memcpy_P(pAnimation, &animation[index], sizeof(Animation));
+
+}
+
+/**
+ * @brief Décodage du motif suivant de l'animation courante.
+ * 
+ * @note Le décodage d'un motif lit au plus deux octets en mémoire flash (un
+ *       en-tête et sa donnée) et n'exécute aucune boucle : son coût est borné,
+ *       quelle que soit la séquence.
+ */
+void decodeFrame() {
+
+    Decoder * const d = &player.decoder;
+
+    // Si l'opération en cours a produit tous ses motifs,
+    // on lit l'en-tête de l'opération suivante :
+    if (d->run == 0) {
+
+        const uint8_t code = readStream();
+
+        d->op  = code >> 5;
+        d->run = (code & 0x1f) + 1;
+
+        if (d->op == OP_XOR) {
+            d->mask = readStream();
+        } else if (d->op == OP_TOGGLE) {
+            d->mask = (code & 0x10 ? 0x03 : 0x01) << (code & 0x07);
+            d->run  = 1;
+        }
+
+    }
+
+    uint8_t p = d->pattern;
+
+    switch (d->op) {
+        case OP_HOLD:                                  break;
+        case OP_SHL:     p <<= 1;                      break;
+        case OP_SHR:     p >>= 1;                      break;
+        case OP_ROL:     p = (p << 1) | (p >> 7);      break;
+        case OP_ROR:     p = (p >> 1) | (p << 7);      break;
+        case OP_LITERAL: p = readStream();             break;
+        default:         p ^= d->mask;                 break; // XOR et TOGGLE
+    }
+
+    d->pattern = p;
+    d->run--;
+
+}
+
+/**
+ * @brief Replace le décodeur au début de l'animation courante
+ *        et décode son premier motif.
+ */
+void rewindAnimation() {
+
+    player.frame = 0;
+
+    player.decoder.cursor  = player.animation.start;
+    player.decoder.run     = 0;
+    player.decoder.pattern = 0;
+
+    decodeFrame();
+
+}
+
+// ----------------------------------------------------------------------------
+// Gestion des animations
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Lancement d'une animation.
+ * 
+ * @param index Indice de l'animation à lancer (0 ≤ index < NUM_ANIMATIONS)
+ */
+void startAnimation(const uint8_t index) {
+
+    BENCH_MARK(BENCH_ANIMATION);
+
+    player.animation_id = index;
+    player.repeat       = 0;
+
+    readAnimation(index, &player.animation);
+    rewindAnimation();
+
+}
+
+/**
+ * @brief Lecture incrémentale de l'animation courante.
+ * 
+ * @note Le motif affiché a été décodé lors de l'appel précédent : l'affichage
+ *       intervient donc toujours au même instant, dès l'entrée dans la fonction,
+ *       et le décodage du motif suivant n'introduit aucune gigue.
+ */
+void playAnimation() {
+
+    BENCH_MARK(BENCH_PLAY_BEGIN);
+
+    ledWrite(player.decoder.pattern);
+
+    // Si l'animation courante n'est pas terminée, on décode le motif suivant :
+    if (player.frame + 1 < player.animation.frames) {
+
+        player.frame++;
+        decodeFrame();
+
+    // Sinon, on la répète si nécessaire, en reprenant le décodage au début...
+    } else if (player.repeat + 1 < player.animation.repeat) {
+
+        player.repeat++;
+        rewindAnimation();
+
+    // ... ou on passe à l'animation suivante.
+    } else {
+
+        startAnimation((player.animation_id + 1) % NUM_ANIMATIONS);
+
+    }
+
+    BENCH_MARK(BENCH_PLAY_END);
+
+}
+
+// ----------------------------------------------------------------------------
+// Squelette principal du programme
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Démarrage du programme.
+ */
+void setup() {
+
+    initLeds();
+    startAnimation(0);
+    player.last_ms = millis();
+
+}
+
+/**
+ * @brief Boucle de contrôle principale.
+ * 
+ * @note Toujours sans utiliser la fonction delay() !
+ */
+void loop() {
+
+    BENCH_MARK(BENCH_LOOP);
+
+    const uint32_t now = millis();
+
+    if (now - player.last_ms > player.animation.frame_delay_ms) {
+
+        playAnimation();
+        BENCH_FRAME_PERIOD(player.animation.frame_delay_ms);
+
+        player.last_ms = now;
+
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,367 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Séquenceur d'animations générées à la compilation
+ * -------------------------------------------------------------------------
+ */
+
+#include <Arduino.h>
+#include <Bench.h>
+#include <Chaser.h>
+#include <Frames.h>
+
+// ----------------------------------------------------------------------------
+// Définition des constantes et variables globales
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Rampe de LEDs, décrite par ses broches de commande (de la LED
+ *        d'indice 0 à la LED d'indice 7).
+ * 
+ * @note Les masques des ports et la séquence d'initialisation sont déduits
+ *       du câblage à la compilation (voir lib/Chaser).
+ */
+typedef Chaser<5, 6, 7, 8, 9, 10, 11, 12> Leds;
+
+/**
+ * @brief Nombre de LEDs.
+ */
+const uint8_t NUM_LEDS = Leds::size;
+
+/**
+ * @brief Nombre d'animations prédéfinies dans l'enchaînement proposé.
+ */
+const uint8_t NUM_ANIMATIONS = 8;
+
+/**
+ * @brief Définition des motifs constituant chaque animation.
+ * 
+ * @note Les motifs de la plupart des animations de l'exercice 08 suivent une
+ *       règle simple : un point ou un bloc qui rebondit d'un bout à l'autre de
+ *       la rampe, un balayage, un remplissage symétrique, etc. Plutôt que de
+ *       les saisir un à un, on les fait calculer par le compilateur à l'aide
+ *       des générateurs définis dans `lib/Frames`.
+ * 
+ *       Ces générateurs sont évalués à la compilation : le firmware ne contient
+ *       que les motifs obtenus, exactement comme s'ils avaient été saisis à la
+ *       main, et aucun calcul n'est effectué par le micro-contrôleur. Une
+ *       animation de 200 motifs ne coûte donc pas davantage qu'une ligne de code.
+ * 
+ *       Rien n'empêche, par ailleurs, de décrire une animation irrégulière motif
+ *       par motif, comme l'animation #7.
+ */
+constexpr auto ANIMATION_0 = bounce<1>();            // un point qui rebondit
+constexpr auto ANIMATION_1 = mirror(bounce<1, 4>()); // deux points qui se croisent au centre
+constexpr auto ANIMATION_2 = bounce<3>();            // KITT
+constexpr auto ANIMATION_3 = mirror(fill<4>());      // remplissage depuis le centre
+constexpr auto ANIMATION_4 = alternate(0b01010101);  // clignotement alterné
+constexpr auto ANIMATION_5 = scan<4>(0b00010001);    // deux points qui défilent
+constexpr auto ANIMATION_6 = scan<8>(0b00000001);    // un point qui défile
+
+constexpr Frames<37> ANIMATION_7 = {{
+    0b00000000, 0b00010000, 0b00001000, 0b00010000,
+    0b00100000, 0b00010000, 0b00001000, 0b00000100,
+    0b00001000, 0b00010000, 0b00100000, 0b01000000,
+    0b00100000, 0b00010000, 0b00001000, 0b00000100,
+    0b00000010, 0b00000100, 0b00001000, 0b00010000,
+    0b00100000, 0b01000000, 0b10000000, 0b01000000,
+    0b00100000, 0b00010000, 0b00001000, 0b00000100,
+    0b00000010, 0b00000001, 0b00000010, 0b00000100,
+    0b00001000, 0b00010000, 0b00100000, 0b01000000,
+    0b10000000
+}};
+
+/**
+ * @brief Ensemble des motifs, rangés les uns à la suite des autres en mémoire flash.
+ * 
+ * @note Le tableau est construit par le compilateur en concaténant les animations.
+ */
+constexpr auto ANIMATION_FRAME PROGMEM = concat(
+    ANIMATION_0, ANIMATION_1, ANIMATION_2, ANIMATION_3,
+    ANIMATION_4, ANIMATION_5, ANIMATION_6, ANIMATION_7
+);
+
+/**
+ * @brief Nombre de motifs de chaque animation.
+ */
+constexpr uint16_t ANIMATION_SIZE[] = {
+    ANIMATION_0.size, ANIMATION_1.size, ANIMATION_2.size, ANIMATION_3.size,
+    ANIMATION_4.size, ANIMATION_5.size, ANIMATION_6.size, ANIMATION_7.size
+};
+
+/**
+ * @brief Indice du premier motif d'une animation dans le tableau `ANIMATION_FRAME`.
+ * 
+ * @note Les indices de départ se déduisent des tailles des animations qui
+ *       précèdent : il n'est plus nécessaire de les calculer à la main.
+ */
+constexpr uint16_t animationStart(const uint8_t index) {
+
+    return index == 0 ? 0 : animationStart(index - 1) + ANIMATION_SIZE[index - 1];
+
+}
+
+static_assert(animationStart(NUM_ANIMATIONS) == ANIMATION_FRAME.size, "Chaque animation doit figurer dans ANIMATION_FRAME.");
+
+/**
+ * @brief Définition de la structure de données d'une animation.
+ */
+struct Animation {
+    uint16_t start;          // Indice du motif de départ dans le tableau.
+    uint8_t  frames;         // Nombre de motifs constituant la séquence.
+    uint8_t  frame_delay_ms; // Durée d'affichage de chaque motif exprimée en millisecondes.
+    uint8_t  repeat;         // Nombre de répétitions de la séquence.
+};
+
+/**
+ * @brief Définition des animations périodiques que l'on souhaite enchaîner.
+ */
+const Animation animation[] PROGMEM = {
+//
+//     +------------------------------------------------------ start
+//     |                  +----------------------------------- frames
+//     |                  |                   +--------------- frame_delay_ms
+//     |                  |                   |    +---------- repeat
+//     |                  |                   |    |
+//     v                  v                   v    v
+    { animationStart(0), ANIMATION_SIZE[0],  40,  4 }, // animation #0
+    { animationStart(1), ANIMATION_SIZE[1],  50,  8 }, // animation #1
+    { animationStart(2), ANIMATION_SIZE[2],  50,  5 }, // animation #2
+    { animationStart(3), ANIMATION_SIZE[3],  50,  6 }, // animation #3
+    { animationStart(4), ANIMATION_SIZE[4], 120, 10 }, // animation #4
+    { animationStart(5), ANIMATION_SIZE[5],  80,  8 }, // animation #5
+    { animationStart(6), ANIMATION_SIZE[6],  60,  7 }, // animation #6
+    { animationStart(7), ANIMATION_SIZE[7],  40,  1 }  // animation #7
+};
+
+/**
+ * @brief Définition du séquenceur d'animation.
+ * 
+ * @note Pour faciliter la lecture des animations, nous définissons un séquenceur
+ *       qui va nous permettre de gérer précisément comment doit se dérouler la
+ *       lecture périodique des animations et la gestion des paramètres afférents.
+ */
+struct Player {
+    uint8_t   animation_id; // Indice de l'animation en cours.
+    uint8_t   repeat;       // Nombre de répétitions effectuées.
+    uint8_t   frame;        // Indice du motif binaire relatif à l'animation en cours.
+    uint32_t  last_ms;      // Date du dernier affichage opéré sur la rampe de LEDs.
+    Animation animation;    // Copie en SRAM du descripteur de l'animation en cours.
+};
+
+/**
+ * @brief Initalisation du séquenceur.
+ * 
+ * @note Tous les paramètres sont initialisés à zéro par défaut.
+ */
+Player player = {
+    0, // animation_id
+    0, // repeat
+    0, // frame
+    0, // last_ms
+    {} // animation
+};
+
+// ----------------------------------------------------------------------------
+// Gestion des LEDs
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Initialisation des broches de commande des LEDs.
+ */
+void initLeds() {
+
+    Leds::begin();
+
+}
+
+/**
+ * @brief Affichage d'un motif binaire 8-bits sur le chenillard à 8 LEDs.
+ * 
+ * @param n Entier compris dans l'intervalle [0,255].
+ * 
+ * @note Comme dans l'exercice 05, les registres PORTD et PORTB sont écrits
+ *       directement, chacun en une seule fois, plutôt que LED par LED avec
+ *       digitalWrite().
+ * 
+ *       Le câblage étant connu à la compilation, la classe Chaser effectue
+ *       ce calcul sans boucle ni lecture en table : un décalage et un masque
+ *       par port suffisent lorsque les LEDs sont branchées dans l'ordre.
+ */
+void ledWrite(const Leds::Frame pattern) {
+
+    BENCH_MARK(BENCH_WRITE_BEGIN);
+
+    Leds::write(pattern);
+
+    BENCH_MARK(BENCH_WRITE_END);
+
+}
+
+// ----------------------------------------------------------------------------
+// Lecture des données en mémoire flash
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Lecture d'un motif binaire en mémoire flash.
+ * 
+ * @param index Indice du motif dans le tableau `ANIMATION_FRAME`.
+ */
+uint8_t readFrame(const uint16_t index) {
+
+    return pgm_read_byte(&ANIMATION_FRAME.frame[index]);
+
+}
+
+/**
+ * @brief Lecture du descripteur d'une animation en mémoire flash.
+ * 
+ * @param index      Indice de l'animation (0 ≤ index < NUM_ANIMATIONS).
+ * @param pAnimation Structure de données en SRAM qui reçoit la copie.
+ */
+void readAnimation(const uint8_t index, Animation * const pAnimation) {
+
+    memcpy_P(pAnimation, &animation[index], sizeof(Animation));
+
+}
+
+// ----------------------------------------------------------------------------
+// Gestion des animations
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Lancement d'une animation.
+ * 
+ * @param index Indice de l'animation à lancer (0 ≤ index < NUM_ANIMATIONS)
+ * 
+ * @note On effectue l'initialisation des propriétés du séquenceur avec les données
+ *       de prise en charge de la nouvelle animation qui va démarrer. Le descripteur
+ *       de l'animation est recopié une fois pour toutes depuis la mémoire flash.
+ */
+void startAnimation(const uint8_t index) {
+
+    BENCH_MARK(BENCH_ANIMATION);
+
+    player.animation_id = index;
+    player.repeat       = 0;
+    player.frame        = 0;
+
+    readAnimation(index, &player.animation);
+
+}
+
+/**
+ * @brief Lecture incrémentale de l'animation courante.
+ */
+void playAnimation() {
+
+    BENCH_MARK(BENCH_PLAY_BEGIN);
+
+    // Définition d'un pointeur sur la structure de donnée qui décrit
+    // l'animation courante (la copie détenue par le séquenceur),
+    // permettant d'accéder directement à ses propriétés sans faire
+    // de copie locale.
+    // 
+    // Le mot-clef `const` utilisé 2 fois ici déclare que :
+    //   1. la structure de données pointée est constante,
+    //   2. le pointeur lui-même est de valeur constante,
+    const Animation * const pAnimation = &player.animation;
+
+    // Lecture du motif binaire en cours à afficher sur la rampe de LEDs :
+    const uint8_t frame = readFrame(pAnimation->start + player.frame);
+
+    // Affichage du motif en cours sur la rampe de LEDs :
+    ledWrite(frame);
+
+    // Déplacement de la tête de lecture du séquenceur.
+    // Si l'animation courante n'est pas terminée...
+    if (player.frame + 1 < pAnimation->frames) {
+
+        // Alors on déplace la tête de lecture au prochain motif binaire
+        // de l'animation courante :
+        player.frame++;
+
+    // Sinon, c'est qu'on est arrivé au terme de l'animation courante.
+    } else {
+
+        // Auquel cas, on vérifie si on doit la répéter à nouveau...
+        if (player.repeat + 1 < pAnimation->repeat) {
+
+            // Il faut alors replacer la tête de lecture au début de l'animation :
+            player.frame = 0;
+            // Et incrémenter le nombre de répétitions opérées sur l'animation :
+            player.repeat++;
+
+        // Si l'animation ne devait pas être répétée une nouvelle fois,
+        // c'est que nous devons passer à la prochaine animation...
+        } else {
+
+            // L'indice de la nouvelle animation est donc incrémenté,
+            // et on vérifie également s'il ne faut pas redémarrer
+            // tout le processus à la première animation définie
+            // dans le tableau `ANIMATION_FRAME`, une fois qu'on a
+            // fait le tour de toutes les animations définies.
+            ++player.animation_id %= NUM_ANIMATIONS;
+
+            // Il ne reste plus qu'à lancer la nouvelle animation :
+            startAnimation(player.animation_id);
+
+        }
+
+    }
+
+    BENCH_MARK(BENCH_PLAY_END);
+
+}
+
+// ----------------------------------------------------------------------------
+// Squelette principal du programme
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Démarrage du programme.
+ */
+void setup() {
+
+    initLeds();
+    startAnimation(0);
+    player.last_ms = millis();
+
+}
+
+/**
+ * @brief Boucle de contrôle principale.
+ * 
+ * @note Toujours sans utiliser la fonction delay() !
+ */
+void loop() {
+
+    BENCH_MARK(BENCH_LOOP);
+
+    const uint32_t now = millis();
+
+    // Définition d'un pointeur sur la structure de donnée qui décrit
+    // l'animation courante (la copie détenue par le séquenceur),
+    // permettant d'accéder directement à ses propriétés sans faire
+    // de copie locale.
+    // 
+    // Le mot-clef `const` utilisé 2 fois ici déclare que :
+    //   1. la structure de données pointée est constante,
+    //   2. le pointeur lui-même est de valeur constante,
+    const Animation * const pAnimation = &player.animation;
+
+    if (now - player.last_ms > pAnimation->frame_delay_ms) {
+
+        playAnimation();
+        BENCH_FRAME_PERIOD(player.animation.frame_delay_ms);
+
+        player.last_ms = now;
+
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,409 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Séquenceur d'animations piloté par une interruption du Timer1
+ * -------------------------------------------------------------------------
+ */
+
+#include <Arduino.h>
+#include <Bench.h>
+#include <Chaser.h>
+#include <Frames.h>
+
+// ----------------------------------------------------------------------------
+// Définition des constantes et variables globales
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Rampe de LEDs, décrite par ses broches de commande (de la LED
+ *        d'indice 0 à la LED d'indice 7).
+ * 
+ * @note Les masques des ports et la séquence d'initialisation sont déduits
+ *       du câblage à la compilation (voir lib/Chaser).
+ */
+typedef Chaser<5, 6, 7, 8, 9, 10, 11, 12> Leds;
+
+/**
+ * @brief Nombre de LEDs.
+ */
+const uint8_t NUM_LEDS = Leds::size;
+
+/**
+ * @brief Nombre d'animations prédéfinies dans l'enchaînement proposé.
+ */
+const uint8_t NUM_ANIMATIONS = 8;
+
+/**
+ * @brief Définition des motifs constituant chaque animation.
+ * 
+ * @note Les animations sont celles de l'exercice 10, calculées à la compilation
+ *       par les générateurs définis dans `lib/Frames`.
+ */
+constexpr auto ANIMATION_0 = bounce<1>();            // un point qui rebondit
+constexpr auto ANIMATION_1 = mirror(bounce<1, 4>()); // deux points qui se croisent au centre
+constexpr auto ANIMATION_2 = bounce<3>();            // KITT
+constexpr auto ANIMATION_3 = mirror(fill<4>());      // remplissage depuis le centre
+constexpr auto ANIMATION_4 = alternate(0b01010101);  // clignotement alterné
+constexpr auto ANIMATION_5 = scan<4>(0b00010001);    // deux points qui défilent
+constexpr auto ANIMATION_6 = scan<8>(0b00000001);    // un point qui défile
+
+constexpr Frames<37> ANIMATION_7 = {{
+    0b00000000, 0b00010000, 0b00001000, 0b00010000,
+    0b00100000, 0b00010000, 0b00001000, 0b00000100,
+    0b00001000, 0b00010000, 0b00100000, 0b01000000,
+    0b00100000, 0b00010000, 0b00001000, 0b00000100,
+    0b00000010, 0b00000100, 0b00001000, 0b00010000,
+    0b00100000, 0b01000000, 0b10000000, 0b01000000,
+    0b00100000, 0b00010000, 0b00001000, 0b00000100,
+    0b00000010, 0b00000001, 0b00000010, 0b00000100,
+    0b00001000, 0b00010000, 0b00100000, 0b01000000,
+    0b10000000
+}};
+
+/**
+ * @brief Ensemble des motifs, rangés les uns à la suite des autres en mémoire flash.
+ * 
+ * @note Le tableau est construit par le compilateur en concaténant les animations.
+ */
+constexpr auto ANIMATION_FRAME PROGMEM = concat(
+    ANIMATION_0, ANIMATION_1, ANIMATION_2, ANIMATION_3,
+    ANIMATION_4, ANIMATION_5, ANIMATION_6, ANIMATION_7
+);
+
+/**
+ * @brief Nombre de motifs de chaque animation.
+ */
+constexpr uint16_t ANIMATION_SIZE[] = {
+    ANIMATION_0.size, ANIMATION_1.size, ANIMATION_2.size, ANIMATION_3.size,
+    ANIMATION_4.size, ANIMATION_5.size, ANIMATION_6.size, ANIMATION_7.size
+};
+
+/**
+ * @brief Indice du premier motif d'une animation dans le tableau `ANIMATION_FRAME`.
+ * 
+ * @note Les indices de départ se déduisent des tailles des animations qui
+ *       précèdent : il n'est plus nécessaire de les calculer à la main.
+ */
+constexpr uint16_t animationStart(const uint8_t index) {
+
+    return index == 0 ? 0 : animationStart(index - 1) + ANIMATION_SIZE[index - 1];
+
+}
+
+static_assert(animationStart(NUM_ANIMATIONS) == ANIMATION_FRAME.size, "Chaque animation doit figurer dans ANIMATION_FRAME.");
+
+/**
+ * @brief Définition de la structure de données d'une animation.
+ */
+struct Animation {
+    uint16_t start;          // Indice du motif de départ dans le tableau.
+    uint8_t  frames;         // Nombre de motifs constituant la séquence.
+    uint8_t  frame_delay_ms; // Durée d'affichage de chaque motif exprimée en millisecondes.
+    uint8_t  repeat;         // Nombre de répétitions de la séquence.
+};
+
+/**
+ * @brief Définition des animations périodiques que l'on souhaite enchaîner.
+ */
+const Animation animation[] PROGMEM = {
+//
+//     +------------------------------------------------------ start
+//     |                  +----------------------------------- frames
+//     |                  |                   +--------------- frame_delay_ms
+//     |                  |                   |    +---------- repeat
+//     |                  |                   |    |
+//     v                  v                   v    v
+    { animationStart(0), ANIMATION_SIZE[0],  40,  4 }, // animation #0
+    { animationStart(1), ANIMATION_SIZE[1],  50,  8 }, // animation #1
+    { animationStart(2), ANIMATION_SIZE[2],  50,  5 }, // animation #2
+    { animationStart(3), ANIMATION_SIZE[3],  50,  6 }, // animation #3
+    { animationStart(4), ANIMATION_SIZE[4], 120, 10 }, // animation #4
+    { animationStart(5), ANIMATION_SIZE[5],  80,  8 }, // animation #5
+    { animationStart(6), ANIMATION_SIZE[6],  60,  7 }, // animation #6
+    { animationStart(7), ANIMATION_SIZE[7],  40,  1 }  // animation #7
+};
+
+/**
+ * @brief Définition du séquenceur d'animation.
+ * 
+ * @note Pour faciliter la lecture des animations, nous définissons un séquenceur
+ *       qui va nous permettre de gérer précisément comment doit se dérouler la
+ *       lecture périodique des animations et la gestion des paramètres afférents.
+ */
+struct Player {
+    uint8_t   animation_id; // Indice de l'animation en cours.
+    uint8_t   repeat;       // Nombre de répétitions effectuées.
+    uint8_t   frame;        // Indice du motif binaire relatif à l'animation en cours.
+    uint8_t   pattern;      // Motif à afficher lors de la prochaine interruption.
+    Animation animation;    // Copie en SRAM du descripteur de l'animation en cours.
+};
+
+/**
+ * @brief Initalisation du séquenceur.
+ * 
+ * @note Tous les paramètres sont initialisés à zéro par défaut.
+ * 
+ *       Le séquenceur n'est manipulé que par la routine d'interruption du
+ *       Timer1. Si la boucle principale devait le consulter ou le modifier,
+ *       elle devrait le faire en suspendant les interruptions (cli() ... SREG).
+ */
+Player player = {
+    0, // animation_id
+    0, // repeat
+    0, // frame
+    0, // pattern
+    {} // animation
+};
+
+/**
+ * @brief Nombre de tops du Timer1 par milliseconde.
+ * 
+ * @note Avec un pré-diviseur de 64, le compteur 16 bits du Timer1 progresse
+ *       de 250 tops par milliseconde (4 µs par top) et peut donc mesurer des
+ *       durées allant jusqu'à 262 ms : largement de quoi couvrir les 255 ms
+ *       que peut valoir `frame_delay_ms`.
+ */
+const uint16_t TIMER_TICKS_PER_MS = F_CPU / 64 / 1000;
+
+// ----------------------------------------------------------------------------
+// Gestion des LEDs
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Initialisation des broches de commande des LEDs.
+ */
+void initLeds() {
+
+    Leds::begin();
+
+}
+
+/**
+ * @brief Affichage d'un motif binaire 8-bits sur le chenillard à 8 LEDs.
+ * 
+ * @param n Entier compris dans l'intervalle [0,255].
+ * 
+ * @note Comme dans l'exercice 05, les registres PORTD et PORTB sont écrits
+ *       directement, chacun en une seule fois, plutôt que LED par LED avec
+ *       digitalWrite().
+ * 
+ *       Le câblage étant connu à la compilation, la classe Chaser effectue
+ *       ce calcul sans boucle ni lecture en table : un décalage et un masque
+ *       par port suffisent lorsque les LEDs sont branchées dans l'ordre.
+ */
+void ledWrite(const Leds::Frame pattern) {
+
+    BENCH_MARK(BENCH_WRITE_BEGIN);
+
+    Leds::write(pattern);
+
+    BENCH_MARK(BENCH_WRITE_END);
+
+}
+
+// ----------------------------------------------------------------------------
+// Lecture des données en mémoire flash
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Lecture d'un motif binaire en mémoire flash.
+ * 
+ * @param index Indice du motif dans le tableau `ANIMATION_FRAME`.
+ */
+uint8_t readFrame(const uint16_t index) {
+
+    return pgm_read_byte(&ANIMATION_FRAME.frame[index]);
+
+}
+
+/**
+ * @brief Lecture du descripteur d'une animation en mémoire flash.
+ * 
+ * @param index      Indice de l'animation (0 ≤ index < NUM_ANIMATIONS).
+ * @param pAnimation Structure de données en SRAM qui reçoit la copie.
+ */
+void readAnimation(const uint8_t index, Animation * const pAnimation) {
+
+    memcpy_P(pAnimation, &animation[index], sizeof(Animation));
+
+}
+
+// ----------------------------------------------------------------------------
+// Gestion des animations
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Lancement d'une animation.
+ * 
+ * @param index Indice de l'animation à lancer (0 ≤ index < NUM_ANIMATIONS)
+ * 
+ * @note On effectue l'initialisation des propriétés du séquenceur avec les données
+ *       de prise en charge de la nouvelle animation qui va démarrer. Le descripteur
+ *       de l'animation est recopié une fois pour toutes depuis la mémoire flash.
+ */
+void startAnimation(const uint8_t index) {
+
+    BENCH_MARK(BENCH_ANIMATION);
+
+    player.animation_id = index;
+    player.repeat       = 0;
+    player.frame        = 0;
+
+    readAnimation(index, &player.animation);
+
+}
+
+/**
+ * @brief Lecture incrémentale de l'animation courante.
+ * 
+ * @note Cette fonction est appelée par la routine d'interruption du Timer1.
+ *       Le motif à afficher a été lu à l'appel précédent : il est écrit sur
+ *       les ports dès l'entrée dans la fonction, de sorte que le délai entre
+ *       l'interruption et l'allumage des LEDs reste le même quel que soit le
+ *       motif, y compris lorsqu'une nouvelle animation démarre.
+ * 
+ *       La durée d'affichage de ce motif est programmée dans la foulée, avant
+ *       que la tête de lecture ne passe éventuellement à l'animation suivante.
+ */
+void playAnimation() {
+
+    BENCH_MARK(BENCH_PLAY_BEGIN);
+
+    // Définition d'un pointeur sur la structure de donnée qui décrit
+    // l'animation courante (la copie détenue par le séquenceur),
+    // permettant d'accéder directement à ses propriétés sans faire
+    // de copie locale.
+    // 
+    // Le mot-clef `const` utilisé 2 fois ici déclare que :
+    //   1. la structure de données pointée est constante,
+    //   2. le pointeur lui-même est de valeur constante,
+    const Animation * const pAnimation = &player.animation;
+
+    // Affichage du motif préparé lors de l'appel précédent :
+    ledWrite(player.pattern);
+
+    // Le compteur du Timer1 vient de repartir de zéro : la prochaine
+    // interruption surviendra lorsqu'il aura atteint la valeur de OCR1A,
+    // c'est-à-dire au terme de la durée d'affichage du motif.
+    OCR1A = pAnimation->frame_delay_ms * TIMER_TICKS_PER_MS - 1;
+    BENCH_FRAME_PERIOD(pAnimation->frame_delay_ms);
+
+    // Déplacement de la tête de lecture du séquenceur.
+    // Si l'animation courante n'est pas terminée...
+    if (player.frame + 1 < pAnimation->frames) {
+
+        // Alors on déplace la tête de lecture au prochain motif binaire
+        // de l'animation courante :
+        player.frame++;
+
+    // Sinon, c'est qu'on est arrivé au terme de l'animation courante.
+    } else {
+
+        // Auquel cas, on vérifie si on doit la répéter à nouveau...
+        if (player.repeat + 1 < pAnimation->repeat) {
+
+            // Il faut alors replacer la tête de lecture au début de l'animation :
+            player.frame = 0;
+            // Et incrémenter le nombre de répétitions opérées sur l'animation :
+            player.repeat++;
+
+        // Si l'animation ne devait pas être répétée une nouvelle fois,
+        // c'est que nous devons passer à la prochaine animation...
+        } else {
+
+            // L'indice de la nouvelle animation est donc incrémenté,
+            // et on vérifie également s'il ne faut pas redémarrer
+            // tout le processus à la première animation définie
+            // dans le tableau `ANIMATION_FRAME`, une fois qu'on a
+            // fait le tour de toutes les animations définies.
+            ++player.animation_id %= NUM_ANIMATIONS;
+
+            // Il ne reste plus qu'à lancer la nouvelle animation :
+            startAnimation(player.animation_id);
+
+        }
+
+    }
+
+    // Lecture du prochain motif à afficher, en dehors du chemin critique :
+    player.pattern = readFrame(pAnimation->start + player.frame);
+
+    BENCH_MARK(BENCH_PLAY_END);
+
+}
+
+// ----------------------------------------------------------------------------
+// Cadencement par le Timer1
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Configuration du Timer1 en mode CTC (Clear Timer on Compare match).
+ * 
+ * @note Dans ce mode, le compteur TCNT1 est remis à zéro dès qu'il atteint la
+ *       valeur du registre OCR1A, et l'interruption TIMER1_COMPA est déclenchée.
+ *       C'est donc le matériel qui mesure la durée d'affichage de chaque motif :
+ *       les fronts des LEDs ne dépendent plus de ce que fait la boucle principale,
+ *       et leur gigue se limite à la latence de prise en charge de l'interruption
+ *       (quelques microsecondes).
+ * 
+ *       Le framework Arduino configure le Timer1 en mode PWM pour analogWrite()
+ *       sur les broches D9 et D10 : on écrase entièrement cette configuration.
+ *       La fonction analogWrite() ne doit donc plus être utilisée sur ces broches.
+ */
+void initTimer() {
+
+    noInterrupts();
+
+    TCCR1A = 0;                                       // sorties OC1A et OC1B déconnectées
+    TCCR1B = _BV(WGM12) | _BV(CS11) | _BV(CS10);      // mode CTC, pré-diviseur 64
+    TCNT1  = 0;
+    OCR1A  = 0;                                       // premier motif affiché au prochain top
+    TIMSK1 = _BV(OCIE1A);                             // interruption de comparaison A
+
+    interrupts();
+
+}
+
+/**
+ * @brief Routine d'interruption du Timer1 : affichage du motif suivant.
+ */
+ISR(TIMER1_COMPA_vect) {
+
+    playAnimation();
+
+}
+
+// ----------------------------------------------------------------------------
+// Squelette principal du programme
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Démarrage du programme.
+ */
+void setup() {
+
+    initLeds();
+    startAnimation(0);
+    player.pattern = readFrame(player.animation.start);
+    initTimer();
+
+}
+
+/**
+ * @brief Boucle de contrôle principale.
+ * 
+ * @note L'animation se déroule entièrement sous interruption : la boucle
+ *       principale est libre pour la lecture des entrées, les communications,
+ *       etc. Elle peut même bloquer (avec delay() par exemple) sans affecter
+ *       le rythme des animations.
+ */
+void loop() {
+
+    BENCH_MARK(BENCH_LOOP);
+
+}
\ No newline at end of file
@@ -0,0 +1,357 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Modulation BCM : animation KITT en niveaux de gris
+ * -------------------------------------------------------------------------
+ */
+
+#include <Arduino.h>
+#include <Bench.h>
+#include <Chaser.h>
+#include <Scheduler.h>
+
+// ----------------------------------------------------------------------------
+// Définition des constantes et variables globales
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Rampe de LEDs, décrite par ses broches de commande (de la LED
+ *        d'indice 0 à la LED d'indice 7).
+ * 
+ * @note Les masques des ports et la séquence d'initialisation sont déduits
+ *       du câblage à la compilation (voir lib/Chaser).
+ */
+typedef Chaser<5, 6, 7, 8, 9, 10, 11, 12> Leds;
+
+/**
+ * @brief Nombre de LEDs.
+ */
+const uint8_t NUM_LEDS = Leds::size;
+
+/**
+ * @brief Nombre de bits de la luminosité de chaque LED (256 niveaux).
+ */
+const uint8_t BCM_BITS = 8;
+
+/**
+ * @brief Durée d'affichage du plan de poids faible, en tops du Timer1.
+ * 
+ * @note Avec un pré-diviseur de 8, le Timer1 progresse d'un top toutes les
+ *       0,5 µs. Le plan de poids faible est donc affiché pendant 20 µs, et le
+ *       plan de poids `k` pendant 20 µs × 2^k : l'ensemble des 8 plans est
+ *       balayé en 255 × 20 µs = 5,1 ms, soit un rafraîchissement à 196 Hz,
+ *       bien au-delà du seuil de perception du scintillement.
+ * 
+ *       La routine d'interruption doit impérativement se terminer avant la
+ *       fin du plan le plus court : 20 µs, soit 320 cycles d'horloge, alors
+ *       qu'elle n'en consomme qu'une soixantaine (prologue compris).
+ */
+const uint16_t BCM_UNIT_TICKS = 40;
+
+static_assert((uint32_t(BCM_UNIT_TICKS) << (BCM_BITS - 1)) <= 0x10000, "Le plan de poids fort dépasse la capacité du Timer1.");
+
+/**
+ * @brief Correction gamma (γ = 2,2) des niveaux de luminosité.
+ * 
+ * @note L'oeil perçoit la luminosité de façon logarithmique : une LED
+ *       alimentée la moitié du temps paraît presque aussi lumineuse qu'une
+ *       LED allumée en permanence. La table convertit un niveau perçu
+ *       (de 0 à 255) en durée d'allumage, de sorte que les niveaux
+ *       intermédiaires s'enchaînent régulièrement à l'oeil.
+ */
+const uint8_t GAMMA[] PROGMEM = {
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+      3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+      6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+     12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,
+     20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29,
+     30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41,
+     42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55,
+     56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,
+     73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90,
+     91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+    113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+    137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+    163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+    192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+    223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255
+};
+
+/**
+ * @brief Plans binaires d'une image en niveaux de gris.
+ * 
+ * @note La modulation BCM (Binary Code Modulation) décompose le niveau de
+ *       chaque LED en ses 8 bits : le plan `k` réunit le bit `k` des niveaux
+ *       des 8 LEDs, et il est affiché pendant une durée proportionnelle à 2^k.
+ *       Sur un rafraîchissement complet, chaque LED reste donc allumée pendant
+ *       une durée exactement proportionnelle à son niveau.
+ * 
+ *       Là où une modulation PWM logicielle à 256 niveaux réclamerait 255
+ *       interruptions par rafraîchissement, la modulation BCM n'en demande
+ *       que 8. Chaque plan est stocké sous la forme des valeurs à écrire dans
+ *       les registres PORTD et PORTB, calculées à l'avance : la routine
+ *       d'interruption n'a plus qu'à les recopier.
+ */
+struct Planes {
+    uint8_t portd[BCM_BITS]; // Bits du port D de chaque plan.
+    uint8_t portb[BCM_BITS]; // Bits du port B de chaque plan.
+};
+
+/**
+ * @brief Moteur d'affichage BCM.
+ * 
+ * @note Les plans sont gérés en double tampon : la routine d'interruption
+ *       affiche le tampon `front`, pendant que la boucle principale prépare
+ *       l'image suivante dans l'autre tampon. L'échange des tampons n'a lieu
+ *       qu'au début d'un rafraîchissement, pour que chaque rafraîchissement
+ *       affiche une seule et même image.
+ */
+struct Bcm {
+    Planes           planes[2]; // Les deux tampons.
+    volatile uint8_t front;     // Indice du tampon affiché.
+    volatile bool    pending;   // Une nouvelle image attend d'être affichée.
+    uint8_t          plane;     // Indice du prochain plan à afficher.
+};
+
+/**
+ * @brief Initialisation du moteur d'affichage.
+ * 
+ * @note Tous les paramètres sont initialisés à zéro par défaut : toutes les
+ *       LEDs sont éteintes.
+ */
+Bcm bcm = {
+    {},    // planes
+    0,     // front
+    false, // pending
+    0      // plane
+};
+
+/**
+ * @brief Nombre de positions parcourues par la tête de l'animation KITT,
+ *        dans un sens puis dans l'autre.
+ */
+const uint8_t KITT_STEPS = 2 * (NUM_LEDS - 1);
+
+/**
+ * @brief Durée d'une étape de l'animation.
+ */
+const uint8_t KITT_STEP_MS = 70;
+
+/**
+ * @brief État de l'animation KITT.
+ */
+struct Kitt {
+    uint8_t  step;            // Étape courante.
+    uint8_t  level[NUM_LEDS]; // Luminosité perçue de chaque LED.
+    Deadline deadline;        // Date de la prochaine étape.
+};
+
+Kitt kitt = {
+    0,  // step
+    {}, // level
+    {}  // deadline
+};
+
+// ----------------------------------------------------------------------------
+// Gestion des LEDs
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Initialisation des broches de commande des LEDs.
+ */
+void initLeds() {
+
+    Leds::begin();
+
+}
+
+/**
+ * @brief Valeurs des bits des ports D et B qui affichent un motif binaire.
+ * 
+ * @param pattern Motif binaire (le bit `i` commande la LED d'indice `i`).
+ * @param portd   Bits du port D à écrire.
+ * @param portb   Bits du port B à écrire.
+ */
+void patternToPorts(const Leds::Frame pattern, uint8_t &portd, uint8_t &portb) {
+
+    portd = Leds::portD(pattern);
+    portb = Leds::portB(pattern);
+
+}
+
+// ----------------------------------------------------------------------------
+// Modulation BCM
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Configuration du Timer1 en mode CTC, avec un pré-diviseur de 8.
+ * 
+ * @note Le framework Arduino configure le Timer1 en mode PWM pour analogWrite()
+ *       sur les broches D9 et D10 : on écrase entièrement cette configuration.
+ */
+void initBcm() {
+
+    noInterrupts();
+
+    TCCR1A = 0;                          // sorties OC1A et OC1B déconnectées
+    TCCR1B = _BV(WGM12) | _BV(CS11);     // mode CTC, pré-diviseur 8
+    TCNT1  = 0;
+    OCR1A  = BCM_UNIT_TICKS - 1;
+    TIMSK1 = _BV(OCIE1A);                // interruption de comparaison A
+
+    interrupts();
+
+}
+
+/**
+ * @brief Affichage d'une image en niveaux de gris.
+ * 
+ * @param level Luminosité perçue de chaque LED (de 0 à 255).
+ * 
+ * @note Les niveaux sont corrigés par la table `GAMMA`, puis décomposés en
+ *       plans binaires dans le tampon qui n'est pas affiché. L'image sera
+ *       affichée au début du prochain rafraîchissement, dans 5,1 ms au plus.
+ */
+void bcmWrite(const uint8_t level[NUM_LEDS]) {
+
+    BENCH_MARK(BENCH_PLAY_BEGIN);
+
+    // Tant que ce drapeau est baissé, la routine d'interruption n'échange pas
+    // les tampons : on peut donc préparer l'image en toute sécurité.
+    bcm.pending = false;
+
+    Planes * const back = &bcm.planes[bcm.front ^ 1];
+
+    uint8_t duty[NUM_LEDS];
+
+    for (uint8_t i=0; i<NUM_LEDS; i++) {
+        duty[i] = pgm_read_byte(&GAMMA[level[i]]);
+    }
+
+    // Transposition : le plan `k` rassemble le bit `k` de chaque LED.
+    for (uint8_t k=0; k<BCM_BITS; k++) {
+
+        uint8_t pattern = 0;
+
+        for (uint8_t i=0; i<NUM_LEDS; i++) {
+            pattern |= ((duty[i] >> k) & 0x1) << i;
+        }
+
+        patternToPorts(pattern, back->portd[k], back->portb[k]);
+
+    }
+
+    bcm.pending = true;
+
+    BENCH_MARK(BENCH_PLAY_END);
+
+}
+
+/**
+ * @brief Routine d'interruption du Timer1 : affichage du plan suivant.
+ * 
+ * @note Le compteur du Timer1 vient de repartir de zéro. On affiche le plan
+ *       `k` et on programme la prochaine interruption 2^k unités plus tard.
+ *       Le traitement ne comporte aucune boucle : sa durée est la même quel
+ *       que soit le plan ou l'image affichée.
+ */
+ISR(TIMER1_COMPA_vect) {
+
+    BENCH_MARK(BENCH_WRITE_BEGIN);
+
+    const uint8_t k = bcm.plane;
+    const Planes * const front = &bcm.planes[bcm.front];
+
+    PORTD = (PORTD & ~Leds::PORTD_MASK) | front->portd[k];
+    PORTB = (PORTB & ~Leds::PORTB_MASK) | front->portb[k];
+
+    OCR1A = (BCM_UNIT_TICKS << k) - 1;
+
+    // Au terme du plan de poids fort, un nouveau rafraîchissement commence :
+    // c'est le moment d'afficher la nouvelle image, s'il y en a une.
+    bcm.plane = (k + 1) & (BCM_BITS - 1);
+
+    if (bcm.plane == 0 && bcm.pending) {
+        bcm.front  ^= 1;
+        bcm.pending = false;
+    }
+
+    BENCH_MARK(BENCH_WRITE_END);
+
+}
+
+// ----------------------------------------------------------------------------
+// Animation KITT
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Étape suivante de l'animation KITT.
+ * 
+ * @note La tête parcourt la rampe d'un bout à l'autre, à pleine luminosité.
+ *       Les LEDs qu'elle quitte ne s'éteignent pas brusquement : leur
+ *       luminosité est divisée par deux à chaque étape, ce qui dessine une
+ *       traînée qui s'estompe progressivement derrière la tête.
+ */
+void playKitt() {
+
+    for (uint8_t i=0; i<NUM_LEDS; i++) {
+        kitt.level[i] >>= 1;
+    }
+
+    // Position de la tête : du bit 7 au bit 0, puis retour.
+    const uint8_t head = kitt.step < NUM_LEDS
+        ? NUM_LEDS - 1 - kitt.step
+        : kitt.step - (NUM_LEDS - 1);
+
+    kitt.level[head] = 255;
+
+    bcmWrite(kitt.level);
+
+    ++kitt.step %= KITT_STEPS;
+
+}
+
+// ----------------------------------------------------------------------------
+// Squelette principal du programme
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Démarrage du programme.
+ */
+void setup() {
+
+    initLeds();
+    initBcm();
+    deadlineStart(kitt.deadline, millis(), 0);
+
+}
+
+/**
+ * @brief Boucle de contrôle principale.
+ * 
+ * @note La modulation BCM se déroule entièrement sous interruption : la boucle
+ *       principale se contente de calculer une nouvelle image à chaque étape
+ *       de l'animation.
+ */
+void loop() {
+
+    BENCH_MARK(BENCH_LOOP);
+
+    const uint32_t now = millis();
+
+    if (deadlineReached(kitt.deadline, now)) {
+
+        playKitt();
+        BENCH_FRAME_PERIOD(KITT_STEP_MS);
+
+        deadlineAdvance(kitt.deadline, now, KITT_STEP_MS);
+
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,329 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Lecture d'un flux de motifs reçu en direct sur la liaison série
+ * -------------------------------------------------------------------------
+ */
+
+#include <Arduino.h>
+#include <Bench.h>
+#include <Chaser.h>
+#include <RingBuffer.h>
+#include <Scheduler.h>
+
+// ----------------------------------------------------------------------------
+// Définition des constantes et variables globales
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Rampe de LEDs, décrite par ses broches de commande (de la LED
+ *        d'indice 0 à la LED d'indice 7).
+ * 
+ * @note Les masques des ports et la séquence d'initialisation sont déduits
+ *       du câblage à la compilation (voir lib/Chaser).
+ */
+typedef Chaser<5, 6, 7, 8, 9, 10, 11, 12> Leds;
+
+/**
+ * @brief Nombre de LEDs.
+ */
+const uint8_t NUM_LEDS = Leds::size;
+
+/**
+ * @brief Débit de la liaison série (bits par seconde).
+ * 
+ * @note À 16 MHz, le débit de 1 Mbit/s s'obtient sans aucune erreur en mode
+ *       double vitesse (U2X0) : UBRR0 = 16 MHz / (8 × 1 Mbit/s) - 1 = 1.
+ *       La liaison transporte alors jusqu'à 100 000 octets par seconde.
+ */
+const uint32_t SERIAL_BAUD = 1000000;
+
+/**
+ * @brief Cadence d'affichage des motifs reçus (motifs par seconde).
+ * 
+ * @note Chaque octet reçu est un motif binaire, affiché tel quel sur la rampe.
+ *       L'hôte doit émettre les motifs exactement à cette cadence.
+ */
+const uint16_t STREAM_RATE_HZ = 4000;
+
+/**
+ * @brief Nombre de motifs à accumuler avant de démarrer (ou de reprendre)
+ *        l'affichage.
+ * 
+ * @note L'horloge de l'hôte et celle de la carte ne battent jamais exactement
+ *       à la même cadence, et les octets arrivent par paquets au gré du pilote
+ *       USB. Une réserve d'une demi-file (16 ms à 4 kHz) absorbe ces écarts.
+ */
+const uint8_t STREAM_PREFILL = 64;
+
+/**
+ * @brief Flux de motifs reçu sur la liaison série.
+ * 
+ * @note La file est alimentée par la routine d'interruption de réception de
+ *       l'USART, et vidée par la routine d'interruption du Timer1 : un seul
+ *       producteur, un seul consommateur, aucun verrou.
+ * 
+ *       Les compteurs ne sont modifiés que par les routines d'interruption.
+ *       La boucle principale doit suspendre les interruptions pour les lire,
+ *       car un entier de 32 bits ne se lit pas en une seule instruction.
+ */
+struct Stream {
+    RingBuffer<128> frames;    // Motifs reçus, en attente d'affichage.
+    bool            started;   // La réserve initiale a été constituée.
+    bool            playing;   // Les motifs sont en cours d'affichage.
+    uint32_t        underruns; // Motifs manquants au moment de l'affichage.
+    uint32_t        overruns;  // Octets perdus à la réception.
+};
+
+/**
+ * @brief Initialisation du flux.
+ * 
+ * @note Tous les paramètres sont initialisés à zéro par défaut.
+ */
+Stream stream = {
+    {},    // frames
+    false, // started
+    false, // playing
+    0,     // underruns
+    0      // overruns
+};
+
+/**
+ * @brief Période d'envoi du bilan sur la liaison série.
+ */
+const uint16_t REPORT_PERIOD_MS = 1000;
+
+/**
+ * @brief Date du prochain envoi du bilan.
+ */
+Deadline report = {};
+
+// ----------------------------------------------------------------------------
+// Gestion des LEDs
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Initialisation des broches de commande des LEDs.
+ */
+void initLeds() {
+
+    Leds::begin();
+
+}
+
+/**
+ * @brief Affichage d'un motif binaire 8-bits sur le chenillard à 8 LEDs.
+ * 
+ * @param n Entier compris dans l'intervalle [0,255].
+ * 
+ * @note Comme dans l'exercice 05, les registres PORTD et PORTB sont écrits
+ *       directement, chacun en une seule fois, plutôt que LED par LED avec
+ *       digitalWrite().
+ * 
+ *       Le câblage étant connu à la compilation, la classe Chaser effectue
+ *       ce calcul sans boucle ni lecture en table : un décalage et un masque
+ *       par port suffisent lorsque les LEDs sont branchées dans l'ordre.
+ */
+void ledWrite(const Leds::Frame pattern) {
+
+    BENCH_MARK(BENCH_WRITE_BEGIN);
+
+    Leds::write(pattern);
+
+    BENCH_MARK(BENCH_WRITE_END);
+
+}
+
+// ----------------------------------------------------------------------------
+// Liaison série
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Configuration de l'USART : 8 bits de données, sans parité, 1 bit de
+ *        stop, avec interruption à la réception de chaque octet.
+ * 
+ * @note L'objet `Serial` du framework Arduino définit sa propre routine
+ *       d'interruption de réception : il ne doit donc pas être utilisé ici.
+ */
+void initSerial() {
+
+    UBRR0  = F_CPU / 8 / SERIAL_BAUD - 1;
+    UCSR0A = _BV(U2X0);                               // double vitesse
+    UCSR0C = _BV(UCSZ01) | _BV(UCSZ00);               // 8N1
+    UCSR0B = _BV(RXEN0) | _BV(TXEN0) | _BV(RXCIE0);   // réception, émission, interruption
+
+}
+
+/**
+ * @brief Routine d'interruption de réception : chaque octet reçu est rangé
+ *        dans la file.
+ * 
+ * @note Le registre d'état doit être lu avant le registre de données, dont
+ *       la lecture efface le drapeau DOR0. Ce drapeau signale qu'un octet a
+ *       été perdu par le récepteur lui-même, faute d'avoir été lu à temps.
+ */
+ISR(USART_RX_vect) {
+
+    const uint8_t status = UCSR0A;
+    const uint8_t frame  = UDR0;
+
+    if (status & _BV(DOR0))         stream.overruns++;
+    if (!stream.frames.push(frame)) stream.overruns++;
+
+}
+
+/**
+ * @brief Émission d'un octet (attente active).
+ */
+void serialWrite(const uint8_t c) {
+
+    while (!(UCSR0A & _BV(UDRE0)));
+    UDR0 = c;
+
+}
+
+/**
+ * @brief Émission d'une chaîne de caractères.
+ */
+void serialPrint(const char *s) {
+
+    while (*s) serialWrite(*s++);
+
+}
+
+/**
+ * @brief Émission d'un entier non signé, en base 10.
+ */
+void serialPrint(uint32_t n) {
+
+    char digits[10];
+    uint8_t i = 0;
+
+    do {
+        digits[i++] = '0' + n % 10;
+        n /= 10;
+    } while (n);
+
+    while (i) serialWrite(digits[--i]);
+
+}
+
+// ----------------------------------------------------------------------------
+// Cadencement par le Timer1
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Configuration du Timer1 en mode CTC, à la cadence STREAM_RATE_HZ.
+ * 
+ * @note Avec un pré-diviseur de 8, le Timer1 progresse de 2 000 000 de tops
+ *       par seconde : OCR1A = 2 000 000 / 4 000 - 1 = 499.
+ */
+void initTimer() {
+
+    noInterrupts();
+
+    TCCR1A = 0;                          // sorties OC1A et OC1B déconnectées
+    TCCR1B = _BV(WGM12) | _BV(CS11);     // mode CTC, pré-diviseur 8
+    TCNT1  = 0;
+    OCR1A  = F_CPU / 8 / STREAM_RATE_HZ - 1;
+    TIMSK1 = _BV(OCIE1A);                // interruption de comparaison A
+
+    interrupts();
+
+}
+
+/**
+ * @brief Routine d'interruption du Timer1 : affichage du motif suivant.
+ * 
+ * @note Lorsque la file est vide, le dernier motif reste affiché et le motif
+ *       manquant est comptabilisé. L'affichage ne reprend qu'une fois la
+ *       réserve reconstituée, et chaque motif manquant entre-temps est lui
+ *       aussi comptabilisé.
+ */
+ISR(TIMER1_COMPA_vect) {
+
+    BENCH_MARK(BENCH_PLAY_BEGIN);
+
+    if (!stream.playing) {
+
+        if (stream.frames.size() < STREAM_PREFILL) {
+            if (stream.started) stream.underruns++;
+            BENCH_MARK(BENCH_PLAY_END);
+            return;
+        }
+
+        stream.started = true;
+        stream.playing = true;
+
+    }
+
+    uint8_t frame;
+
+    if (stream.frames.pop(frame)) {
+        ledWrite(frame);
+    } else {
+        stream.underruns++;
+        stream.playing = false;
+    }
+
+    BENCH_MARK(BENCH_PLAY_END);
+
+}
+
+// ----------------------------------------------------------------------------
+// Squelette principal du programme
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Démarrage du programme.
+ */
+void setup() {
+
+    initLeds();
+    initSerial();
+    initTimer();
+    deadlineStart(report, millis(), REPORT_PERIOD_MS);
+
+}
+
+/**
+ * @brief Boucle de contrôle principale.
+ * 
+ * @note La réception et l'affichage des motifs se déroulent entièrement sous
+ *       interruption. La boucle principale se contente d'envoyer à l'hôte,
+ *       chaque seconde, un bilan de la forme :
+ * 
+ *           underruns=0 overruns=0 fill=64
+ */
+void loop() {
+
+    BENCH_MARK(BENCH_LOOP);
+
+    const uint32_t now = millis();
+
+    if (deadlineReached(report, now)) {
+
+        const uint8_t sreg = SREG;
+        cli();
+        const uint32_t underruns = stream.underruns;
+        const uint32_t overruns  = stream.overruns;
+        SREG = sreg;
+
+        serialPrint("underruns=");
+        serialPrint(underruns);
+        serialPrint(" overruns=");
+        serialPrint(overruns);
+        serialPrint(" fill=");
+        serialPrint(stream.frames.size());
+        serialPrint("\r\n");
+
+        deadlineAdvance(report, now, REPORT_PERIOD_MS, SKIP);
+
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,1007 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Téléversement d'un spectacle en EEPROM et bascule à chaud
+ * -------------------------------------------------------------------------
+ */
+
+#include <Arduino.h>
+#include <avr/eeprom.h>
+#include <Bench.h>
+#include <Chaser.h>
+#include <RingBuffer.h>
+#include <Scheduler.h>
+#include <Transition.h>
+
+// ----------------------------------------------------------------------------
+// Définition des constantes et variables globales
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Rampe de LEDs, décrite par ses broches de commande (de la LED
+ *        d'indice 0 à la LED d'indice 7).
+ * 
+ * @note Les masques des ports et la séquence d'initialisation sont déduits
+ *       du câblage à la compilation (voir lib/Chaser).
+ */
+typedef Chaser<5, 6, 7, 8, 9, 10, 11, 12> Leds;
+
+/**
+ * @brief Nombre de LEDs.
+ */
+const uint8_t NUM_LEDS = Leds::size;
+
+/**
+ * @brief Nombre d'animations du spectacle intégré au firmware.
+ * 
+ * @note Ce spectacle, celui de l'exercice 08, est joué tant qu'aucun autre
+ *       spectacle n'a été téléversé en EEPROM.
+ */
+const uint8_t NUM_ANIMATIONS = 8;
+
+/**
+ * @brief Définition des motifs constituant chaque animation.
+ * 
+ * @note Chaque animation est définie par une séquence ordonnée de motifs
+ *       binaires (décrits par des entiers codés sur 8 bits), ainsi que par
+ *       un nombre fini de motifs, qui correspond en définitive à la longueur
+ *       de la séquence qui décrit l'animation.
+ *       
+ *       Chaque motif peut être considéré comme une image instantanée de
+ *       l'animation qu'elle participe à décrire. On parlera également de
+ *       "frame" pour reprendre un anglicisme usuel.
+ *       
+ *       On fait ici le choix de définir au sein d'un même tableau l'ensemble
+ *       des animations que nous allons enchaîner les unes après les autres.
+ * 
+ *       Le mot-clef PROGMEM demande au compilateur de laisser le tableau en
+ *       mémoire flash. Sans lui, toute donnée constante est recopiée au
+ *       démarrage dans les 2 Ko de mémoire vive (SRAM) du micro-contrôleur.
+ *       En contrepartie, le tableau ne peut plus être lu directement : il
+ *       faut passer par la fonction readFrame() définie plus bas.
+ */
+const uint8_t ANIMATION_FRAME[] PROGMEM = {
+    
+    // animation #0
+
+    0b10000000, //
+    0b01000000, //
+    0b00100000, //
+    0b00010000, //
+    0b00001000, //
+    0b00000100, //
+    0b00000010, // 14 frames
+    0b00000001, //
+    0b00000010, //
+    0b00000100, //
+    0b00001000, //
+    0b00010000, //
+    0b00100000, //
+    0b01000000, //
+
+    // animation #1
+
+    0b10000001, //
+    0b01000010, //
+    0b00100100, // 6 frames
+    0b00011000, //
+    0b00100100, //
+    0b01000010, //
+
+    // animation #2
+
+    0b11100000, //
+    0b01110000, //
+    0b00111000, //
+    0b00011100, //
+    0b00001110, // 10 frames
+    0b00000111, //
+    0b00001110, //
+    0b00011100, //
+    0b00111000, //
+    0b01110000, //
+
+    // animation #3
+
+    0b00000000, //
+    0b00011000, //
+    0b00111100, //
+    0b01111110, // 8 frames
+    0b11111111, //
+    0b01111110, //
+    0b00111100, //
+    0b00011000, //
+
+    // animation #4
+
+    0b01010101,// 2 frames
+    0b10101010,// 
+
+    // animation #5
+
+    0b00010001, //
+    0b00100010, // 4 frames
+    0b01000100, //
+    0b10001000, //
+
+    // animation #6
+
+    0b00000001, //
+    0b00000010, //
+    0b00000100, //
+    0b00001000, // 8 frames
+    0b00010000, //
+    0b00100000, //
+    0b01000000, //
+    0b10000000, //
+
+    // animation #7
+
+    0b00000000, //
+    0b00010000, //
+    0b00001000, //
+    0b00010000, //
+    0b00100000, //
+    0b00010000, //
+    0b00001000, //
+    0b00000100, //
+    0b00001000, //
+    0b00010000, //
+    0b00100000, //
+    0b01000000, //
+    0b00100000, //
+    0b00010000, //
+    0b00001000, //
+    0b00000100, //
+    0b00000010, //
+    0b00000100, // 37 frames
+    0b00001000, //
+    0b00010000, //
+    0b00100000, //
+    0b01000000, //
+    0b10000000, //
+    0b01000000, //
+    0b00100000, //
+    0b00010000, //
+    0b00001000, //
+    0b00000100, //
+    0b00000010, //
+    0b00000001, //
+    0b00000010, //
+    0b00000100, //
+    0b00001000, //
+    0b00010000, //
+    0b00100000, //
+    0b01000000, //
+    0b10000000  //
+
+};
+
+/**
+ * @brief Définition de la structure de données d'une animation.
+ * 
+ * @note Pour caractériser précisément chaque animation comme une séquence
+ *       périodique de frames (définies par ailleurs dans le tableau précédent),
+ *       on crée une structure de données générique pour les décrire toutes :
+ */
+struct Animation {
+    uint16_t   start;          // Indice du motif de départ dans le tableau.
+    uint8_t    frames;         // Nombre de motifs constituant la séquence.
+    uint8_t    frame_delay_ms; // Durée d'affichage de chaque motif exprimée en millisecondes.
+    uint8_t    repeat;         // Nombre de répétitions de la séquence.
+    Transition transition;     // Transition qui amène cette animation (voir lib/Transition).
+};
+
+/**
+ * @brief Définition des animations périodiques que l'on souhaite enchaîner.
+ * 
+ * @note Maintenant que nous avons défini la structure générique commune à toutes
+ *       les animations, il ne nous reste plus qu'à définir concrètement chacune
+ *       d'entre elles :
+ * 
+ *       Comme les motifs, ces descripteurs sont conservés en mémoire flash.
+ */
+const Animation animation[] PROGMEM = {
+//
+//     +------------------------------- start
+//     |   +--------------------------- frames
+//     |   |    +---------------------- frame_delay_ms
+//     |   |    |   +------------------ repeat
+//     |   |    |   |   +-------------- transition
+//     |   |    |   |   |
+//     v   v    v   v   v
+    {  0, 14,  40,  4, DISSOLVE   }, // animation #0
+    { 14,  6,  50,  8, WIPE_OUT   }, // animation #1
+    { 20, 10,  50,  5, SLIDE_DOWN }, // animation #2
+    { 30,  8,  50,  6, WIPE_OUT   }, // animation #3
+    { 38,  2, 120, 10, DISSOLVE   }, // animation #4
+    { 40,  4,  80,  8, WIPE_UP    }, // animation #5
+    { 44,  8,  60,  7, SLIDE_UP   }, // animation #6
+    { 52, 37,  40,  1, WIPE_DOWN  }  // animation #7
+};
+
+/**
+ * @brief Définition du séquenceur d'animation.
+ * 
+ * @note Pour faciliter la lecture des animations, nous définissons un séquenceur
+ *       qui va nous permettre de gérer précisément comment doit se dérouler la
+ *       lecture périodique des animations et la gestion des paramètres afférents.
+ */
+struct Player {
+    uint8_t   animation_id; // Indice de l'animation en cours.
+    uint8_t   repeat;       // Nombre de répétitions effectuées.
+    uint8_t   frame;        // Indice du motif binaire relatif à l'animation en cours.
+    Deadline  deadline;     // Date à laquelle le prochain motif doit être affiché.
+    Animation animation;    // Copie en SRAM du descripteur de l'animation en cours.
+    uint8_t   step;         // Étape de la transition en cours (TRANSITION_STEPS si aucune).
+    uint8_t   last;         // Dernier motif affiché par l'animation précédente.
+};
+
+/**
+ * @brief Initalisation du séquenceur.
+ * 
+ * @note Tous les paramètres sont initialisés à zéro par défaut.
+ */
+Player player = {
+    0,                // animation_id
+    0,                // repeat
+    0,                // frame
+    {},               // deadline
+    {},               // animation
+    TRANSITION_STEPS, // step
+    0                 // last
+};
+
+/**
+ * @brief Capacités maximales d'un spectacle.
+ */
+const uint8_t  MAX_ANIMATIONS = 16;
+const uint16_t MAX_FRAMES     = 384;
+
+/**
+ * @brief Spectacle en cours, recopié en SRAM.
+ * 
+ * @note Que le spectacle provienne de la mémoire flash (spectacle intégré) ou
+ *       de l'EEPROM (spectacle téléversé), il est recopié ici au moment où il
+ *       démarre. Le séquenceur ne lit donc jamais l'EEPROM pendant la lecture
+ *       du spectacle : l'écriture d'un octet en EEPROM, qui occupe la mémoire
+ *       pendant 3,3 ms, ne peut pas retarder l'affichage d'un motif.
+ * 
+ *       Cette copie occupe 483 octets de SRAM.
+ */
+struct Show {
+    uint8_t   animations;                // Nombre d'animations.
+    uint16_t  frames;                    // Nombre de motifs.
+    Animation animation[MAX_ANIMATIONS]; // Descripteurs des animations.
+    uint8_t   frame[MAX_FRAMES];         // Motifs de toutes les animations.
+};
+
+Show show;
+
+/**
+ * @brief Organisation de l'EEPROM (1 Ko).
+ * 
+ * @note L'EEPROM comporte deux emplacements de spectacle. Le nouveau spectacle
+ *       est toujours écrit dans l'emplacement qui n'est pas en cours
+ *       d'utilisation : en cas d'interruption du téléversement, le spectacle
+ *       actif reste intact.
+ * 
+ *       Adresse 0 : emplacement actif (0 ou 1, 0xff si aucun).
+ * 
+ *       Chaque emplacement commence par la taille (2 octets) et la somme de
+ *       contrôle CRC-16 (2 octets) de l'image qu'il contient, suivies de
+ *       l'image elle-même :
+ * 
+ *           uint8_t   nombre d'animations
+ *           uint16_t  nombre de motifs
+ *           6 octets  par animation (start, frames, frame_delay_ms, repeat, transition)
+ *           1 octet   par motif
+ * 
+ *       Les entiers de 16 bits sont rangés octet de poids faible en tête.
+ */
+const uint16_t EEPROM_ACTIVE     = 0;
+constexpr uint16_t EEPROM_SLOT[] = { 16, 16 + 504 };
+const uint16_t SLOT_HEADER_SIZE  = 4;
+const uint16_t SLOT_IMAGE_SIZE   = 504 - SLOT_HEADER_SIZE;
+const uint8_t  ANIMATION_SIZE    = 6;
+
+static_assert(3 + ANIMATION_SIZE * MAX_ANIMATIONS + MAX_FRAMES <= SLOT_IMAGE_SIZE, "Un spectacle complet doit tenir dans un emplacement.");
+static_assert(EEPROM_SLOT[1] + SLOT_HEADER_SIZE + SLOT_IMAGE_SIZE <= E2END + 1, "Les deux emplacements doivent tenir dans l'EEPROM.");
+
+/**
+ * @brief Adresse d'un octet de l'EEPROM, sous la forme attendue par les
+ *        fonctions de avr/eeprom.h.
+ */
+uint8_t *eeprom(const uint16_t address) { return (uint8_t *) uintptr_t(address); }
+
+/**
+ * @brief Protocole de téléversement.
+ * 
+ * @note Chaque paquet envoyé par l'hôte a la forme suivante :
+ * 
+ *           0x7e  commande  longueur  données...  CRC-8
+ * 
+ *       La somme de contrôle CRC-8 porte sur la commande, la longueur et les
+ *       données. La carte répond à chaque paquet par un seul octet : ACK si
+ *       la commande a abouti, NAK sinon. L'hôte attend la réponse avant
+ *       d'envoyer le paquet suivant.
+ * 
+ *       'B' taille (2 octets)       Début du téléversement d'une image.
+ *       'W' position (2 octets) ... Écriture de 1 à 32 octets de l'image.
+ *       'C' CRC-16 (2 octets)       Fin du téléversement : l'image est
+ *                                   vérifiée, puis activée.
+ * 
+ *       La réponse à un paquet 'W' n'est envoyée qu'une fois les données
+ *       écrites en EEPROM (environ 3,3 ms par octet modifié).
+ */
+const uint32_t SERIAL_BAUD   = 115200;
+const uint8_t  PACKET_SYNC   = 0x7e;
+const uint8_t  PACKET_MAX    = 2 + 32;
+const uint8_t  ACK           = 0x06;
+const uint8_t  NAK           = 0x15;
+
+/**
+ * @brief État du téléversement.
+ */
+enum UploadState : uint8_t {
+    UPLOAD_IDLE,      // Aucun téléversement en cours.
+    UPLOAD_RECEIVING, // Réception de l'image.
+    UPLOAD_HEADER,    // Écriture de l'en-tête de l'emplacement.
+    UPLOAD_ACTIVATE,  // Écriture de l'emplacement actif.
+    UPLOAD_READY      // Le nouveau spectacle attend la fin de l'animation en cours.
+};
+
+/**
+ * @brief Paquet en cours de réception.
+ */
+struct Packet {
+    uint8_t state;             // Nombre d'octets reçus (0 : attente de l'octet de synchronisation).
+    uint8_t command;           // Commande.
+    uint8_t length;            // Longueur des données.
+    uint8_t crc;               // Somme de contrôle calculée au fil de la réception.
+    uint8_t data[PACKET_MAX];  // Données.
+};
+
+/**
+ * @brief Téléversement en cours.
+ * 
+ * @note Les écritures en EEPROM ne sont jamais attendues : la boucle principale
+ *       écrit un octet dès que l'EEPROM est disponible, puis rend la main au
+ *       séquenceur.
+ */
+struct Upload {
+    UploadState state;             // État du téléversement.
+    uint8_t     slot;              // Emplacement de destination.
+    uint16_t    size;              // Taille de l'image.
+    uint16_t    crc;               // Somme de contrôle de l'image.
+    uint16_t    address;           // Adresse EEPROM des octets à écrire.
+    uint8_t     pending;           // Nombre d'octets restant à écrire.
+    uint8_t     written;           // Nombre d'octets déjà écrits.
+    uint8_t     data[PACKET_MAX];  // Octets à écrire.
+};
+
+RingBuffer<64> rx;
+Packet         packet = {};
+Upload         upload = {};
+
+// ----------------------------------------------------------------------------
+// Gestion des LEDs
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Initialisation des broches de commande des LEDs.
+ */
+void initLeds() {
+
+    Leds::begin();
+
+}
+
+/**
+ * @brief Affichage d'un motif binaire 8-bits sur le chenillard à 8 LEDs.
+ * 
+ * @param n Entier compris dans l'intervalle [0,255].
+ * 
+ * @note Comme dans l'exercice 05, les registres PORTD et PORTB sont écrits
+ *       directement, chacun en une seule fois, plutôt que LED par LED avec
+ *       digitalWrite().
+ * 
+ *       Le câblage étant connu à la compilation, la classe Chaser effectue
+ *       ce calcul sans boucle ni lecture en table : un décalage et un masque
+ *       par port suffisent lorsque les LEDs sont branchées dans l'ordre.
+ */
+void ledWrite(const Leds::Frame pattern) {
+
+    BENCH_MARK(BENCH_WRITE_BEGIN);
+
+    Leds::write(pattern);
+
+    BENCH_MARK(BENCH_WRITE_END);
+
+}
+
+// ----------------------------------------------------------------------------
+// Chargement des spectacles
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Lecture d'un motif binaire du spectacle en cours.
+ * 
+ * @param index Indice du motif dans le tableau `show.frame`.
+ */
+uint8_t readFrame(const uint16_t index) {
+
+    return show.frame[index];
+
+}
+
+/**
+ * @brief Lecture du descripteur d'une animation du spectacle en cours.
+ * 
+ * @param index      Indice de l'animation (0 ≤ index < show.animations).
+ * @param pAnimation Structure de données en SRAM qui reçoit la copie.
+ */
+void readAnimation(const uint8_t index, Animation * const pAnimation) {
+
+    *pAnimation = show.animation[index];
+
+}
+
+/**
+ * @brief Chargement du spectacle intégré au firmware.
+ */
+void loadBuiltinShow() {
+
+    show.animations = NUM_ANIMATIONS;
+    show.frames     = sizeof(ANIMATION_FRAME);
+
+    memcpy_P(show.animation, animation, sizeof(animation));
+    memcpy_P(show.frame, ANIMATION_FRAME, sizeof(ANIMATION_FRAME));
+
+}
+
+/**
+ * @brief Lecture d'un octet de l'image rangée dans un emplacement de l'EEPROM.
+ */
+uint8_t readImage(const uint8_t slot, const uint16_t offset) {
+
+    return eeprom_read_byte(eeprom(EEPROM_SLOT[slot] + SLOT_HEADER_SIZE + offset));
+
+}
+
+uint16_t readImageWord(const uint8_t slot, const uint16_t offset) {
+
+    return readImage(slot, offset) | readImage(slot, offset + 1) << 8;
+
+}
+
+/**
+ * @brief Mise à jour d'une somme de contrôle CRC-16 (CCITT, polynôme 0x1021).
+ */
+uint16_t crc16(uint16_t crc, const uint8_t value) {
+
+    crc ^= uint16_t(value) << 8;
+
+    for (uint8_t i=0; i<8; i++) {
+        crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+
+    return crc;
+
+}
+
+/**
+ * @brief Mise à jour d'une somme de contrôle CRC-8 (polynôme 0x07).
+ */
+uint8_t crc8(uint8_t crc, const uint8_t value) {
+
+    crc ^= value;
+
+    for (uint8_t i=0; i<8; i++) {
+        crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+
+    return crc;
+
+}
+
+/**
+ * @brief Vérification de l'image rangée dans un emplacement de l'EEPROM.
+ * 
+ * @param slot Emplacement.
+ * @param size Taille annoncée de l'image.
+ * @param crc  Somme de contrôle annoncée de l'image.
+ * 
+ * @note L'image doit être intacte, et chaque animation doit désigner des motifs
+ *       qui existent : le séquenceur n'aura ainsi jamais à vérifier les données
+ *       qu'il lit.
+ */
+bool checkImage(const uint8_t slot, const uint16_t size, const uint16_t crc) {
+
+    if (size < 3 || size > SLOT_IMAGE_SIZE) return false;
+
+    uint16_t c = 0xffff;
+    for (uint16_t i=0; i<size; i++) c = crc16(c, readImage(slot, i));
+    if (c != crc) return false;
+
+    const uint8_t  animations = readImage(slot, 0);
+    const uint16_t frames     = readImageWord(slot, 1);
+
+    if (animations == 0 || animations > MAX_ANIMATIONS || frames > MAX_FRAMES) return false;
+    if (size != 3 + ANIMATION_SIZE * animations + frames) return false;
+
+    for (uint8_t i=0; i<animations; i++) {
+
+        const uint16_t offset = 3 + ANIMATION_SIZE * i;
+        const uint16_t start  = readImageWord(slot, offset);
+        const uint8_t  n      = readImage(slot, offset + 2);
+
+        // Pas d'addition start + n : elle déborderait sur 16 bits (start = 0xffff).
+        if (n == 0 || start > frames || n > frames - start)                       return false;
+        if (readImage(slot, offset + 3) == 0 || readImage(slot, offset + 4) == 0) return false;
+        if (readImage(slot, offset + 5) > SLIDE_DOWN)                             return false;
+
+    }
+
+    return true;
+
+}
+
+/**
+ * @brief Chargement d'un spectacle rangé dans un emplacement de l'EEPROM.
+ * 
+ * @note L'image doit avoir été vérifiée au préalable par checkImage().
+ */
+void loadShow(const uint8_t slot) {
+
+    show.animations = readImage(slot, 0);
+    show.frames     = readImageWord(slot, 1);
+
+    for (uint8_t i=0; i<show.animations; i++) {
+
+        const uint16_t offset = 3 + ANIMATION_SIZE * i;
+        Animation * const a = &show.animation[i];
+
+        a->start          = readImageWord(slot, offset);
+        a->frames         = readImage(slot, offset + 2);
+        a->frame_delay_ms = readImage(slot, offset + 3);
+        a->repeat         = readImage(slot, offset + 4);
+        a->transition     = Transition(readImage(slot, offset + 5));
+
+    }
+
+    const uint16_t first = 3 + ANIMATION_SIZE * show.animations;
+
+    for (uint16_t i=0; i<show.frames; i++) {
+        show.frame[i] = readImage(slot, first + i);
+    }
+
+}
+
+/**
+ * @brief Chargement du spectacle actif au démarrage : celui de l'EEPROM s'il
+ *        est intact, le spectacle intégré sinon.
+ */
+void loadActiveShow() {
+
+    const uint8_t slot = eeprom_read_byte(eeprom(EEPROM_ACTIVE));
+
+    if (slot < 2) {
+
+        const uint8_t * const header = eeprom(EEPROM_SLOT[slot]);
+
+        const uint16_t size = eeprom_read_byte(header)     | eeprom_read_byte(header + 1) << 8;
+        const uint16_t crc  = eeprom_read_byte(header + 2) | eeprom_read_byte(header + 3) << 8;
+
+        if (checkImage(slot, size, crc)) {
+            loadShow(slot);
+            return;
+        }
+
+    }
+
+    loadBuiltinShow();
+
+}
+
+// ----------------------------------------------------------------------------
+// Gestion des animations
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Lancement d'une animation.
+ * 
+ * @param index Indice de l'animation à lancer (0 ≤ index < NUM_ANIMATIONS)
+ * 
+ * @note On effectue l'initialisation des propriétés du séquenceur avec les données
+ *       de prise en charge de la nouvelle animation qui va démarrer. Le descripteur
+ *       de l'animation est recopié une fois pour toutes depuis la copie du
+ *       spectacle en cours, en SRAM.
+ */
+void startAnimation(const uint8_t index) {
+
+    BENCH_MARK(BENCH_ANIMATION);
+
+    player.animation_id = index;
+    player.repeat       = 0;
+    player.frame        = 0;
+    player.step         = TRANSITION_STEPS;
+
+    readAnimation(index, &player.animation);
+
+}
+
+/**
+ * @brief Lecture incrémentale de l'animation courante.
+ */
+void playAnimation() {
+
+    BENCH_MARK(BENCH_PLAY_BEGIN);
+
+    // Définition d'un pointeur sur la structure de donnée qui décrit
+    // l'animation courante (la copie détenue par le séquenceur),
+    // permettant d'accéder directement à ses propriétés sans faire
+    // de copie locale.
+    // 
+    // Le mot-clef `const` utilisé 2 fois ici déclare que :
+    //   1. la structure de données pointée est constante,
+    //   2. le pointeur lui-même est de valeur constante,
+    const Animation * const pAnimation = &player.animation;
+
+    // Si une transition est en cours, on affiche l'étape suivante, calculée
+    // à partir du dernier motif de l'animation précédente et du premier motif
+    // de la nouvelle animation. La tête de lecture ne bouge pas tant que la
+    // transition n'est pas terminée.
+    if (player.step + 1 < TRANSITION_STEPS) {
+
+        player.step++;
+
+        ledWrite(transitionFrame(pAnimation->transition, player.last, readFrame(pAnimation->start), player.step));
+
+        BENCH_MARK(BENCH_PLAY_END);
+        return;
+
+    }
+
+    // Lecture du motif binaire en cours à afficher sur la rampe de LEDs :
+    const uint8_t frame = readFrame(pAnimation->start + player.frame);
+
+    // Affichage du motif en cours sur la rampe de LEDs :
+    ledWrite(frame);
+
+    // Déplacement de la tête de lecture du séquenceur.
+    // Si l'animation courante n'est pas terminée...
+    if (player.frame + 1 < pAnimation->frames) {
+
+        // Alors on déplace la tête de lecture au prochain motif binaire
+        // de l'animation courante :
+        player.frame++;
+
+    // Sinon, c'est qu'on est arrivé au terme de l'animation courante.
+    } else {
+
+        // Auquel cas, on vérifie si on doit la répéter à nouveau...
+        if (player.repeat + 1 < pAnimation->repeat) {
+
+            // Il faut alors replacer la tête de lecture au début de l'animation :
+            player.frame = 0;
+            // Et incrémenter le nombre de répétitions opérées sur l'animation :
+            player.repeat++;
+
+        // Si l'animation ne devait pas être répétée une nouvelle fois,
+        // c'est que nous devons passer à la prochaine animation...
+        } else {
+
+            // L'indice de la nouvelle animation est donc incrémenté,
+            // et on vérifie également s'il ne faut pas redémarrer
+            // tout le processus à la première animation définie
+            // dans le tableau `ANIMATION_FRAME`, une fois qu'on a
+            // fait le tour de toutes les animations définies.
+            ++player.animation_id %= show.animations;
+
+            // Si un nouveau spectacle a été téléversé, c'est le moment d'y
+            // basculer : il démarre par sa première animation, amenée par
+            // la transition qui lui est associée.
+            if (upload.state == UPLOAD_READY) {
+                loadShow(upload.slot);
+                upload.state = UPLOAD_IDLE;
+                player.animation_id = 0;
+            }
+
+            // Il ne reste plus qu'à lancer la nouvelle animation :
+            startAnimation(player.animation_id);
+
+            // Sans oublier d'amorcer la transition qui y mène, à partir
+            // du motif qui vient d'être affiché :
+            if (player.animation.transition != CUT) {
+                player.step = 0;
+                player.last = frame;
+            }
+
+        }
+
+    }
+
+    BENCH_MARK(BENCH_PLAY_END);
+
+}
+
+// ----------------------------------------------------------------------------
+// Liaison série
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Configuration de l'USART : 8 bits de données, sans parité, 1 bit de
+ *        stop, avec interruption à la réception de chaque octet.
+ * 
+ * @note L'objet `Serial` du framework Arduino définit sa propre routine
+ *       d'interruption de réception : il ne doit donc pas être utilisé ici.
+ */
+void initSerial() {
+
+    UBRR0  = (F_CPU / 4 / SERIAL_BAUD - 1) / 2;
+    UCSR0A = _BV(U2X0);                               // double vitesse
+    UCSR0C = _BV(UCSZ01) | _BV(UCSZ00);               // 8N1
+    UCSR0B = _BV(RXEN0) | _BV(TXEN0) | _BV(RXCIE0);   // réception, émission, interruption
+
+}
+
+/**
+ * @brief Routine d'interruption de réception : chaque octet reçu est rangé
+ *        dans la file, que la boucle principale dépouille à son rythme.
+ */
+ISR(USART_RX_vect) {
+
+    rx.push(UDR0);
+
+}
+
+/**
+ * @brief Émission d'un octet (attente active).
+ */
+void serialWrite(const uint8_t c) {
+
+    while (!(UCSR0A & _BV(UDRE0)));
+    UDR0 = c;
+
+}
+
+// ----------------------------------------------------------------------------
+// Téléversement en EEPROM
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Programme l'écriture d'une suite d'octets en EEPROM.
+ * 
+ * @note Les octets sont effectivement écrits par serviceEeprom(), un par un.
+ */
+void queueWrite(const uint16_t address, const uint8_t *data, const uint8_t length) {
+
+    memcpy(upload.data, data, length);
+
+    upload.address = address;
+    upload.pending = length;
+    upload.written = 0;
+
+}
+
+/**
+ * @brief Traitement d'un paquet complet et intègre.
+ * 
+ * @return La réponse à envoyer à l'hôte, ou 0 si la réponse doit attendre
+ *         la fin des écritures en EEPROM.
+ */
+uint8_t handlePacket() {
+
+    const uint16_t word = packet.data[0] | packet.data[1] << 8;
+
+    // Un paquet qui arrive pendant une écriture est refusé : l'hôte aurait
+    // dû attendre la réponse au paquet précédent.
+    if (upload.written || packet.length < 2) return NAK;
+
+    switch (packet.command) {
+
+        case 'B':
+            if (word < 3 || word > SLOT_IMAGE_SIZE) return NAK;
+            // Le nouveau spectacle est écrit dans l'emplacement inactif.
+            // Un spectacle déjà téléversé qui attendait son tour est abandonné.
+            upload.slot  = eeprom_read_byte(eeprom(EEPROM_ACTIVE)) == 0 ? 1 : 0;
+            upload.size  = word;
+            upload.state = UPLOAD_RECEIVING;
+            return ACK;
+
+        case 'W':
+            // Le contrôle des bornes ne fait aucune addition : sur l'AVR, les
+            // calculs sur 16 bits pourraient déborder et désigner une adresse
+            // hors de l'emplacement.
+            if (upload.state != UPLOAD_RECEIVING || packet.length < 3) return NAK;
+            if (word > upload.size || packet.length - 2 > upload.size - word) return NAK;
+            queueWrite(EEPROM_SLOT[upload.slot] + SLOT_HEADER_SIZE + word, packet.data + 2, packet.length - 2);
+            return 0;
+
+        case 'C': {
+            if (upload.state != UPLOAD_RECEIVING || !checkImage(upload.slot, upload.size, word)) return NAK;
+            // L'image est intacte : on écrit l'en-tête de l'emplacement, puis
+            // on désigne l'emplacement comme actif.
+            upload.crc = word;
+            const uint8_t header[] = {
+                uint8_t(upload.size), uint8_t(upload.size >> 8),
+                uint8_t(upload.crc),  uint8_t(upload.crc >> 8)
+            };
+            queueWrite(EEPROM_SLOT[upload.slot], header, sizeof(header));
+            upload.state = UPLOAD_HEADER;
+            return 0;
+        }
+
+    }
+
+    return NAK;
+
+}
+
+/**
+ * @brief Lecture des octets reçus et reconstitution des paquets.
+ */
+void servicePackets() {
+
+    uint8_t c;
+
+    while (!upload.written && !upload.pending && rx.pop(c)) {
+
+        switch (packet.state) {
+
+            case 0:
+                if (c == PACKET_SYNC) {
+                    packet.crc = 0;
+                    packet.state++;
+                }
+                continue;
+
+            case 1:
+                packet.command = c;
+                break;
+
+            case 2:
+                if (c > PACKET_MAX) {
+                    packet.state = 0;
+                    serialWrite(NAK);
+                    continue;
+                }
+                packet.length = c;
+                break;
+
+            default:
+                // Dernier octet : la somme de contrôle.
+                if (packet.state == 3 + packet.length) {
+                    const uint8_t reply = c == packet.crc ? handlePacket() : NAK;
+                    if (reply) serialWrite(reply);
+                    packet.state = 0;
+                    continue;
+                }
+                packet.data[packet.state - 3] = c;
+                break;
+
+        }
+
+        packet.crc = crc8(packet.crc, c);
+        packet.state++;
+
+    }
+
+}
+
+/**
+ * @brief Écriture en EEPROM, un octet à la fois, sans jamais attendre.
+ * 
+ * @note Seuls les octets qui diffèrent du contenu de l'EEPROM sont écrits :
+ *       téléverser une variante d'un spectacle est d'autant plus rapide.
+ */
+void serviceEeprom() {
+
+    if (!eeprom_is_ready() || (upload.written == 0 && upload.pending == 0)) return;
+
+    if (upload.pending) {
+
+        eeprom_update_byte(eeprom(upload.address + upload.written), upload.data[upload.written]);
+        upload.written++;
+        upload.pending--;
+
+    } else {
+
+        // Toutes les écritures programmées sont terminées :
+        upload.written = 0;
+
+        switch (upload.state) {
+
+            case UPLOAD_RECEIVING:
+                serialWrite(ACK);
+                break;
+
+            case UPLOAD_HEADER: {
+                const uint8_t slot = upload.slot;
+                queueWrite(EEPROM_ACTIVE, &slot, 1);
+                upload.state = UPLOAD_ACTIVATE;
+                break;
+            }
+
+            case UPLOAD_ACTIVATE:
+                // Le nouveau spectacle sera chargé au terme de l'animation en cours.
+                upload.state = UPLOAD_READY;
+                serialWrite(ACK);
+                break;
+
+            default:
+                break;
+
+        }
+
+    }
+
+}
+
+// ----------------------------------------------------------------------------
+// Squelette principal du programme
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Démarrage du programme.
+ */
+void setup() {
+
+    initLeds();
+    initSerial();
+    loadActiveShow();
+    startAnimation(0);
+    deadlineStart(player.deadline, millis(), player.animation.frame_delay_ms);
+
+}
+
+/**
+ * @brief Boucle de contrôle principale.
+ * 
+ * @note Toujours sans utiliser la fonction delay() ! Le téléversement ne fait
+ *       jamais attendre la boucle : le spectacle continue pendant ce temps.
+ */
+void loop() {
+
+    BENCH_MARK(BENCH_LOOP);
+
+    const uint32_t now = millis();
+
+    // Définition d'un pointeur sur la structure de donnée qui décrit
+    // l'animation courante (la copie détenue par le séquenceur),
+    // permettant d'accéder directement à ses propriétés sans faire
+    // de copie locale.
+    // 
+    // Le mot-clef `const` utilisé 2 fois ici déclare que :
+    //   1. la structure de données pointée est constante,
+    //   2. le pointeur lui-même est de valeur constante,
+    const Animation * const pAnimation = &player.animation;
+
+    // L'échéance suivante est calculée à partir de l'échéance atteinte, et non
+    // de la date à laquelle la boucle s'en aperçoit : les retards de la boucle
+    // ne s'accumulent pas au fil des motifs. Après un retard important, les
+    // motifs en attente sont affichés coup sur coup jusqu'à ce que l'animation
+    // ait rattrapé son horaire (politique CATCH_UP).
+    if (deadlineReached(player.deadline, now)) {
+
+        // Le motif affiché reste en place pendant la durée prévue par son
+        // animation, même si la tête de lecture passe à l'animation suivante :
+        const uint8_t frame_delay_ms = pAnimation->frame_delay_ms;
+
+        playAnimation();
+        BENCH_FRAME_PERIOD(frame_delay_ms);
+
+        deadlineAdvance(player.deadline, now, frame_delay_ms, CATCH_UP);
+
+    }
+
+    servicePackets();
+    serviceEeprom();
+
+}
\ No newline at end of file
@@ -0,0 +1,320 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Rampes de grande longueur sur registres à décalage 74HC595 (bus SPI)
+ * -------------------------------------------------------------------------
+ */
+
+#include <Arduino.h>
+#include <Bench.h>
+
+// ----------------------------------------------------------------------------
+// Définition des constantes et variables globales
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Nombre de LEDs de la rampe (un multiple de 8).
+ *
+ * @note Les LEDs sont commandées par une chaîne de 74HC595, à raison de
+ *       8 LEDs par registre. La longueur de la rampe peut être fixée à la
+ *       compilation, sans modifier ce fichier :
+ *
+ *           -D SHIFT_LEDS=512
+ */
+#ifndef SHIFT_LEDS
+#define SHIFT_LEDS 64
+#endif
+
+const uint16_t NUM_LEDS = SHIFT_LEDS;
+
+static_assert(NUM_LEDS % 8 == 0 && NUM_LEDS / 8 <= 255, "La rampe doit compter de 8 à 2040 LEDs, par multiples de 8.");
+
+/**
+ * @brief Nombre d'octets d'un motif (un par registre à décalage).
+ */
+const uint8_t FRAME_BYTES = NUM_LEDS / 8;
+
+/**
+ * @brief Motif binaire de la rampe : la LED d'indice `i` est commandée par
+ *        le bit `i % 8` de l'octet `i / 8`.
+ */
+struct Frame {
+    uint8_t byte[FRAME_BYTES];
+};
+
+/**
+ * @brief Broches du bus SPI, toutes situées sur le port B.
+ *
+ * @note Les broches MOSI et SCK sont imposées par le périphérique SPI de
+ *       l'ATmega328P :
+ *
+ *         - MOSI (D11) → entrée série DS du premier 74HC595,
+ *         - SCK  (D13) → horloge de décalage SH_CP de tous les registres,
+ *         - SS   (D10) → horloge de verrouillage ST_CP de tous les registres.
+ *
+ *       La sortie série Q7' de chaque registre est reliée à l'entrée DS du
+ *       suivant. La broche SS est choisie comme verrou car elle doit de toute
+ *       façon être configurée en sortie : en entrée, un niveau bas ferait
+ *       basculer le périphérique SPI en mode esclave.
+ */
+const uint8_t SPI_LATCH = _BV(2); // PB2 (D10)
+const uint8_t SPI_MOSI  = _BV(3); // PB3 (D11)
+const uint8_t SPI_SCK   = _BV(5); // PB5 (D13)
+
+/**
+ * @brief Configuration de l'horloge du bus SPI : F_CPU / 16, soit 1 MHz.
+ *
+ * @note Chaque octet est émis en 8 µs (128 cycles d'horloge). Pendant ce
+ *       temps, le CPU n'exécute que la routine d'interruption qui lance
+ *       l'octet suivant : le reste revient à la boucle principale, qui
+ *       dessine le motif suivant pendant le rafraîchissement.
+ *
+ *       Une horloge plus rapide n'accélèrerait guère le rafraîchissement : à
+ *       F_CPU / 4 (32 cycles par octet), l'émission d'un octet ne durerait
+ *       pas plus longtemps que l'entrée dans la routine d'interruption, la
+ *       sauvegarde des registres et le retour, et le CPU serait accaparé
+ *       par le bus. Une horloge de 1 MHz reste en outre tolérante aux
+ *       longues liaisons qui desservent les rampes.
+ */
+const uint8_t SPI_CLOCK_SPCR = _BV(SPR0);
+const uint8_t SPI_CLOCK_SPSR = 0;
+
+/**
+ * @brief Émission des motifs vers la chaîne de registres à décalage.
+ *
+ * @note Le motif affiché est doublement protégé :
+ *
+ *         - chaque 74HC595 décale les bits reçus dans un registre interne,
+ *           distinct du registre de sortie ; les LEDs ne changent d'état
+ *           qu'au verrouillage, une fois le motif entièrement émis,
+ *         - le programme dessine le motif suivant dans un second tampon,
+ *           pendant que le premier est émis sous interruption.
+ *
+ *       Le tampon de dessin (`front ^ 1`) n'appartient au programme que tant
+ *       qu'aucun motif n'est en attente (`pending`). Une fois le motif remis,
+ *       la routine d'interruption permute les tampons au début de l'émission
+ *       suivante, et le tampon qu'elle libère est rendu au programme.
+ */
+struct Shift {
+    Frame            frame[2];  // Tampons d'émission et de dessin.
+    volatile uint8_t front;     // Indice du tampon en cours d'émission.
+    volatile bool    pending;   // Un motif a été remis et attend son émission.
+    volatile bool    busy;      // Une émission est en cours.
+    volatile uint8_t remaining; // Nombre d'octets restant à émettre.
+};
+
+/**
+ * @brief Initialisation de l'émetteur.
+ *
+ * @note Tous les paramètres sont initialisés à zéro par défaut.
+ */
+Shift shift = {
+    {},    // frame
+    0,     // front
+    false, // pending
+    false, // busy
+    0      // remaining
+};
+
+/**
+ * @brief Durée d'un aller simple du point lumineux sur toute la rampe.
+ */
+const uint16_t SWEEP_MS = 2000;
+
+/**
+ * @brief Durée d'affichage de chaque position du point lumineux.
+ */
+const uint16_t STEP_MS = SWEEP_MS / (NUM_LEDS - 1) ? SWEEP_MS / (NUM_LEDS - 1) : 1;
+
+/**
+ * @brief Longueur de la traîne du point lumineux.
+ */
+const uint8_t TAIL_LEDS = 4;
+
+// ----------------------------------------------------------------------------
+// Émission des motifs sur le bus SPI
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Configuration du bus SPI en mode maître, avec interruption à la fin
+ *        de l'émission de chaque octet.
+ *
+ * @note Le 74HC595 lit son entrée sur le front montant de l'horloge (mode 0),
+ *       et les octets sont émis bit de poids fort en tête : le bit 0 de
+ *       chaque octet aboutit ainsi sur la sortie QA de son registre.
+ */
+void initShift() {
+
+    PORTB &= ~(SPI_LATCH | SPI_MOSI | SPI_SCK);
+    DDRB  |= SPI_LATCH | SPI_MOSI | SPI_SCK;
+
+    SPSR = SPI_CLOCK_SPSR;
+    SPCR = _BV(SPIE) | _BV(SPE) | _BV(MSTR) | SPI_CLOCK_SPCR;
+
+}
+
+/**
+ * @brief Lancement de l'émission du motif remis.
+ *
+ * @note Le dernier octet du motif est émis en premier : il parcourt toute la
+ *       chaîne pour aboutir dans le registre le plus éloigné de la carte.
+ *
+ *       Cette fonction doit être appelée interruptions suspendues.
+ */
+void shiftStart() {
+
+    BENCH_MARK(BENCH_WRITE_BEGIN);
+
+    shift.front    ^= 1;
+    shift.pending   = false;
+    shift.busy      = true;
+    shift.remaining = FRAME_BYTES - 1;
+
+    SPDR = shift.frame[shift.front].byte[FRAME_BYTES - 1];
+
+}
+
+/**
+ * @brief Routine d'interruption de fin d'émission d'un octet : émission de
+ *        l'octet suivant ou, à la fin du motif, verrouillage des registres.
+ *
+ * @note L'impulsion de verrouillage dure 2 cycles d'horloge (125 ns), bien
+ *       au-delà des 20 ns exigées par le 74HC595. Si le motif suivant a déjà
+ *       été remis, son émission démarre aussitôt.
+ */
+ISR(SPI_STC_vect) {
+
+    if (shift.remaining) {
+        SPDR = shift.frame[shift.front].byte[--shift.remaining];
+        return;
+    }
+
+    PORTB |= SPI_LATCH;
+    PORTB &= ~SPI_LATCH;
+
+    BENCH_MARK(BENCH_WRITE_END);
+
+    shift.busy = false;
+
+    if (shift.pending) shiftStart();
+
+}
+
+/**
+ * @brief Indique si le tampon de dessin est disponible.
+ */
+bool shiftReady() {
+
+    return !shift.pending;
+
+}
+
+/**
+ * @brief Tampon de dessin du prochain motif.
+ *
+ * @note À n'utiliser que lorsque shiftReady() l'autorise.
+ */
+Frame &shiftFrame() {
+
+    return shift.frame[shift.front ^ 1];
+
+}
+
+/**
+ * @brief Remise du motif dessiné, qui sera émis dès que le bus sera libre.
+ */
+void shiftCommit() {
+
+    const uint8_t sreg = SREG;
+    cli();
+
+    shift.pending = true;
+    if (!shift.busy) shiftStart();
+
+    SREG = sreg;
+
+}
+
+// ----------------------------------------------------------------------------
+// Animation
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Allume une LED du motif.
+ */
+void setLed(Frame &f, const uint16_t i) {
+
+    f.byte[i >> 3] |= 1 << (i & 0x7);
+
+}
+
+/**
+ * @brief Dessin d'un point lumineux suivi de sa traîne, qui parcourt la rampe
+ *        d'un bout à l'autre.
+ *
+ * @param f   Motif à dessiner.
+ * @param now Date courante (en millisecondes).
+ */
+void drawComet(Frame &f, const uint32_t now) {
+
+    const uint16_t span = 2 * (NUM_LEDS - 1);
+    const uint16_t step = (now / STEP_MS) % span;
+
+    memset(f.byte, 0, FRAME_BYTES);
+
+    // Le point descend la rampe, puis la remonte : sa traîne le suit.
+    for (uint8_t k=0; k<TAIL_LEDS; k++) {
+        const uint16_t s = (step + span - k) % span;
+        setLed(f, s < NUM_LEDS ? s : span - s);
+    }
+
+}
+
+// ----------------------------------------------------------------------------
+// Squelette principal du programme
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Démarrage du programme.
+ *
+ * @note Les registres à décalage démarrent dans un état quelconque : un motif
+ *       vide est émis d'emblée pour éteindre toutes les LEDs.
+ */
+void setup() {
+
+    initShift();
+    shiftCommit();
+
+}
+
+/**
+ * @brief Boucle de contrôle principale.
+ *
+ * @note Un nouveau motif est dessiné et remis dès que le tampon de dessin se
+ *       libère : la rampe est ainsi rafraîchie à la cadence maximale permise
+ *       par le bus, comme l'exigerait une modulation de luminosité (voir
+ *       l'exercice 12) sur toute sa longueur.
+ *
+ *       Cette cadence n'est pas celle du seul bus (8 µs par octet) : chaque
+ *       octet attend en outre que la routine d'interruption lance le suivant,
+ *       et sur une rampe courte, le dessin d'un motif (division sur 32 bits
+ *       comprise) dure plus longtemps que son émission. La simulation native
+ *       ne modélise pas la durée des instructions : la cadence effective se
+ *       mesure sous simavr (bench/run.sh), d'après le nombre de verrouillages
+ *       des registres (ligne ledWrite()).
+ */
+void loop() {
+
+    BENCH_MARK(BENCH_LOOP);
+
+    if (shiftReady()) {
+        drawComet(shiftFrame(), millis());
+        shiftCommit();
+    }
+
+}
@@ -0,0 +1,489 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Superposition de plusieurs séquenceurs d'animations indépendants
+ * -------------------------------------------------------------------------
+ */
+
+#include <Arduino.h>
+#include <Bench.h>
+#include <Chaser.h>
+#include <Scheduler.h>
+
+// ----------------------------------------------------------------------------
+// Définition des constantes et variables globales
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Rampe de LEDs, décrite par ses broches de commande (de la LED
+ *        d'indice 0 à la LED d'indice 7).
+ */
+typedef Chaser<5, 6, 7, 8, 9, 10, 11, 12> Leds;
+
+/**
+ * @brief Définition des motifs constituant chaque animation.
+ * 
+ * @note Les animations #0 à #7 sont celles de l'exercice 08. Les deux
+ *       dernières sont destinées aux calques de premier plan.
+ */
+const uint8_t ANIMATION_FRAME[] PROGMEM = {
+    
+    // animation #0
+
+    0b10000000, //
+    0b01000000, //
+    0b00100000, //
+    0b00010000, //
+    0b00001000, //
+    0b00000100, //
+    0b00000010, // 14 frames
+    0b00000001, //
+    0b00000010, //
+    0b00000100, //
+    0b00001000, //
+    0b00010000, //
+    0b00100000, //
+    0b01000000, //
+
+    // animation #1
+
+    0b10000001, //
+    0b01000010, //
+    0b00100100, // 6 frames
+    0b00011000, //
+    0b00100100, //
+    0b01000010, //
+
+    // animation #2
+
+    0b11100000, //
+    0b01110000, //
+    0b00111000, //
+    0b00011100, //
+    0b00001110, // 10 frames
+    0b00000111, //
+    0b00001110, //
+    0b00011100, //
+    0b00111000, //
+    0b01110000, //
+
+    // animation #3
+
+    0b00000000, //
+    0b00011000, //
+    0b00111100, //
+    0b01111110, // 8 frames
+    0b11111111, //
+    0b01111110, //
+    0b00111100, //
+    0b00011000, //
+
+    // animation #4
+
+    0b01010101,// 2 frames
+    0b10101010,// 
+
+    // animation #5
+
+    0b00010001, //
+    0b00100010, // 4 frames
+    0b01000100, //
+    0b10001000, //
+
+    // animation #6
+
+    0b00000001, //
+    0b00000010, //
+    0b00000100, //
+    0b00001000, // 8 frames
+    0b00010000, //
+    0b00100000, //
+    0b01000000, //
+    0b10000000, //
+
+    // animation #7
+
+    0b00000000, //
+    0b00010000, //
+    0b00001000, //
+    0b00010000, //
+    0b00100000, //
+    0b00010000, //
+    0b00001000, //
+    0b00000100, //
+    0b00001000, //
+    0b00010000, //
+    0b00100000, //
+    0b01000000, //
+    0b00100000, //
+    0b00010000, //
+    0b00001000, //
+    0b00000100, //
+    0b00000010, //
+    0b00000100, // 37 frames
+    0b00001000, //
+    0b00010000, //
+    0b00100000, //
+    0b01000000, //
+    0b10000000, //
+    0b01000000, //
+    0b00100000, //
+    0b00010000, //
+    0b00001000, //
+    0b00000100, //
+    0b00000010, //
+    0b00000001, //
+    0b00000010, //
+    0b00000100, //
+    0b00001000, //
+    0b00010000, //
+    0b00100000, //
+    0b01000000, //
+    0b10000000, //
+
+    // animation #8 : accent (point qui balaie la rampe)
+
+    0b00000001, //
+    0b00000010, //
+    0b00000100, //
+    0b00001000, //
+    0b00010000, //
+    0b00100000, //
+    0b01000000, //
+    0b10000000, //
+
+    // animation #9 : alerte (clignotement)
+
+    0b11111111, //
+    0b00000000  //
+
+};
+
+
+/**
+ * @brief Définition de la structure de données d'une animation.
+ */
+struct Animation {
+    uint16_t start;          // Indice du motif de départ dans le tableau.
+    uint8_t  frames;         // Nombre de motifs constituant la séquence.
+    uint8_t  frame_delay_ms; // Durée d'affichage de chaque motif exprimée en millisecondes.
+    uint8_t  repeat;         // Nombre de répétitions de la séquence.
+};
+
+/**
+ * @brief Définition des animations périodiques.
+ */
+const Animation animation[] PROGMEM = {
+//
+//     +------------------------------- start
+//     |   +--------------------------- frames
+//     |   |    +---------------------- frame_delay_ms
+//     |   |    |   +------------------ repeat
+//     |   |    |   |
+//     v   v    v   v
+    {  0, 14,  40,  4 }, // animation #0
+    { 14,  6,  50,  8 }, // animation #1
+    { 20, 10,  50,  5 }, // animation #2
+    { 30,  8,  50,  6 }, // animation #3
+    { 38,  2, 120, 10 }, // animation #4
+    { 40,  4,  80,  8 }, // animation #5
+    { 44,  8,  60,  7 }, // animation #6
+    { 52, 37,  40,  1 }, // animation #7
+    { 89,  8,  90,  1 }, // animation #8 : accent
+    { 97,  2, 150,  1 }  // animation #9 : alerte
+};
+
+/**
+ * @brief Séquenceur d'animations.
+ * 
+ * @note Chaque séquenceur enchaîne en boucle les animations d'indices
+ *       `first` à `first + count - 1`, à son propre rythme. Le motif qu'il
+ *       affiche n'est pas écrit directement sur la rampe : il est conservé
+ *       dans `pattern`, puis combiné avec ceux des autres séquenceurs.
+ */
+struct Player {
+    uint8_t   first;        // Indice de la première animation jouée.
+    uint8_t   count;        // Nombre d'animations jouées.
+    uint8_t   animation_id; // Indice de l'animation en cours.
+    uint8_t   repeat;       // Nombre de répétitions effectuées.
+    uint8_t   frame;        // Indice du motif binaire relatif à l'animation en cours.
+    Deadline  deadline;     // Date à laquelle le prochain motif doit être affiché.
+    Animation animation;    // Copie en SRAM du descripteur de l'animation en cours.
+    uint8_t   pattern;      // Motif courant du séquenceur.
+};
+
+/**
+ * @brief Modes de fusion d'un calque avec les calques inférieurs.
+ * 
+ * @note Seuls les bits du masque du calque sont concernés ; les autres
+ *       bits du résultat sont laissés tels quels.
+ */
+enum Blend : uint8_t {
+    BLEND_REPLACE, // Le motif du calque remplace celui des calques inférieurs.
+    BLEND_OR,      // Les LEDs allumées par le calque s'ajoutent aux autres.
+    BLEND_XOR,     // Les LEDs allumées par le calque sont inversées.
+    BLEND_AND      // Seules les LEDs allumées par le calque restent allumées.
+};
+
+/**
+ * @brief Calque : un séquenceur, un mode de fusion et un masque.
+ */
+struct Layer {
+    Player  player; // Séquenceur du calque.
+    Blend   blend;  // Mode de fusion avec les calques inférieurs.
+    uint8_t mask;   // LEDs sur lesquelles le calque agit.
+};
+
+/**
+ * @brief Nombre de calques.
+ */
+const uint8_t NUM_LAYERS = 3;
+
+/**
+ * @brief Définition des calques, du plus profond au plus haut.
+ * 
+ * @note Le spectacle de fond occupe toute la rampe, un point lumineux la
+ *       balaie en inversant les LEDs qu'il survole, et les deux LEDs des
+ *       extrémités clignotent en permanence pour signaler une alerte.
+ */
+Layer layer[NUM_LAYERS] = {
+//
+//     +----------------------------------------------- first
+//     |  +-------------------------------------------- count
+//     |  |                      +--------------------- blend
+//     |  |                      |              +------ mask
+//     |  |                      |              |
+//     v  v                      v              v
+    { { 0, 8, 0, 0, 0, {}, {}, 0 }, BLEND_REPLACE, 0b11111111 }, // spectacle de fond
+    { { 8, 1, 0, 0, 0, {}, {}, 0 }, BLEND_XOR,     0b11111111 }, // accent
+    { { 9, 1, 0, 0, 0, {}, {}, 0 }, BLEND_OR,      0b10000001 }  // alerte
+};
+
+/**
+ * @brief Dernier motif écrit sur la rampe.
+ */
+uint8_t shown = 0;
+
+// ----------------------------------------------------------------------------
+// Gestion des LEDs
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Initialisation des broches de commande des LEDs.
+ */
+void initLeds() {
+
+    Leds::begin();
+
+}
+
+/**
+ * @brief Affichage d'un motif binaire 8-bits sur le chenillard à 8 LEDs.
+ */
+void ledWrite(const Leds::Frame pattern) {
+
+    BENCH_MARK(BENCH_WRITE_BEGIN);
+
+    Leds::write(pattern);
+
+    BENCH_MARK(BENCH_WRITE_END);
+
+}
+
+// ----------------------------------------------------------------------------
+// Lecture des données en mémoire flash
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Lecture d'un motif binaire en mémoire flash.
+ * 
+ * @param index Indice du motif dans le tableau `ANIMATION_FRAME`.
+ */
+uint8_t readFrame(const uint16_t index) {
+
+    return pgm_read_byte(&ANIMATION_FRAME[index]);
+
+}
+
+/**
+ * @brief Lecture du descripteur d'une animation en mémoire flash.
+ * 
+ * @param index      Indice de l'animation.
+ * @param pAnimation Structure de données en SRAM qui reçoit la copie.
+ */
+void readAnimation(const uint8_t index, Animation * const pAnimation) {
+
+    memcpy_P(pAnimation, &animation[index], sizeof(Animation));
+
+}
+
+// ----------------------------------------------------------------------------
+// Gestion des séquenceurs
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Lancement d'une animation sur un séquenceur.
+ * 
+ * @param player Séquenceur.
+ * @param index  Indice de l'animation à lancer.
+ */
+void startAnimation(Player &player, const uint8_t index) {
+
+    player.animation_id = index;
+    player.repeat       = 0;
+    player.frame        = 0;
+
+    readAnimation(index, &player.animation);
+
+}
+
+/**
+ * @brief Avance d'un motif sur un séquenceur.
+ * 
+ * @return Durée d'affichage du motif qui vient d'être produit.
+ */
+uint8_t stepPlayer(Player &player) {
+
+    const Animation * const pAnimation = &player.animation;
+    const uint8_t frame_delay_ms       = pAnimation->frame_delay_ms;
+
+    player.pattern = readFrame(pAnimation->start + player.frame);
+
+    if (player.frame + 1 < pAnimation->frames) {
+
+        player.frame++;
+
+    } else if (player.repeat + 1 < pAnimation->repeat) {
+
+        player.frame = 0;
+        player.repeat++;
+
+    } else {
+
+        const uint8_t next = player.animation_id + 1;
+        startAnimation(player, next < player.first + player.count ? next : player.first);
+
+    }
+
+    return frame_delay_ms;
+
+}
+
+// ----------------------------------------------------------------------------
+// Composition des calques
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Fusion d'un calque avec le résultat des calques inférieurs.
+ * 
+ * @param below Résultat de la composition des calques inférieurs.
+ * @param l     Calque à fusionner.
+ */
+uint8_t blend(const uint8_t below, const Layer &l) {
+
+    const uint8_t p = l.player.pattern;
+    const uint8_t m = l.mask;
+
+    switch (l.blend) {
+        case BLEND_OR:  return below | (p & m);
+        case BLEND_XOR: return below ^ (p & m);
+        case BLEND_AND: return below & (p | ~m);
+        default:        return (below & ~m) | (p & m);
+    }
+
+}
+
+/**
+ * @brief Composition de tous les calques, du plus profond au plus haut.
+ * 
+ * @note Tous les calques sont fusionnés à chaque composition, qu'ils aient
+ *       changé ou non : le coût d'une composition ne dépend que du nombre de
+ *       calques, jamais du contenu des motifs.
+ */
+uint8_t compose() {
+
+    uint8_t frame = 0;
+
+    for (uint8_t i=0; i<NUM_LAYERS; i++) {
+        frame = blend(frame, layer[i]);
+    }
+
+    return frame;
+
+}
+
+// ----------------------------------------------------------------------------
+// Squelette principal du programme
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Démarrage du programme.
+ * 
+ * @note Chaque séquenceur produit son premier motif dès le premier passage
+ *       dans la boucle principale.
+ */
+void setup() {
+
+    initLeds();
+
+    const uint32_t now = millis();
+
+    for (uint8_t i=0; i<NUM_LAYERS; i++) {
+        Player &player = layer[i].player;
+        startAnimation(player, player.first);
+        deadlineStart(player.deadline, now, 0);
+    }
+
+}
+
+/**
+ * @brief Boucle de contrôle principale.
+ * 
+ * @note Chaque passage dans la boucle constitue un « tic », dont le coût
+ *       est borné :
+ * 
+ *         - chaque séquenceur avance d'un motif au plus, même s'il est en
+ *           retard (il rattrapera son horaire aux tics suivants),
+ *         - les calques ne sont recomposés que si l'un d'eux a changé,
+ *         - la rampe n'est écrite que si le motif composé a changé.
+ */
+void loop() {
+
+    BENCH_MARK(BENCH_LOOP);
+
+    const uint32_t now = millis();
+
+    bool changed = false;
+
+    for (uint8_t i=0; i<NUM_LAYERS; i++) {
+
+        Player &player = layer[i].player;
+
+        if (deadlineReached(player.deadline, now)) {
+            deadlineAdvance(player.deadline, now, stepPlayer(player), CATCH_UP);
+            changed = true;
+        }
+
+    }
+
+    if (changed) {
+
+        BENCH_MARK(BENCH_PLAY_BEGIN);
+
+        const uint8_t frame = compose();
+
+        if (frame != shown) {
+            ledWrite(frame);
+            shown = frame;
+        }
+
+        BENCH_MARK(BENCH_PLAY_END);
+
+    }
+
+}
@@ -0,0 +1,673 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Sommeil du micro-contrôleur entre deux motifs
+ * -------------------------------------------------------------------------
+ */
+
+#include <Arduino.h>
+#include <avr/sleep.h>
+#include <Bench.h>
+#include <Chaser.h>
+#include <Frames.h>
+
+// ----------------------------------------------------------------------------
+// Définition des constantes et variables globales
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Rampe de LEDs, décrite par ses broches de commande (de la LED
+ *        d'indice 0 à la LED d'indice 7).
+ * 
+ * @note Les masques des ports et la séquence d'initialisation sont déduits
+ *       du câblage à la compilation (voir lib/Chaser).
+ */
+typedef Chaser<5, 6, 7, 8, 9, 10, 11, 12> Leds;
+
+/**
+ * @brief Nombre de LEDs.
+ */
+const uint8_t NUM_LEDS = Leds::size;
+
+/**
+ * @brief Nombre d'animations prédéfinies dans l'enchaînement proposé.
+ */
+const uint8_t NUM_ANIMATIONS = 8;
+
+/**
+ * @brief Définition des motifs constituant chaque animation.
+ * 
+ * @note Les animations sont celles de l'exercice 10, calculées à la compilation
+ *       par les générateurs définis dans `lib/Frames`.
+ */
+constexpr auto ANIMATION_0 = bounce<1>();            // un point qui rebondit
+constexpr auto ANIMATION_1 = mirror(bounce<1, 4>()); // deux points qui se croisent au centre
+constexpr auto ANIMATION_2 = bounce<3>();            // KITT
+constexpr auto ANIMATION_3 = mirror(fill<4>());      // remplissage depuis le centre
+constexpr auto ANIMATION_4 = alternate(0b01010101);  // clignotement alterné
+constexpr auto ANIMATION_5 = scan<4>(0b00010001);    // deux points qui défilent
+constexpr auto ANIMATION_6 = scan<8>(0b00000001);    // un point qui défile
+
+constexpr Frames<37> ANIMATION_7 = {{
+    0b00000000, 0b00010000, 0b00001000, 0b00010000,
+    0b00100000, 0b00010000, 0b00001000, 0b00000100,
+    0b00001000, 0b00010000, 0b00100000, 0b01000000,
+    0b00100000, 0b00010000, 0b00001000, 0b00000100,
+    0b00000010, 0b00000100, 0b00001000, 0b00010000,
+    0b00100000, 0b01000000, 0b10000000, 0b01000000,
+    0b00100000, 0b00010000, 0b00001000, 0b00000100,
+    0b00000010, 0b00000001, 0b00000010, 0b00000100,
+    0b00001000, 0b00010000, 0b00100000, 0b01000000,
+    0b10000000
+}};
+
+/**
+ * @brief Ensemble des motifs, rangés les uns à la suite des autres en mémoire flash.
+ * 
+ * @note Le tableau est construit par le compilateur en concaténant les animations.
+ */
+constexpr auto ANIMATION_FRAME PROGMEM = concat(
+    ANIMATION_0, ANIMATION_1, ANIMATION_2, ANIMATION_3,
+    ANIMATION_4, ANIMATION_5, ANIMATION_6, ANIMATION_7
+);
+
+/**
+ * @brief Nombre de motifs de chaque animation.
+ */
+constexpr uint16_t ANIMATION_SIZE[] = {
+    ANIMATION_0.size, ANIMATION_1.size, ANIMATION_2.size, ANIMATION_3.size,
+    ANIMATION_4.size, ANIMATION_5.size, ANIMATION_6.size, ANIMATION_7.size
+};
+
+/**
+ * @brief Indice du premier motif d'une animation dans le tableau `ANIMATION_FRAME`.
+ * 
+ * @note Les indices de départ se déduisent des tailles des animations qui
+ *       précèdent : il n'est plus nécessaire de les calculer à la main.
+ */
+constexpr uint16_t animationStart(const uint8_t index) {
+
+    return index == 0 ? 0 : animationStart(index - 1) + ANIMATION_SIZE[index - 1];
+
+}
+
+static_assert(animationStart(NUM_ANIMATIONS) == ANIMATION_FRAME.size, "Chaque animation doit figurer dans ANIMATION_FRAME.");
+
+/**
+ * @brief Définition de la structure de données d'une animation.
+ */
+struct Animation {
+    uint16_t start;          // Indice du motif de départ dans le tableau.
+    uint8_t  frames;         // Nombre de motifs constituant la séquence.
+    uint8_t  frame_delay_ms; // Durée d'affichage de chaque motif exprimée en millisecondes.
+    uint8_t  repeat;         // Nombre de répétitions de la séquence.
+};
+
+/**
+ * @brief Définition des animations périodiques que l'on souhaite enchaîner.
+ */
+const Animation animation[] PROGMEM = {
+//
+//     +------------------------------------------------------ start
+//     |                  +----------------------------------- frames
+//     |                  |                   +--------------- frame_delay_ms
+//     |                  |                   |    +---------- repeat
+//     |                  |                   |    |
+//     v                  v                   v    v
+    { animationStart(0), ANIMATION_SIZE[0],  40,  4 }, // animation #0
+    { animationStart(1), ANIMATION_SIZE[1],  50,  8 }, // animation #1
+    { animationStart(2), ANIMATION_SIZE[2],  50,  5 }, // animation #2
+    { animationStart(3), ANIMATION_SIZE[3],  50,  6 }, // animation #3
+    { animationStart(4), ANIMATION_SIZE[4], 120, 10 }, // animation #4
+    { animationStart(5), ANIMATION_SIZE[5],  80,  8 }, // animation #5
+    { animationStart(6), ANIMATION_SIZE[6],  60,  7 }, // animation #6
+    { animationStart(7), ANIMATION_SIZE[7],  40,  1 }  // animation #7
+};
+
+/**
+ * @brief Définition du séquenceur d'animation.
+ * 
+ * @note Pour faciliter la lecture des animations, nous définissons un séquenceur
+ *       qui va nous permettre de gérer précisément comment doit se dérouler la
+ *       lecture périodique des animations et la gestion des paramètres afférents.
+ */
+struct Player {
+    uint8_t   animation_id; // Indice de l'animation en cours.
+    uint8_t   repeat;       // Nombre de répétitions effectuées.
+    uint8_t   frame;        // Indice du motif binaire relatif à l'animation en cours.
+    uint8_t   pattern;      // Motif à afficher lors de la prochaine interruption.
+    Animation animation;    // Copie en SRAM du descripteur de l'animation en cours.
+};
+
+/**
+ * @brief Initalisation du séquenceur.
+ * 
+ * @note Tous les paramètres sont initialisés à zéro par défaut.
+ * 
+ *       Le séquenceur n'est manipulé que par la routine d'interruption du
+ *       Timer1. Si la boucle principale devait le consulter ou le modifier,
+ *       elle devrait le faire en suspendant les interruptions (cli() ... SREG).
+ */
+Player player = {
+    0, // animation_id
+    0, // repeat
+    0, // frame
+    0, // pattern
+    {} // animation
+};
+
+/**
+ * @brief Nombre de tops du Timer1 par milliseconde.
+ * 
+ * @note Avec un pré-diviseur de 64, le compteur 16 bits du Timer1 progresse
+ *       de 250 tops par milliseconde (4 µs par top) et peut donc mesurer des
+ *       durées allant jusqu'à 262 ms : largement de quoi couvrir les 255 ms
+ *       que peut valoir `frame_delay_ms`.
+ */
+const uint16_t TIMER_TICKS_PER_MS = F_CPU / 64 / 1000;
+
+/**
+ * @brief Intensités consommées par le micro-contrôleur, éveillé et endormi
+ *        en mode IDLE, ainsi que par chaque LED allumée (en microampères).
+ * 
+ * @note Les intensités du micro-contrôleur sont les valeurs typiques de la
+ *       fiche technique de l'ATmega328P, sous 5 V à 16 MHz. Celle d'une LED
+ *       découle de notre montage : (5 V - 2 V) / 220 Ω ≈ 13,6 mA. Les autres
+ *       composants de la carte (régulateur, convertisseur USB, LED témoin)
+ *       ne sont pas pris en compte.
+ */
+const uint32_t MCU_ACTIVE_UA = 9000;
+const uint32_t MCU_IDLE_UA   = 2500;
+const uint32_t LED_UA        = 13600;
+
+/**
+ * @brief Débit de la liaison série sur laquelle est envoyé le bilan de
+ *        chaque spectacle (bits par seconde).
+ */
+const uint32_t SERIAL_BAUD = 115200;
+
+/**
+ * @brief Bilan énergétique du spectacle en cours.
+ * 
+ * @note Les durées sont exprimées en tops du Timer1 (4 µs). La durée d'éveil
+ *       est cumulée par la boucle principale, juste avant chaque mise en
+ *       sommeil : le compteur du Timer1, remis à zéro par l'interruption qui
+ *       a réveillé le micro-contrôleur, donne alors la durée écoulée depuis
+ *       le réveil. Les autres durées sont cumulées par la routine
+ *       d'interruption, au terme de chaque motif.
+ */
+struct Energy {
+    uint32_t active_ticks; // Durée d'éveil.
+    uint32_t total_ticks;  // Durée totale.
+    uint32_t lit_ticks;    // Durée d'allumage cumulée de toutes les LEDs.
+    uint8_t  lit;          // Nombre de LEDs allumées par le motif affiché.
+    uint8_t  next_lit;     // Nombre de LEDs allumées par le prochain motif.
+};
+
+/**
+ * @brief Bilan du dernier spectacle achevé, transmis par la routine
+ *        d'interruption à la boucle principale.
+ */
+struct Report {
+    uint32_t      active_ticks; // Durée d'éveil.
+    uint32_t      total_ticks;  // Durée totale.
+    uint32_t      lit_ticks;    // Durée d'allumage cumulée de toutes les LEDs.
+    uint16_t      show;         // Numéro du spectacle.
+    volatile bool ready;        // Un bilan est prêt à être envoyé.
+};
+
+/**
+ * @brief Bilans du spectacle en cours et du dernier spectacle achevé.
+ * 
+ * @note Tous les paramètres sont initialisés à zéro par défaut.
+ */
+Energy energy = {};
+Report report = {};
+
+// ----------------------------------------------------------------------------
+// Gestion des LEDs
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Initialisation des broches de commande des LEDs.
+ */
+void initLeds() {
+
+    Leds::begin();
+
+}
+
+/**
+ * @brief Affichage d'un motif binaire 8-bits sur le chenillard à 8 LEDs.
+ * 
+ * @param n Entier compris dans l'intervalle [0,255].
+ * 
+ * @note Comme dans l'exercice 05, les registres PORTD et PORTB sont écrits
+ *       directement, chacun en une seule fois, plutôt que LED par LED avec
+ *       digitalWrite().
+ * 
+ *       Le câblage étant connu à la compilation, la classe Chaser effectue
+ *       ce calcul sans boucle ni lecture en table : un décalage et un masque
+ *       par port suffisent lorsque les LEDs sont branchées dans l'ordre.
+ */
+void ledWrite(const Leds::Frame pattern) {
+
+    BENCH_MARK(BENCH_WRITE_BEGIN);
+
+    Leds::write(pattern);
+
+    BENCH_MARK(BENCH_WRITE_END);
+
+}
+
+// ----------------------------------------------------------------------------
+// Lecture des données en mémoire flash
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Lecture d'un motif binaire en mémoire flash.
+ * 
+ * @param index Indice du motif dans le tableau `ANIMATION_FRAME`.
+ */
+uint8_t readFrame(const uint16_t index) {
+
+    return pgm_read_byte(&ANIMATION_FRAME.frame[index]);
+
+}
+
+/**
+ * @brief Lecture du descripteur d'une animation en mémoire flash.
+ * 
+ * @param index      Indice de l'animation (0 ≤ index < NUM_ANIMATIONS).
+ * @param pAnimation Structure de données en SRAM qui reçoit la copie.
+ */
+void readAnimation(const uint8_t index, Animation * const pAnimation) {
+
+    memcpy_P(pAnimation, &animation[index], sizeof(Animation));
+
+}
+
+// ----------------------------------------------------------------------------
+// Gestion des animations
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Nombre de LEDs allumées par un motif.
+ */
+uint8_t countLeds(uint8_t pattern) {
+
+    uint8_t n = 0;
+
+    while (pattern) {
+        pattern &= pattern - 1;
+        n++;
+    }
+
+    return n;
+
+}
+
+/**
+ * @brief Clôture du bilan du spectacle qui vient de s'achever.
+ * 
+ * @note Cette fonction est appelée par la routine d'interruption du Timer1.
+ *       Si le bilan précédent n'a pas encore été envoyé, il est écrasé.
+ */
+void closeShow() {
+
+    report.active_ticks = energy.active_ticks;
+    report.total_ticks  = energy.total_ticks;
+    report.lit_ticks    = energy.lit_ticks;
+    report.show++;
+    report.ready        = true;
+
+    energy.active_ticks = 0;
+    energy.total_ticks  = 0;
+    energy.lit_ticks    = 0;
+
+}
+
+/**
+ * @brief Lancement d'une animation.
+ * 
+ * @param index Indice de l'animation à lancer (0 ≤ index < NUM_ANIMATIONS)
+ * 
+ * @note On effectue l'initialisation des propriétés du séquenceur avec les données
+ *       de prise en charge de la nouvelle animation qui va démarrer. Le descripteur
+ *       de l'animation est recopié une fois pour toutes depuis la mémoire flash.
+ */
+void startAnimation(const uint8_t index) {
+
+    BENCH_MARK(BENCH_ANIMATION);
+
+    player.animation_id = index;
+    player.repeat       = 0;
+    player.frame        = 0;
+
+    readAnimation(index, &player.animation);
+
+}
+
+/**
+ * @brief Lecture incrémentale de l'animation courante.
+ * 
+ * @note Cette fonction est appelée par la routine d'interruption du Timer1.
+ *       Le motif à afficher a été lu à l'appel précédent : il est écrit sur
+ *       les ports dès l'entrée dans la fonction, de sorte que le délai entre
+ *       l'interruption et l'allumage des LEDs reste le même quel que soit le
+ *       motif, y compris lorsqu'une nouvelle animation démarre.
+ * 
+ *       La durée d'affichage de ce motif est programmée dans la foulée, avant
+ *       que la tête de lecture ne passe éventuellement à l'animation suivante.
+ */
+void playAnimation() {
+
+    BENCH_MARK(BENCH_PLAY_BEGIN);
+
+    // Définition d'un pointeur sur la structure de donnée qui décrit
+    // l'animation courante (la copie détenue par le séquenceur),
+    // permettant d'accéder directement à ses propriétés sans faire
+    // de copie locale.
+    // 
+    // Le mot-clef `const` utilisé 2 fois ici déclare que :
+    //   1. la structure de données pointée est constante,
+    //   2. le pointeur lui-même est de valeur constante,
+    const Animation * const pAnimation = &player.animation;
+
+    // Affichage du motif préparé lors de l'appel précédent :
+    ledWrite(player.pattern);
+
+    // Bilan de la période qui vient de s'achever, dont la durée est encore
+    // inscrite dans OCR1A :
+    const uint16_t period = OCR1A + 1;
+    energy.total_ticks += period;
+    energy.lit_ticks   += uint32_t(energy.lit) * period;
+    energy.lit          = energy.next_lit;
+
+    // Le compteur du Timer1 vient de repartir de zéro : la prochaine
+    // interruption surviendra lorsqu'il aura atteint la valeur de OCR1A,
+    // c'est-à-dire au terme de la durée d'affichage du motif.
+    OCR1A = pAnimation->frame_delay_ms * TIMER_TICKS_PER_MS - 1;
+    BENCH_FRAME_PERIOD(pAnimation->frame_delay_ms);
+
+    // Déplacement de la tête de lecture du séquenceur.
+    // Si l'animation courante n'est pas terminée...
+    if (player.frame + 1 < pAnimation->frames) {
+
+        // Alors on déplace la tête de lecture au prochain motif binaire
+        // de l'animation courante :
+        player.frame++;
+
+    // Sinon, c'est qu'on est arrivé au terme de l'animation courante.
+    } else {
+
+        // Auquel cas, on vérifie si on doit la répéter à nouveau...
+        if (player.repeat + 1 < pAnimation->repeat) {
+
+            // Il faut alors replacer la tête de lecture au début de l'animation :
+            player.frame = 0;
+            // Et incrémenter le nombre de répétitions opérées sur l'animation :
+            player.repeat++;
+
+        // Si l'animation ne devait pas être répétée une nouvelle fois,
+        // c'est que nous devons passer à la prochaine animation...
+        } else {
+
+            // L'indice de la nouvelle animation est donc incrémenté,
+            // et on vérifie également s'il ne faut pas redémarrer
+            // tout le processus à la première animation définie
+            // dans le tableau `ANIMATION_FRAME`, une fois qu'on a
+            // fait le tour de toutes les animations définies.
+            ++player.animation_id %= NUM_ANIMATIONS;
+
+            // Le spectacle recommence : son bilan est clos.
+            if (player.animation_id == 0) closeShow();
+
+            // Il ne reste plus qu'à lancer la nouvelle animation :
+            startAnimation(player.animation_id);
+
+        }
+
+    }
+
+    // Lecture du prochain motif à afficher, en dehors du chemin critique :
+    player.pattern   = readFrame(pAnimation->start + player.frame);
+    energy.next_lit  = countLeds(player.pattern);
+
+    BENCH_MARK(BENCH_PLAY_END);
+
+}
+
+// ----------------------------------------------------------------------------
+// Cadencement par le Timer1
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Configuration du Timer1 en mode CTC (Clear Timer on Compare match).
+ * 
+ * @note Dans ce mode, le compteur TCNT1 est remis à zéro dès qu'il atteint la
+ *       valeur du registre OCR1A, et l'interruption TIMER1_COMPA est déclenchée.
+ *       C'est donc le matériel qui mesure la durée d'affichage de chaque motif :
+ *       les fronts des LEDs ne dépendent plus de ce que fait la boucle principale,
+ *       et leur gigue se limite à la latence de prise en charge de l'interruption
+ *       (quelques microsecondes).
+ * 
+ *       Le framework Arduino configure le Timer1 en mode PWM pour analogWrite()
+ *       sur les broches D9 et D10 : on écrase entièrement cette configuration.
+ *       La fonction analogWrite() ne doit donc plus être utilisée sur ces broches.
+ */
+void initTimer() {
+
+    noInterrupts();
+
+    TCCR1A = 0;                                       // sorties OC1A et OC1B déconnectées
+    TCCR1B = _BV(WGM12) | _BV(CS11) | _BV(CS10);      // mode CTC, pré-diviseur 64
+    TCNT1  = 0;
+    OCR1A  = 0;                                       // premier motif affiché au prochain top
+    TIMSK1 = _BV(OCIE1A);                             // interruption de comparaison A
+
+    interrupts();
+
+}
+
+/**
+ * @brief Routine d'interruption du Timer1 : affichage du motif suivant.
+ */
+ISR(TIMER1_COMPA_vect) {
+
+    playAnimation();
+
+}
+
+// ----------------------------------------------------------------------------
+// Envoi du bilan sur la liaison série
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Configuration de l'USART en émission seule : 8 bits de données, sans
+ *        parité, 1 bit de stop.
+ * 
+ * @note Aucune interruption n'est autorisée : seul le Timer1 doit pouvoir
+ *       réveiller le micro-contrôleur.
+ */
+void initSerial() {
+
+    UBRR0  = F_CPU / 8 / SERIAL_BAUD - 1;
+    UCSR0A = _BV(U2X0);                   // double vitesse
+    UCSR0C = _BV(UCSZ01) | _BV(UCSZ00);   // 8N1
+    UCSR0B = _BV(TXEN0);                  // émission
+
+}
+
+/**
+ * @brief Émission d'un octet (attente active).
+ */
+void serialWrite(const uint8_t c) {
+
+    while (!(UCSR0A & _BV(UDRE0)));
+    UDR0 = c;
+
+}
+
+/**
+ * @brief Émission d'une chaîne de caractères.
+ */
+void serialPrint(const char *s) {
+
+    while (*s) serialWrite(*s++);
+
+}
+
+/**
+ * @brief Émission d'un entier non signé, en base 10.
+ */
+void serialPrint(uint32_t n) {
+
+    char digits[10];
+    uint8_t i = 0;
+
+    do {
+        digits[i++] = '0' + n % 10;
+        n /= 10;
+    } while (n);
+
+    while (i) serialWrite(digits[--i]);
+
+}
+
+/**
+ * @brief Émission d'un nombre en virgule fixe, avec deux décimales.
+ * 
+ * @param n Nombre multiplié par 100.
+ */
+void serialPrintCents(const uint32_t n) {
+
+    serialPrint(n / 100);
+    serialWrite('.');
+    serialWrite('0' + n / 10 % 10);
+    serialWrite('0' + n % 10);
+
+}
+
+/**
+ * @brief Envoi du bilan du dernier spectacle, de la forme :
+ * 
+ *           show=1 active=0.42% mcu=2.52mA leds=21.37mA
+ * 
+ * @note L'intensité moyenne du micro-contrôleur est celle du mode IDLE,
+ *       majorée en proportion de la durée d'éveil. Celle des LEDs découle
+ *       du nombre moyen de LEDs allumées.
+ */
+void sendReport() {
+
+    const uint8_t sreg = SREG;
+    cli();
+    const Report r = { report.active_ticks, report.total_ticks, report.lit_ticks, report.show, false };
+    report.ready = false;
+    SREG = sreg;
+
+    if (r.total_ticks == 0) return;
+
+    const uint32_t active_cents = uint64_t(r.active_ticks) * 10000 / r.total_ticks;
+    const uint32_t mcu_ua       = MCU_IDLE_UA + uint64_t(MCU_ACTIVE_UA - MCU_IDLE_UA) * r.active_ticks / r.total_ticks;
+    const uint32_t leds_ua      = uint64_t(LED_UA) * r.lit_ticks / r.total_ticks;
+
+    serialPrint("show=");
+    serialPrint(r.show);
+    serialPrint(" active=");
+    serialPrintCents(active_cents);
+    serialPrint("% mcu=");
+    serialPrintCents(mcu_ua / 10);
+    serialPrint("mA leds=");
+    serialPrintCents(leds_ua / 10);
+    serialPrint("mA\r\n");
+
+}
+
+// ----------------------------------------------------------------------------
+// Mise en sommeil
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Configuration du sommeil.
+ * 
+ * @note Le Timer1 est cadencé par l'horloge des entrées-sorties, qui n'est
+ *       maintenue qu'en mode IDLE : c'est donc ce mode qui est retenu. Le
+ *       mode POWER_SAVE consommerait moins encore, mais seul le Timer2 y
+ *       reste actif, et seulement s'il est cadencé par un quartz horloger
+ *       de 32 kHz sur les broches TOSC, dont la carte Nano est dépourvue.
+ * 
+ *       L'interruption de débordement du Timer0, qui fait avancer millis()
+ *       toutes les 1,024 ms, est désactivée : elle réveillerait sinon le
+ *       micro-contrôleur près de mille fois par seconde. Les fonctions
+ *       millis(), micros() et delay() ne doivent donc plus être utilisées.
+ */
+void initSleep() {
+
+    TIMSK0 &= ~_BV(TOIE0);
+    set_sleep_mode(SLEEP_MODE_IDLE);
+
+}
+
+/**
+ * @brief Mise en sommeil jusqu'à la prochaine interruption.
+ * 
+ * @note La durée d'éveil est relevée interruptions suspendues, puis
+ *       l'instruction `sleep` suit immédiatement `sei` : l'ATmega328P exécute
+ *       toujours l'instruction qui suit `sei` avant de traiter une
+ *       interruption, qui ne peut donc pas se glisser entre les deux et
+ *       laisser le micro-contrôleur s'endormir pour une période entière.
+ */
+void sleepUntilNextFrame() {
+
+    cli();
+    energy.active_ticks += TCNT1;
+    sleep_enable();
+    sei();
+    sleep_cpu();
+    sleep_disable();
+
+}
+
+// ----------------------------------------------------------------------------
+// Squelette principal du programme
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Démarrage du programme.
+ */
+void setup() {
+
+    initLeds();
+    startAnimation(0);
+    player.pattern  = readFrame(player.animation.start);
+    energy.next_lit = countLeds(player.pattern);
+    initSerial();
+    initSleep();
+    initTimer();
+
+}
+
+/**
+ * @brief Boucle de contrôle principale.
+ * 
+ * @note Plutôt que de tourner à vide en attendant le prochain motif, la
+ *       boucle principale met le micro-contrôleur en sommeil. La routine
+ *       d'interruption du Timer1 programme elle-même la date du réveil
+ *       suivant (OCR1A), qui coïncide avec l'affichage du prochain motif :
+ *       le micro-contrôleur n'est réveillé qu'une fois par motif.
+ */
+void loop() {
+
+    BENCH_MARK(BENCH_LOOP);
+
+    if (report.ready) sendReport();
+
+    sleepUntilNextFrame();
+
+}
@@ -0,0 +1,669 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Compteurs de performances interrogeables sur la liaison série
+ * -------------------------------------------------------------------------
+ */
+
+#include <Arduino.h>
+#include <Bench.h>
+#include <Chaser.h>
+#include <Perf.h>
+#include <Scheduler.h>
+#include <Transition.h>
+
+// ----------------------------------------------------------------------------
+// Définition des constantes et variables globales
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Rampe de LEDs, décrite par ses broches de commande (de la LED
+ *        d'indice 0 à la LED d'indice 7).
+ * 
+ * @note Les masques des ports et la séquence d'initialisation sont déduits
+ *       du câblage à la compilation (voir lib/Chaser).
+ */
+typedef Chaser<5, 6, 7, 8, 9, 10, 11, 12> Leds;
+
+/**
+ * @brief Nombre de LEDs.
+ */
+const uint8_t NUM_LEDS = Leds::size;
+
+/**
+ * @brief Nombre d'animations prédéfinies dans l'enchaînement proposé.
+ */
+const uint8_t NUM_ANIMATIONS = 8;
+
+/**
+ * @brief Définition des motifs constituant chaque animation.
+ * 
+ * @note Chaque animation est définie par une séquence ordonnée de motifs
+ *       binaires (décrits par des entiers codés sur 8 bits), ainsi que par
+ *       un nombre fini de motifs, qui correspond en définitive à la longueur
+ *       de la séquence qui décrit l'animation.
+ *       
+ *       Chaque motif peut être considéré comme une image instantanée de
+ *       l'animation qu'elle participe à décrire. On parlera également de
+ *       "frame" pour reprendre un anglicisme usuel.
+ *       
+ *       On fait ici le choix de définir au sein d'un même tableau l'ensemble
+ *       des animations que nous allons enchaîner les unes après les autres.
+ * 
+ *       Le mot-clef PROGMEM demande au compilateur de laisser le tableau en
+ *       mémoire flash. Sans lui, toute donnée constante est recopiée au
+ *       démarrage dans les 2 Ko de mémoire vive (SRAM) du micro-contrôleur.
+ *       En contrepartie, le tableau ne peut plus être lu directement : il
+ *       faut passer par la fonction readFrame() définie plus bas.
+ */
+const uint8_t ANIMATION_FRAME[] PROGMEM = {
+    
+    // animation #0
+
+    0b10000000, //
+    0b01000000, //
+    0b00100000, //
+    0b00010000, //
+    0b00001000, //
+    0b00000100, //
+    0b00000010, // 14 frames
+    0b00000001, //
+    0b00000010, //
+    0b00000100, //
+    0b00001000, //
+    0b00010000, //
+    0b00100000, //
+    0b01000000, //
+
+    // animation #1
+
+    0b10000001, //
+    0b01000010, //
+    0b00100100, // 6 frames
+    0b00011000, //
+    0b00100100, //
+    0b01000010, //
+
+    // animation #2
+
+    0b11100000, //
+    0b01110000, //
+    0b00111000, //
+    0b00011100, //
+    0b00001110, // 10 frames
+    0b00000111, //
+    0b00001110, //
+    0b00011100, //
+    0b00111000, //
+    0b01110000, //
+
+    // animation #3
+
+    0b00000000, //
+    0b00011000, //
+    0b00111100, //
+    0b01111110, // 8 frames
+    0b11111111, //
+    0b01111110, //
+    0b00111100, //
+    0b00011000, //
+
+    // animation #4
+
+    0b01010101,// 2 frames
+    0b10101010,// 
+
+    // animation #5
+
+    0b00010001, //
+    0b00100010, // 4 frames
+    0b01000100, //
+    0b10001000, //
+
+    // animation #6
+
+    0b00000001, //
+    0b00000010, //
+    0b00000100, //
+    0b00001000, // 8 frames
+    0b00010000, //
+    0b00100000, //
+    0b01000000, //
+    0b10000000, //
+
+    // animation #7
+
+    0b00000000, //
+    0b00010000, //
+    0b00001000, //
+    0b00010000, //
+    0b00100000, //
+    0b00010000, //
+    0b00001000, //
+    0b00000100, //
+    0b00001000, //
+    0b00010000, //
+    0b00100000, //
+    0b01000000, //
+    0b00100000, //
+    0b00010000, //
+    0b00001000, //
+    0b00000100, //
+    0b00000010, //
+    0b00000100, // 37 frames
+    0b00001000, //
+    0b00010000, //
+    0b00100000, //
+    0b01000000, //
+    0b10000000, //
+    0b01000000, //
+    0b00100000, //
+    0b00010000, //
+    0b00001000, //
+    0b00000100, //
+    0b00000010, //
+    0b00000001, //
+    0b00000010, //
+    0b00000100, //
+    0b00001000, //
+    0b00010000, //
+    0b00100000, //
+    0b01000000, //
+    0b10000000  //
+
+};
+
+/**
+ * @brief Définition de la structure de données d'une animation.
+ * 
+ * @note Pour caractériser précisément chaque animation comme une séquence
+ *       périodique de frames (définies par ailleurs dans le tableau précédent),
+ *       on crée une structure de données générique pour les décrire toutes :
+ */
+struct Animation {
+    uint16_t   start;          // Indice du motif de départ dans le tableau.
+    uint8_t    frames;         // Nombre de motifs constituant la séquence.
+    uint8_t    frame_delay_ms; // Durée d'affichage de chaque motif exprimée en millisecondes.
+    uint8_t    repeat;         // Nombre de répétitions de la séquence.
+    Transition transition;     // Transition qui amène cette animation (voir lib/Transition).
+};
+
+/**
+ * @brief Définition des animations périodiques que l'on souhaite enchaîner.
+ * 
+ * @note Maintenant que nous avons défini la structure générique commune à toutes
+ *       les animations, il ne nous reste plus qu'à définir concrètement chacune
+ *       d'entre elles :
+ * 
+ *       Comme les motifs, ces descripteurs sont conservés en mémoire flash.
+ */
+const Animation animation[] PROGMEM = {
+//
+//     +------------------------------- start
+//     |   +--------------------------- frames
+//     |   |    +---------------------- frame_delay_ms
+//     |   |    |   +------------------ repeat
+//     |   |    |   |   +-------------- transition
+//     |   |    |   |   |
+//     v   v    v   v   v
+    {  0, 14,  40,  4, DISSOLVE   }, // animation #0
+    { 14,  6,  50,  8, WIPE_OUT   }, // animation #1
+    { 20, 10,  50,  5, SLIDE_DOWN }, // animation #2
+    { 30,  8,  50,  6, WIPE_OUT   }, // animation #3
+    { 38,  2, 120, 10, DISSOLVE   }, // animation #4
+    { 40,  4,  80,  8, WIPE_UP    }, // animation #5
+    { 44,  8,  60,  7, SLIDE_UP   }, // animation #6
+    { 52, 37,  40,  1, WIPE_DOWN  }  // animation #7
+};
+
+/**
+ * @brief Définition du séquenceur d'animation.
+ * 
+ * @note Pour faciliter la lecture des animations, nous définissons un séquenceur
+ *       qui va nous permettre de gérer précisément comment doit se dérouler la
+ *       lecture périodique des animations et la gestion des paramètres afférents.
+ */
+struct Player {
+    uint8_t   animation_id; // Indice de l'animation en cours.
+    uint8_t   repeat;       // Nombre de répétitions effectuées.
+    uint8_t   frame;        // Indice du motif binaire relatif à l'animation en cours.
+    Deadline  deadline;     // Date à laquelle le prochain motif doit être affiché.
+    Animation animation;    // Copie en SRAM du descripteur de l'animation en cours.
+    uint8_t   step;         // Étape de la transition en cours (TRANSITION_STEPS si aucune).
+    uint8_t   last;         // Dernier motif affiché par l'animation précédente.
+};
+
+/**
+ * @brief Initalisation du séquenceur.
+ * 
+ * @note Tous les paramètres sont initialisés à zéro par défaut.
+ */
+Player player = {
+    0,                // animation_id
+    0,                // repeat
+    0,                // frame
+    {},               // deadline
+    {},               // animation
+    TRANSITION_STEPS, // step
+    0                 // last
+};
+
+/**
+ * @brief Débit de la liaison série sur laquelle les compteurs sont consultés
+ *        (bits par seconde).
+ */
+const uint32_t SERIAL_BAUD = 115200;
+
+/**
+ * @brief Commandes reçues sur la liaison série.
+ */
+const uint8_t CMD_REPORT = '?'; // Envoi du relevé des compteurs.
+const uint8_t CMD_RESET  = '0'; // Remise à zéro des compteurs.
+
+/**
+ * @brief Relevé des compteurs en cours d'émission.
+ * 
+ * @note Le relevé est rédigé d'un seul coup à la réception de la commande,
+ *       puis émis à raison d'un octet par itération de la boucle principale,
+ *       dès que l'USART est prêt à le recevoir. L'émission ne bloque donc
+ *       jamais le séquenceur, et le relevé reste cohérent même si les
+ *       compteurs évoluent pendant qu'il est émis.
+ */
+struct Report {
+    char     text[256]; // Texte du relevé.
+    uint16_t length;    // Longueur du texte.
+    uint16_t sent;      // Nombre d'octets déjà émis.
+};
+
+/**
+ * @brief Initialisation du relevé.
+ * 
+ * @note Tous les paramètres sont initialisés à zéro par défaut.
+ */
+Report report = {};
+
+// ----------------------------------------------------------------------------
+// Gestion des LEDs
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Initialisation des broches de commande des LEDs.
+ */
+void initLeds() {
+
+    Leds::begin();
+
+}
+
+/**
+ * @brief Affichage d'un motif binaire 8-bits sur le chenillard à 8 LEDs.
+ * 
+ * @param n Entier compris dans l'intervalle [0,255].
+ * 
+ * @note Comme dans l'exercice 05, les registres PORTD et PORTB sont écrits
+ *       directement, chacun en une seule fois, plutôt que LED par LED avec
+ *       digitalWrite().
+ * 
+ *       Le câblage étant connu à la compilation, la classe Chaser effectue
+ *       ce calcul sans boucle ni lecture en table : un décalage et un masque
+ *       par port suffisent lorsque les LEDs sont branchées dans l'ordre.
+ */
+void ledWrite(const Leds::Frame pattern) {
+
+    BENCH_MARK(BENCH_WRITE_BEGIN);
+    PERF_SPAN_BEGIN(PERF_WRITE);
+
+    Leds::write(pattern);
+
+    PERF_SPAN_END(PERF_WRITE);
+    BENCH_MARK(BENCH_WRITE_END);
+
+}
+
+// ----------------------------------------------------------------------------
+// Lecture des données en mémoire flash
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Lecture d'un motif binaire en mémoire flash.
+ * 
+ * @param index Indice du motif dans le tableau `ANIMATION_FRAME`.
+ */
+uint8_t readFrame(const uint16_t index) {
+
+    return pgm_read_byte(&ANIMATION_FRAME[index]);
+
+}
+
+/**
+ * @brief Lecture du descripteur d'une animation en mémoire flash.
+ * 
+ * @param index      Indice de l'animation (0 ≤ index < NUM_ANIMATIONS).
+ * @param pAnimation Structure de données en SRAM qui reçoit la copie.
+ */
+void readAnimation(const uint8_t index, Animation * const pAnimation) {
+
+    memcpy_P(pAnimation, &animation[index], sizeof(Animation));
+
+}
+
+// ----------------------------------------------------------------------------
+// Gestion des animations
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Lancement d'une animation.
+ * 
+ * @param index Indice de l'animation à lancer (0 ≤ index < NUM_ANIMATIONS)
+ * 
+ * @note On effectue l'initialisation des propriétés du séquenceur avec les données
+ *       de prise en charge de la nouvelle animation qui va démarrer. Le descripteur
+ *       de l'animation est recopié une fois pour toutes depuis la mémoire flash.
+ */
+void startAnimation(const uint8_t index) {
+
+    BENCH_MARK(BENCH_ANIMATION);
+
+    player.animation_id = index;
+    player.repeat       = 0;
+    player.frame        = 0;
+    player.step         = TRANSITION_STEPS;
+
+    readAnimation(index, &player.animation);
+
+}
+
+/**
+ * @brief Lecture incrémentale de l'animation courante.
+ */
+void playAnimation() {
+
+    BENCH_MARK(BENCH_PLAY_BEGIN);
+    PERF_SPAN_BEGIN(PERF_PLAY);
+
+    // Définition d'un pointeur sur la structure de donnée qui décrit
+    // l'animation courante (la copie détenue par le séquenceur),
+    // permettant d'accéder directement à ses propriétés sans faire
+    // de copie locale.
+    // 
+    // Le mot-clef `const` utilisé 2 fois ici déclare que :
+    //   1. la structure de données pointée est constante,
+    //   2. le pointeur lui-même est de valeur constante,
+    const Animation * const pAnimation = &player.animation;
+
+    // Si une transition est en cours, on affiche l'étape suivante, calculée
+    // à partir du dernier motif de l'animation précédente et du premier motif
+    // de la nouvelle animation. La tête de lecture ne bouge pas tant que la
+    // transition n'est pas terminée.
+    if (player.step + 1 < TRANSITION_STEPS) {
+
+        player.step++;
+
+        ledWrite(transitionFrame(pAnimation->transition, player.last, readFrame(pAnimation->start), player.step));
+
+        PERF_SPAN_END(PERF_PLAY);
+        BENCH_MARK(BENCH_PLAY_END);
+        return;
+
+    }
+
+    // Lecture du motif binaire en cours à afficher sur la rampe de LEDs :
+    const uint8_t frame = readFrame(pAnimation->start + player.frame);
+
+    // Affichage du motif en cours sur la rampe de LEDs :
+    ledWrite(frame);
+
+    // Déplacement de la tête de lecture du séquenceur.
+    // Si l'animation courante n'est pas terminée...
+    if (player.frame + 1 < pAnimation->frames) {
+
+        // Alors on déplace la tête de lecture au prochain motif binaire
+        // de l'animation courante :
+        player.frame++;
+
+    // Sinon, c'est qu'on est arrivé au terme de l'animation courante.
+    } else {
+
+        // Auquel cas, on vérifie si on doit la répéter à nouveau...
+        if (player.repeat + 1 < pAnimation->repeat) {
+
+            // Il faut alors replacer la tête de lecture au début de l'animation :
+            player.frame = 0;
+            // Et incrémenter le nombre de répétitions opérées sur l'animation :
+            player.repeat++;
+
+        // Si l'animation ne devait pas être répétée une nouvelle fois,
+        // c'est que nous devons passer à la prochaine animation...
+        } else {
+
+            // L'indice de la nouvelle animation est donc incrémenté,
+            // et on vérifie également s'il ne faut pas redémarrer
+            // tout le processus à la première animation définie
+            // dans le tableau `ANIMATION_FRAME`, une fois qu'on a
+            // fait le tour de toutes les animations définies.
+            ++player.animation_id %= NUM_ANIMATIONS;
+
+            // Il ne reste plus qu'à lancer la nouvelle animation :
+            startAnimation(player.animation_id);
+
+            // Sans oublier d'amorcer la transition qui y mène, à partir
+            // du motif qui vient d'être affiché :
+            if (player.animation.transition != CUT) {
+                player.step = 0;
+                player.last = frame;
+            }
+
+        }
+
+    }
+
+    PERF_SPAN_END(PERF_PLAY);
+    BENCH_MARK(BENCH_PLAY_END);
+
+}
+
+// ----------------------------------------------------------------------------
+// Consultation des compteurs sur la liaison série
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Configuration de l'USART : 8 bits de données, sans parité, 1 bit
+ *        de stop, sans interruption (l'USART est interrogé par la boucle
+ *        principale).
+ */
+void initSerial() {
+
+    UBRR0  = F_CPU / 8 / SERIAL_BAUD - 1;
+    UCSR0A = _BV(U2X0);                   // double vitesse
+    UCSR0C = _BV(UCSZ01) | _BV(UCSZ00);   // 8N1
+    UCSR0B = _BV(RXEN0) | _BV(TXEN0);     // réception et émission
+
+}
+
+/**
+ * @brief Ajout d'une chaîne de caractères au relevé.
+ */
+void reportPrint(const char *s) {
+
+    while (*s && report.length < sizeof(report.text)) report.text[report.length++] = *s++;
+
+}
+
+/**
+ * @brief Ajout d'un entier non signé au relevé, en base 10.
+ */
+void reportPrint(uint32_t n) {
+
+    char digits[11];
+    uint8_t i = sizeof(digits) - 1;
+
+    digits[i] = '\0';
+
+    do {
+        digits[--i] = '0' + n % 10;
+        n /= 10;
+    } while (n);
+
+    reportPrint(digits + i);
+
+}
+
+/**
+ * @brief Ajout au relevé des durées d'une section mesurée (en cycles).
+ */
+void reportPrint(const char *name, const PerfTime &t) {
+
+    reportPrint(name);
+    reportPrint(" n=");
+    reportPrint(t.calls);
+    reportPrint(" avg=");
+    reportPrint(t.calls ? t.cycles / t.calls : 0);
+    reportPrint(" max=");
+    reportPrint(t.max);
+    reportPrint(" cyc\r\n");
+
+}
+
+/**
+ * @brief Rédaction du relevé des compteurs, de la forme :
+ * 
+ *           loops/s=172413
+ *           play n=1200 avg=95 max=180 cyc
+ *           write n=1200 avg=21 max=21 cyc
+ *           frames=1200 missed=0
+ *           late=612,0,0,0,588,0,0,0
+ *           probe cost=64 bias=12 cyc
+ * 
+ * @note La ligne `late` donne l'histogramme des retards d'affichage, de la
+ *       classe [0,64[ µs à la classe [4096,∞[ µs (voir lib/Perf).
+ */
+void writeReport() {
+
+    report.length = 0;
+    report.sent   = 0;
+
+#if PERF
+
+    reportPrint("loops/s=");
+    reportPrint(perf.loops_per_s);
+    reportPrint("\r\n");
+
+    reportPrint("play", perf.time[PERF_PLAY]);
+    reportPrint("write", perf.time[PERF_WRITE]);
+
+    reportPrint("frames=");
+    reportPrint(perf.frames);
+    reportPrint(" missed=");
+    reportPrint(perf.missed);
+    reportPrint("\r\n");
+
+    reportPrint("late=");
+    for (uint8_t i=0; i<PERF_LATE_BINS; i++) {
+        if (i) reportPrint(",");
+        reportPrint(perf.late[i]);
+    }
+    reportPrint("\r\n");
+
+    reportPrint("probe cost=");
+    reportPrint(perf.cost);
+    reportPrint(" bias=");
+    reportPrint(perf.bias);
+    reportPrint(" cyc\r\n");
+
+#else
+
+    reportPrint("perf=off\r\n");
+
+#endif
+
+}
+
+/**
+ * @brief Traitement des commandes reçues et émission du relevé en cours.
+ * 
+ * @note Une commande de relevé reçue pendant l'émission du précédent est
+ *       ignorée.
+ */
+void serviceSerial() {
+
+    if (UCSR0A & _BV(RXC0)) {
+
+        const uint8_t cmd = UDR0;
+
+        if (cmd == CMD_REPORT && report.sent == report.length) writeReport();
+        else if (cmd == CMD_RESET) perfReset();
+
+    }
+
+    if (report.sent < report.length && (UCSR0A & _BV(UDRE0))) {
+        UDR0 = report.text[report.sent++];
+    }
+
+}
+
+// ----------------------------------------------------------------------------
+// Squelette principal du programme
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Démarrage du programme.
+ */
+void setup() {
+
+    initLeds();
+    initSerial();
+    perfBegin();
+    startAnimation(0);
+    deadlineStart(player.deadline, millis(), player.animation.frame_delay_ms);
+
+}
+
+/**
+ * @brief Boucle de contrôle principale.
+ * 
+ * @note Toujours sans utiliser la fonction delay() !
+ */
+void loop() {
+
+    BENCH_MARK(BENCH_LOOP);
+
+    const uint32_t now = millis();
+
+    PERF_LOOP(now);
+    serviceSerial();
+
+    // Définition d'un pointeur sur la structure de donnée qui décrit
+    // l'animation courante (la copie détenue par le séquenceur),
+    // permettant d'accéder directement à ses propriétés sans faire
+    // de copie locale.
+    // 
+    // Le mot-clef `const` utilisé 2 fois ici déclare que :
+    //   1. la structure de données pointée est constante,
+    //   2. le pointeur lui-même est de valeur constante,
+    const Animation * const pAnimation = &player.animation;
+
+    // L'échéance suivante est calculée à partir de l'échéance atteinte, et non
+    // de la date à laquelle la boucle s'en aperçoit : les retards de la boucle
+    // ne s'accumulent pas au fil des motifs. Après un retard important, les
+    // motifs en attente sont affichés coup sur coup jusqu'à ce que l'animation
+    // ait rattrapé son horaire (politique CATCH_UP).
+    if (deadlineReached(player.deadline, now)) {
+
+        // Le motif affiché reste en place pendant la durée prévue par son
+        // animation, même si la tête de lecture passe à l'animation suivante :
+        const uint8_t frame_delay_ms = pAnimation->frame_delay_ms;
+
+        PERF_FRAME(player.deadline.next);
+        playAnimation();
+        BENCH_FRAME_PERIOD(frame_delay_ms);
+
+        deadlineAdvance(player.deadline, now, frame_delay_ms, CATCH_UP);
+
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,319 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Séquenceur d'un spectacle compilé à partir de sa description
+ * -------------------------------------------------------------------------
+ */
+
+#include <Arduino.h>
+#include <Bench.h>
+#include <Chaser.h>
+#include <Scheduler.h>
+#include <Transition.h>
+
+// ----------------------------------------------------------------------------
+// Définition des constantes et variables globales
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Rampe de LEDs, décrite par ses broches de commande (de la LED
+ *        d'indice 0 à la LED d'indice 7).
+ * 
+ * @note Les masques des ports et la séquence d'initialisation sont déduits
+ *       du câblage à la compilation (voir lib/Chaser).
+ */
+typedef Chaser<5, 6, 7, 8, 9, 10, 11, 12> Leds;
+
+/**
+ * @brief Nombre de LEDs.
+ */
+const uint8_t NUM_LEDS = Leds::size;
+
+/**
+ * @brief Spectacle joué : motifs et descripteurs des animations.
+ * 
+ * @note Les tableaux ANIMATION_FRAME[] et animation[], ainsi que le type
+ *       Animation et la constante NUM_ANIMATIONS, ne sont plus écrits à la
+ *       main : ils sont générés par tools/show_compile.py à partir d'une
+ *       description textuelle du spectacle, dans laquelle chaque animation
+ *       porte un nom. Le compilateur calcule lui-même l'indice de départ de
+ *       chaque animation, qu'une erreur de calcul ne peut donc plus fausser.
+ * 
+ *       Un autre spectacle peut être désigné à la compilation, sans modifier
+ *       ce fichier :
+ * 
+ *           -D SHOW='"shows/mon-spectacle.h"'
+ */
+#ifndef SHOW
+#define SHOW "shows/show-08.h"
+#endif
+
+#include SHOW
+
+/**
+ * @brief Définition du séquenceur d'animation.
+ * 
+ * @note Pour faciliter la lecture des animations, nous définissons un séquenceur
+ *       qui va nous permettre de gérer précisément comment doit se dérouler la
+ *       lecture périodique des animations et la gestion des paramètres afférents.
+ */
+struct Player {
+    uint8_t   animation_id; // Indice de l'animation en cours.
+    uint8_t   repeat;       // Nombre de répétitions effectuées.
+    uint8_t   frame;        // Indice du motif binaire relatif à l'animation en cours.
+    Deadline  deadline;     // Date à laquelle le prochain motif doit être affiché.
+    Animation animation;    // Copie en SRAM du descripteur de l'animation en cours.
+    uint8_t   step;         // Étape de la transition en cours (TRANSITION_STEPS si aucune).
+    uint8_t   last;         // Dernier motif affiché par l'animation précédente.
+};
+
+/**
+ * @brief Initalisation du séquenceur.
+ * 
+ * @note Tous les paramètres sont initialisés à zéro par défaut.
+ */
+Player player = {
+    0,                // animation_id
+    0,                // repeat
+    0,                // frame
+    {},               // deadline
+    {},               // animation
+    TRANSITION_STEPS, // step
+    0                 // last
+};
+
+// ----------------------------------------------------------------------------
+// Gestion des LEDs
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Initialisation des broches de commande des LEDs.
+ */
+void initLeds() {
+
+    Leds::begin();
+
+}
+
+/**
+ * @brief Affichage d'un motif binaire 8-bits sur le chenillard à 8 LEDs.
+ * 
+ * @param n Entier compris dans l'intervalle [0,255].
+ * 
+ * @note Comme dans l'exercice 05, les registres PORTD et PORTB sont écrits
+ *       directement, chacun en une seule fois, plutôt que LED par LED avec
+ *       digitalWrite().
+ * 
+ *       Le câblage étant connu à la compilation, la classe Chaser effectue
+ *       ce calcul sans boucle ni lecture en table : un décalage et un masque
+ *       par port suffisent lorsque les LEDs sont branchées dans l'ordre.
+ */
+void ledWrite(const Leds::Frame pattern) {
+
+    BENCH_MARK(BENCH_WRITE_BEGIN);
+
+    Leds::write(pattern);
+
+    BENCH_MARK(BENCH_WRITE_END);
+
+}
+
+// ----------------------------------------------------------------------------
+// Lecture des données en mémoire flash
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Lecture d'un motif binaire en mémoire flash.
+ * 
+ * @param index Indice du motif dans le tableau `ANIMATION_FRAME`.
+ */
+uint8_t readFrame(const uint16_t index) {
+
+    return pgm_read_byte(&ANIMATION_FRAME[index]);
+
+}
+
+/**
+ * @brief Lecture du descripteur d'une animation en mémoire flash.
+ * 
+ * @param index      Indice de l'animation (0 ≤ index < NUM_ANIMATIONS).
+ * @param pAnimation Structure de données en SRAM qui reçoit la copie.
+ */
+void readAnimation(const uint8_t index, Animation * const pAnimation) {
+
+    memcpy_P(pAnimation, &animation[index], sizeof(Animation));
+
+}
+
+// ----------------------------------------------------------------------------
+// Gestion des animations
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Lancement d'une animation.
+ * 
+ * @param index Indice de l'animation à lancer (0 ≤ index < NUM_ANIMATIONS)
+ * 
+ * @note On effectue l'initialisation des propriétés du séquenceur avec les données
+ *       de prise en charge de la nouvelle animation qui va démarrer. Le descripteur
+ *       de l'animation est recopié une fois pour toutes depuis la mémoire flash.
+ */
+void startAnimation(const uint8_t index) {
+
+    BENCH_MARK(BENCH_ANIMATION);
+
+    player.animation_id = index;
+    player.repeat       = 0;
+    player.frame        = 0;
+    player.step         = TRANSITION_STEPS;
+
+    readAnimation(index, &player.animation);
+
+}
+
+/**
+ * @brief Lecture incrémentale de l'animation courante.
+ */
+void playAnimation() {
+
+    BENCH_MARK(BENCH_PLAY_BEGIN);
+
+    // Définition d'un pointeur sur la structure de donnée qui décrit
+    // l'animation courante (la copie détenue par le séquenceur),
+    // permettant d'accéder directement à ses propriétés sans faire
+    // de copie locale.
+    // 
+    // Le mot-clef `const` utilisé 2 fois ici déclare que :
+    //   1. la structure de données pointée est constante,
+    //   2. le pointeur lui-même est de valeur constante,
+    const Animation * const pAnimation = &player.animation;
+
+    // Si une transition est en cours, on affiche l'étape suivante, calculée
+    // à partir du dernier motif de l'animation précédente et du premier motif
+    // de la nouvelle animation. La tête de lecture ne bouge pas tant que la
+    // transition n'est pas terminée.
+    if (player.step + 1 < TRANSITION_STEPS) {
+
+        player.step++;
+
+        ledWrite(transitionFrame(pAnimation->transition, player.last, readFrame(pAnimation->start), player.step));
+
+        BENCH_MARK(BENCH_PLAY_END);
+        return;
+
+    }
+
+    // Lecture du motif binaire en cours à afficher sur la rampe de LEDs :
+    const uint8_t frame = readFrame(pAnimation->start + player.frame);
+
+    // Affichage du motif en cours sur la rampe de LEDs :
+    ledWrite(frame);
+
+    // Déplacement de la tête de lecture du séquenceur.
+    // Si l'animation courante n'est pas terminée...
+    if (player.frame + 1 < pAnimation->frames) {
+
+        // Alors on déplace la tête de lecture au prochain motif binaire
+        // de l'animation courante :
+        player.frame++;
+
+    // Sinon, c'est qu'on est arrivé au terme de l'animation courante.
+    } else {
+
+        // Auquel cas, on vérifie si on doit la répéter à nouveau...
+        if (player.repeat + 1 < pAnimation->repeat) {
+
+            // Il faut alors replacer la tête de lecture au début de l'animation :
+            player.frame = 0;
+            // Et incrémenter le nombre de répétitions opérées sur l'animation :
+            player.repeat++;
+
+        // Si l'animation ne devait pas être répétée une nouvelle fois,
+        // c'est que nous devons passer à la prochaine animation...
+        } else {
+
+            // L'indice de la nouvelle animation est donc incrémenté,
+            // et on vérifie également s'il ne faut pas redémarrer
+            // tout le processus à la première animation définie
+            // dans le tableau `ANIMATION_FRAME`, une fois qu'on a
+            // fait le tour de toutes les animations définies.
+            ++player.animation_id %= NUM_ANIMATIONS;
+
+            // Il ne reste plus qu'à lancer la nouvelle animation :
+            startAnimation(player.animation_id);
+
+            // Sans oublier d'amorcer la transition qui y mène, à partir
+            // du motif qui vient d'être affiché :
+            if (player.animation.transition != CUT) {
+                player.step = 0;
+                player.last = frame;
+            }
+
+        }
+
+    }
+
+    BENCH_MARK(BENCH_PLAY_END);
+
+}
+
+// ----------------------------------------------------------------------------
+// Squelette principal du programme
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Démarrage du programme.
+ */
+void setup() {
+
+    initLeds();
+    startAnimation(0);
+    deadlineStart(player.deadline, millis(), player.animation.frame_delay_ms);
+
+}
+
+/**
+ * @brief Boucle de contrôle principale.
+ * 
+ * @note Toujours sans utiliser la fonction delay() !
+ */
+void loop() {
+
+    BENCH_MARK(BENCH_LOOP);
+
+    const uint32_t now = millis();
+
+    // Définition d'un pointeur sur la structure de donnée qui décrit
+    // l'animation courante (la copie détenue par le séquenceur),
+    // permettant d'accéder directement à ses propriétés sans faire
+    // de copie locale.
+    // 
+    // Le mot-clef `const` utilisé 2 fois ici déclare que :
+    //   1. la structure de données pointée est constante,
+    //   2. le pointeur lui-même est de valeur constante,
+    const Animation * const pAnimation = &player.animation;
+
+    // L'échéance suivante est calculée à partir de l'échéance atteinte, et non
+    // de la date à laquelle la boucle s'en aperçoit : les retards de la boucle
+    // ne s'accumulent pas au fil des motifs. Après un retard important, les
+    // motifs en attente sont affichés coup sur coup jusqu'à ce que l'animation
+    // ait rattrapé son horaire (politique CATCH_UP).
+    if (deadlineReached(player.deadline, now)) {
+
+        // Le motif affiché reste en place pendant la durée prévue par son
+        // animation, même si la tête de lecture passe à l'animation suivante :
+        const uint8_t frame_delay_ms = pAnimation->frame_delay_ms;
+
+        playAnimation();
+        BENCH_FRAME_PERIOD(frame_delay_ms);
+
+        deadlineAdvance(player.deadline, now, frame_delay_ms, CATCH_UP);
+
+    }
+
+}
\ No newline at end of file
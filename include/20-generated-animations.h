@@ -0,0 +1,489 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Animations calculées à la volée par des générateurs
+ * -------------------------------------------------------------------------
+ */
+
+#include <Arduino.h>
+#include <Bench.h>
+#include <Chaser.h>
+#include <Generator.h>
+#include <Scheduler.h>
+#include <ShowBuilder.h>
+#include <Transition.h>
+
+// ----------------------------------------------------------------------------
+// Définition des constantes et variables globales
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Rampe de LEDs, décrite par ses broches de commande (de la LED
+ *        d'indice 0 à la LED d'indice 7).
+ * 
+ * @note Les masques des ports et la séquence d'initialisation sont déduits
+ *       du câblage à la compilation (voir lib/Chaser).
+ */
+typedef Chaser<5, 6, 7, 8, 9, 10, 11, 12> Leds;
+
+/**
+ * @brief Nombre de LEDs.
+ */
+const uint8_t NUM_LEDS = Leds::size;
+
+/**
+ * @brief Définition des motifs constituant chaque animation.
+ * 
+ * @note Chaque animation est définie par une séquence ordonnée de motifs
+ *       binaires (décrits par des entiers codés sur 8 bits), ainsi que par
+ *       un nombre fini de motifs, qui correspond en définitive à la longueur
+ *       de la séquence qui décrit l'animation.
+ *       
+ *       Chaque motif peut être considéré comme une image instantanée de
+ *       l'animation qu'elle participe à décrire. On parlera également de
+ *       "frame" pour reprendre un anglicisme usuel.
+ *       
+ *       Chaque animation est déclarée ici par sa propre liste de motifs. Ces
+ *       listes ne servent qu'à la compilation : elles sont ensuite mises bout
+ *       à bout dans un même tableau, rangé en mémoire flash (voir plus bas).
+ *
+ *       Les autres animations de l'enchaînement ne sont pas stockées : leurs
+ *       motifs sont calculés à la volée (voir lib/Generator).
+ */
+constexpr uint8_t BALAYAGE[] = {
+    0b10000000,
+    0b01000000,
+    0b00100000,
+    0b00010000,
+    0b00001000,
+    0b00000100,
+    0b00000010,
+    0b00000001,
+    0b00000010,
+    0b00000100,
+    0b00001000,
+    0b00010000,
+    0b00100000,
+    0b01000000
+};
+
+constexpr uint8_t MIROIR[] = {
+    0b10000001,
+    0b01000010,
+    0b00100100,
+    0b00011000,
+    0b00100100,
+    0b01000010
+};
+
+constexpr uint8_t TRAIN[] = {
+    0b11100000,
+    0b01110000,
+    0b00111000,
+    0b00011100,
+    0b00001110,
+    0b00000111,
+    0b00001110,
+    0b00011100,
+    0b00111000,
+    0b01110000
+};
+
+constexpr uint8_t PULSATION[] = {
+    0b00000000,
+    0b00011000,
+    0b00111100,
+    0b01111110,
+    0b11111111,
+    0b01111110,
+    0b00111100,
+    0b00011000
+};
+
+/**
+ * @brief Définition de la structure de données d'une animation.
+ * 
+ * @note Pour caractériser précisément chaque animation comme une séquence
+ *       périodique de frames (rangées par ailleurs dans un tableau commun,
+ *       ou calculées par un générateur), on crée une structure de données
+ *       générique pour les décrire toutes :
+ */
+struct Animation {
+    uint16_t   start;          // Indice du motif de départ dans le tableau (ou état initial du générateur).
+    uint8_t    frames;         // Nombre de motifs constituant la séquence.
+    uint8_t    frame_delay_ms; // Durée d'affichage de chaque motif exprimée en millisecondes.
+    uint8_t    repeat;         // Nombre de répétitions de la séquence.
+    Transition transition;     // Transition qui amène cette animation (voir lib/Transition).
+    Generator  generator;      // Origine des motifs (TABLE pour le tableau des motifs).
+};
+
+/**
+ * @brief Définition des animations périodiques que l'on souhaite enchaîner.
+ * 
+ * @note Les animations sont énumérées dans leur ordre de lecture, chacune avec
+ *       ses paramètres. Le tableau des motifs et les descripteurs sont
+ *       construits à la compilation (voir lib/ShowBuilder) : les champs
+ *       `start` et `frames` de chaque descripteur, comme le nombre
+ *       d'animations, sont déduits des listes de motifs, et n'ont donc plus
+ *       à être tenus à jour à la main. Une durée ou un nombre de répétitions
+ *       nul est refusé par le compilateur.
+ *
+ *       Les animations calculées n'ajoutent aucun motif au tableau : leur
+ *       descripteur indique le générateur, son état initial et le nombre de
+ *       motifs par répétition. Le générateur n'est pas réinitialisé entre
+ *       deux répétitions : le scintillement de l'animation #1 parcourt ainsi
+ *       255 motifs différents sans occuper un seul octet de mémoire flash.
+ */
+constexpr auto SHOW = show::build<Animation>(
+//
+//                 +---------------------------------------- motifs ou générateur
+//                 |         +------------------------------ état initial
+//                 |         |           +------------------ motifs par répétition
+//                 |         |           |    +------------- frame_delay_ms
+//                 |         |           |    |   +--------- repeat
+//                 |         |           |    |   |   +----- transition
+//                 |         |           |    |   |   |
+//                 v         v           v    v   v   v
+    show::play    (BALAYAGE,                  40,  4, DISSOLVE  ), // animation #0
+    show::generate(LFSR,     0x01,       255, 40,  1, DISSOLVE  ), // animation #1
+    show::generate(JOHNSON,  0x00,        16, 60,  4, WIPE_UP   ), // animation #2
+    show::generate(RULE_90,  0b00010000,  32, 80,  1, CUT       ), // animation #3
+    show::play    (TRAIN,                     50,  5, SLIDE_DOWN), // animation #4
+    show::generate(GRAY,     0x00,       255, 50,  1, SLIDE_DOWN), // animation #5
+    show::generate(RULE_30,  0b00001000,  64, 60,  1, WIPE_OUT  ), // animation #6
+    show::play    (PULSATION,                 50,  6, WIPE_OUT  ), // animation #7
+    show::generate(RULE_110, 0b00000001,  64, 60,  1, DISSOLVE  )  // animation #8
+);
+
+static_assert(show::valid(SHOW.animation, SHOW.animation.size, SHOW.frames.size), "Descripteurs d'animation incohérents.");
+
+/**
+ * @brief Nombre d'animations prédéfinies dans l'enchaînement proposé.
+ */
+const uint8_t NUM_ANIMATIONS = SHOW.animation.size;
+
+/**
+ * @brief Motifs de toutes les animations, mis bout à bout.
+ * 
+ * @note Le mot-clef PROGMEM demande au compilateur de laisser le tableau en
+ *       mémoire flash. Sans lui, toute donnée constante est recopiée au
+ *       démarrage dans les 2 Ko de mémoire vive (SRAM) du micro-contrôleur.
+ *       En contrepartie, le tableau ne peut plus être lu directement : il
+ *       faut passer par la fonction readFrame() définie plus bas.
+ * 
+ *       Seules ces copies en mémoire flash subsistent dans le programme : la
+ *       construction elle-même n'a lieu qu'à la compilation.
+ */
+const auto ANIMATION_FRAME PROGMEM = SHOW.frames;
+
+/**
+ * @brief Descripteurs des animations, dans l'ordre de lecture.
+ * 
+ * @note Comme les motifs, ces descripteurs sont conservés en mémoire flash.
+ */
+const auto animation PROGMEM = SHOW.animation;
+
+/**
+ * @brief Définition du séquenceur d'animation.
+ * 
+ * @note Pour faciliter la lecture des animations, nous définissons un séquenceur
+ *       qui va nous permettre de gérer précisément comment doit se dérouler la
+ *       lecture périodique des animations et la gestion des paramètres afférents.
+ */
+struct Player {
+    uint8_t   animation_id; // Indice de l'animation en cours.
+    uint8_t   repeat;       // Nombre de répétitions effectuées.
+    uint8_t   frame;        // Indice du motif binaire relatif à l'animation en cours.
+    Deadline  deadline;     // Date à laquelle le prochain motif doit être affiché.
+    Animation animation;    // Copie en SRAM du descripteur de l'animation en cours.
+    uint8_t   state;        // État du générateur de l'animation en cours.
+    uint8_t   step;         // Étape de la transition en cours (TRANSITION_STEPS si aucune).
+    uint8_t   last;         // Dernier motif affiché par l'animation précédente.
+};
+
+/**
+ * @brief Initalisation du séquenceur.
+ * 
+ * @note Tous les paramètres sont initialisés à zéro par défaut.
+ */
+Player player = {
+    0,                // animation_id
+    0,                // repeat
+    0,                // frame
+    {},               // deadline
+    {},               // animation
+    0,                // state
+    TRANSITION_STEPS, // step
+    0                 // last
+};
+
+// ----------------------------------------------------------------------------
+// Gestion des LEDs
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Initialisation des broches de commande des LEDs.
+ */
+void initLeds() {
+
+    Leds::begin();
+
+}
+
+/**
+ * @brief Affichage d'un motif binaire 8-bits sur le chenillard à 8 LEDs.
+ * 
+ * @param n Entier compris dans l'intervalle [0,255].
+ * 
+ * @note Comme dans l'exercice 05, les registres PORTD et PORTB sont écrits
+ *       directement, chacun en une seule fois, plutôt que LED par LED avec
+ *       digitalWrite().
+ * 
+ *       Le câblage étant connu à la compilation, la classe Chaser effectue
+ *       ce calcul sans boucle ni lecture en table : un décalage et un masque
+ *       par port suffisent lorsque les LEDs sont branchées dans l'ordre.
+ */
+void ledWrite(const Leds::Frame pattern) {
+
+    BENCH_MARK(BENCH_WRITE_BEGIN);
+
+    Leds::write(pattern);
+
+    BENCH_MARK(BENCH_WRITE_END);
+
+}
+
+// ----------------------------------------------------------------------------
+// Lecture des données en mémoire flash
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Lecture d'un motif binaire en mémoire flash.
+ * 
+ * @param index Indice du motif dans le tableau `ANIMATION_FRAME`.
+ */
+uint8_t readFrame(const uint16_t index) {
+
+    return pgm_read_byte(&ANIMATION_FRAME[index]);
+
+}
+
+/**
+ * @brief Lecture du descripteur d'une animation en mémoire flash.
+ * 
+ * @param index      Indice de l'animation (0 ≤ index < NUM_ANIMATIONS).
+ * @param pAnimation Structure de données en SRAM qui reçoit la copie.
+ */
+void readAnimation(const uint8_t index, Animation * const pAnimation) {
+
+    memcpy_P(pAnimation, &animation[index], sizeof(Animation));
+
+}
+
+// ----------------------------------------------------------------------------
+// Gestion des animations
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Motif courant de l'animation, lu en mémoire flash ou calculé par son
+ *        générateur, qui passe alors à l'état suivant.
+ * 
+ * @param pAnimation Descripteur de l'animation courante.
+ */
+uint8_t nextFrame(const Animation * const pAnimation) {
+
+    if (pAnimation->generator == TABLE) return readFrame(pAnimation->start + player.frame);
+
+    const uint8_t frame = generatorFrame(pAnimation->generator, player.state);
+
+    player.state = generatorStep(pAnimation->generator, player.state);
+
+    return frame;
+
+}
+
+/**
+ * @brief Premier motif d'une animation, affiché au terme de la transition
+ *        qui l'amène.
+ * 
+ * @param pAnimation Descripteur de l'animation.
+ */
+uint8_t firstFrame(const Animation * const pAnimation) {
+
+    if (pAnimation->generator == TABLE) return readFrame(pAnimation->start);
+
+    return generatorFrame(pAnimation->generator, pAnimation->start);
+
+}
+
+/**
+ * @brief Lancement d'une animation.
+ * 
+ * @param index Indice de l'animation à lancer (0 ≤ index < NUM_ANIMATIONS)
+ * 
+ * @note On effectue l'initialisation des propriétés du séquenceur avec les données
+ *       de prise en charge de la nouvelle animation qui va démarrer. Le descripteur
+ *       de l'animation est recopié une fois pour toutes depuis la mémoire flash.
+ */
+void startAnimation(const uint8_t index) {
+
+    BENCH_MARK(BENCH_ANIMATION);
+
+    player.animation_id = index;
+    player.repeat       = 0;
+    player.frame        = 0;
+    player.step         = TRANSITION_STEPS;
+
+    readAnimation(index, &player.animation);
+
+    player.state = player.animation.start;
+
+}
+
+/**
+ * @brief Lecture incrémentale de l'animation courante.
+ */
+void playAnimation() {
+
+    BENCH_MARK(BENCH_PLAY_BEGIN);
+
+    // Définition d'un pointeur sur la structure de donnée qui décrit
+    // l'animation courante (la copie détenue par le séquenceur),
+    // permettant d'accéder directement à ses propriétés sans faire
+    // de copie locale.
+    // 
+    // Le mot-clef `const` utilisé 2 fois ici déclare que :
+    //   1. la structure de données pointée est constante,
+    //   2. le pointeur lui-même est de valeur constante,
+    const Animation * const pAnimation = &player.animation;
+
+    // Si une transition est en cours, on affiche l'étape suivante, calculée
+    // à partir du dernier motif de l'animation précédente et du premier motif
+    // de la nouvelle animation. La tête de lecture ne bouge pas tant que la
+    // transition n'est pas terminée.
+    if (player.step + 1 < TRANSITION_STEPS) {
+
+        player.step++;
+
+        ledWrite(transitionFrame(pAnimation->transition, player.last, firstFrame(pAnimation), player.step));
+
+        BENCH_MARK(BENCH_PLAY_END);
+        return;
+
+    }
+
+    // Motif binaire en cours à afficher sur la rampe de LEDs (lu en mémoire
+    // flash ou calculé par le générateur) :
+    const uint8_t frame = nextFrame(pAnimation);
+
+    // Affichage du motif en cours sur la rampe de LEDs :
+    ledWrite(frame);
+
+    // Déplacement de la tête de lecture du séquenceur.
+    // Si l'animation courante n'est pas terminée...
+    if (player.frame + 1 < pAnimation->frames) {
+
+        // Alors on déplace la tête de lecture au prochain motif binaire
+        // de l'animation courante :
+        player.frame++;
+
+    // Sinon, c'est qu'on est arrivé au terme de l'animation courante.
+    } else {
+
+        // Auquel cas, on vérifie si on doit la répéter à nouveau...
+        if (player.repeat + 1 < pAnimation->repeat) {
+
+            // Il faut alors replacer la tête de lecture au début de l'animation :
+            player.frame = 0;
+            // Et incrémenter le nombre de répétitions opérées sur l'animation :
+            player.repeat++;
+
+        // Si l'animation ne devait pas être répétée une nouvelle fois,
+        // c'est que nous devons passer à la prochaine animation...
+        } else {
+
+            // L'indice de la nouvelle animation est donc incrémenté,
+            // et on vérifie également s'il ne faut pas redémarrer
+            // tout le processus à la première animation définie
+            // dans le tableau `ANIMATION_FRAME`, une fois qu'on a
+            // fait le tour de toutes les animations définies.
+            ++player.animation_id %= NUM_ANIMATIONS;
+
+            // Il ne reste plus qu'à lancer la nouvelle animation :
+            startAnimation(player.animation_id);
+
+            // Sans oublier d'amorcer la transition qui y mène, à partir
+            // du motif qui vient d'être affiché :
+            if (player.animation.transition != CUT) {
+                player.step = 0;
+                player.last = frame;
+            }
+
+        }
+
+    }
+
+    BENCH_MARK(BENCH_PLAY_END);
+
+}
+
+// ----------------------------------------------------------------------------
+// Squelette principal du programme
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Démarrage du programme.
+ */
+void setup() {
+
+    initLeds();
+    startAnimation(0);
+    deadlineStart(player.deadline, millis(), player.animation.frame_delay_ms);
+
+}
+
+/**
+ * @brief Boucle de contrôle principale.
+ * 
+ * @note Toujours sans utiliser la fonction delay() !
+ */
+void loop() {
+
+    BENCH_MARK(BENCH_LOOP);
+
+    const uint32_t now = millis();
+
+    // Définition d'un pointeur sur la structure de donnée qui décrit
+    // l'animation courante (la copie détenue par le séquenceur),
+    // permettant d'accéder directement à ses propriétés sans faire
+    // de copie locale.
+    // 
+    // Le mot-clef `const` utilisé 2 fois ici déclare que :
+    //   1. la structure de données pointée est constante,
+    //   2. le pointeur lui-même est de valeur constante,
+    const Animation * const pAnimation = &player.animation;
+
+    // L'échéance suivante est calculée à partir de l'échéance atteinte, et non
+    // de la date à laquelle la boucle s'en aperçoit : les retards de la boucle
+    // ne s'accumulent pas au fil des motifs. Après un retard important, les
+    // motifs en attente sont affichés coup sur coup jusqu'à ce que l'animation
+    // ait rattrapé son horaire (politique CATCH_UP).
+    if (deadlineReached(player.deadline, now)) {
+
+        // Le motif affiché reste en place pendant la durée prévue par son
+        // animation, même si la tête de lecture passe à l'animation suivante :
+        const uint8_t frame_delay_ms = pAnimation->frame_delay_ms;
+
+        playAnimation();
+        BENCH_FRAME_PERIOD(frame_delay_ms);
+
+        deadlineAdvance(player.deadline, now, frame_delay_ms, CATCH_UP);
+
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,422 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Séquenceur d'animations cadencé à la microseconde par le Timer1
+ * -------------------------------------------------------------------------
+ */
+
+#include <Arduino.h>
+#include <Bench.h>
+#include <Chaser.h>
+#include <Frames.h>
+#include <Timebase.h>
+
+// ----------------------------------------------------------------------------
+// Définition des constantes et variables globales
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Rampe de LEDs, décrite par ses broches de commande (de la LED
+ *        d'indice 0 à la LED d'indice 7).
+ * 
+ * @note Les masques des ports et la séquence d'initialisation sont déduits
+ *       du câblage à la compilation (voir lib/Chaser).
+ */
+typedef Chaser<5, 6, 7, 8, 9, 10, 11, 12> Leds;
+
+/**
+ * @brief Nombre de LEDs.
+ */
+const uint8_t NUM_LEDS = Leds::size;
+
+/**
+ * @brief Nombre d'animations prédéfinies dans l'enchaînement proposé.
+ */
+const uint8_t NUM_ANIMATIONS = 6;
+
+/**
+ * @brief Définition des motifs constituant chaque animation.
+ * 
+ * @note Les motifs sont calculés à la compilation par les générateurs définis
+ *       dans `lib/Frames`. Affichés pendant quelques dizaines de microsecondes,
+ *       les motifs se succèdent trop vite pour que l'œil les distingue : il
+ *       n'en perçoit que la moyenne (persistance rétinienne). Une rampe allumée
+ *       un motif sur quatre semble ainsi briller à 25 % de son intensité.
+ */
+constexpr auto      ANIMATION_0 = bounce<1>();              // un point qui rebondit
+constexpr Frames<4> ANIMATION_1 = {{ 0xff, 0, 0, 0 }};      // rampe à 25 % d'intensité
+constexpr auto      ANIMATION_2 = alternate(0b11111111);    // rampe à 50 % d'intensité
+constexpr auto      ANIMATION_3 = scan<8>(0b00000001);      // balayage pour l'affichage persistant
+constexpr Frames<10> ANIMATION_4 = {{ 0xff }};              // stroboscope (un éclair, 9 motifs éteints)
+constexpr auto      ANIMATION_5 = mirror(fill<4>());        // remplissage lent depuis le centre
+
+/**
+ * @brief Ensemble des motifs, rangés les uns à la suite des autres en mémoire flash.
+ * 
+ * @note Le tableau est construit par le compilateur en concaténant les animations.
+ */
+constexpr auto ANIMATION_FRAME PROGMEM = concat(
+    ANIMATION_0, ANIMATION_1, ANIMATION_2,
+    ANIMATION_3, ANIMATION_4, ANIMATION_5
+);
+
+/**
+ * @brief Nombre de motifs de chaque animation.
+ */
+constexpr uint16_t ANIMATION_SIZE[] = {
+    ANIMATION_0.size, ANIMATION_1.size, ANIMATION_2.size,
+    ANIMATION_3.size, ANIMATION_4.size, ANIMATION_5.size
+};
+
+/**
+ * @brief Indice du premier motif d'une animation dans le tableau `ANIMATION_FRAME`.
+ * 
+ * @note Les indices de départ se déduisent des tailles des animations qui
+ *       précèdent : il n'est plus nécessaire de les calculer à la main.
+ */
+constexpr uint16_t animationStart(const uint8_t index) {
+
+    return index == 0 ? 0 : animationStart(index - 1) + ANIMATION_SIZE[index - 1];
+
+}
+
+static_assert(animationStart(NUM_ANIMATIONS) == ANIMATION_FRAME.size, "Chaque animation doit figurer dans ANIMATION_FRAME.");
+
+/**
+ * @brief Définition de la structure de données d'une animation.
+ * 
+ * @note La durée d'affichage des motifs n'est plus exprimée en millisecondes,
+ *       mais directement par les valeurs à charger dans les registres du
+ *       Timer1 (voir lib/Timebase). Le nombre de répétitions passe sur 16 bits :
+ *       une animation dont les motifs ne durent que quelques dizaines de
+ *       microsecondes doit être répétée des milliers de fois pour être vue.
+ */
+struct Animation {
+    uint16_t    start;        // Indice du motif de départ dans le tableau.
+    uint8_t     frames;       // Nombre de motifs constituant la séquence.
+    TimerPeriod frame_period; // Durée d'affichage de chaque motif.
+    uint16_t    repeat;       // Nombre de répétitions de la séquence.
+};
+
+/**
+ * @brief Définition des animations périodiques que l'on souhaite enchaîner.
+ * 
+ * @note Les durées sont exprimées en microsecondes, de 20 µs à 4 s environ, et
+ *       converties par timerPeriod() à la compilation : une durée hors de ces
+ *       limites est refusée par le compilateur.
+ */
+const Animation animation[] PROGMEM = {
+//
+//     +------------------------------------------------------------- start
+//     |                  +------------------------------------------ frames
+//     |                  |                   +---------------------- frame_period (µs)
+//     |                  |                   |                   +-- repeat
+//     |                  |                   |                   |
+//     v                  v                   v                   v
+    { animationStart(0), ANIMATION_SIZE[0], timerPeriod( 40000),     4 }, // animation #0 (40 ms)
+    { animationStart(1), ANIMATION_SIZE[1], timerPeriod(    50), 20000 }, // animation #1 (5 kHz)
+    { animationStart(2), ANIMATION_SIZE[2], timerPeriod(    20), 50000 }, // animation #2 (25 kHz)
+    { animationStart(3), ANIMATION_SIZE[3], timerPeriod(   250),  2000 }, // animation #3 (500 Hz)
+    { animationStart(4), ANIMATION_SIZE[4], timerPeriod(  5000),    60 }, // animation #4 (20 Hz)
+    { animationStart(5), ANIMATION_SIZE[5], timerPeriod(500000),     1 }  // animation #5 (0,5 s)
+};
+
+/**
+ * @brief Définition du séquenceur d'animation.
+ * 
+ * @note Pour faciliter la lecture des animations, nous définissons un séquenceur
+ *       qui va nous permettre de gérer précisément comment doit se dérouler la
+ *       lecture périodique des animations et la gestion des paramètres afférents.
+ */
+struct Player {
+    uint8_t   animation_id; // Indice de l'animation en cours.
+    uint16_t  repeat;       // Nombre de répétitions effectuées.
+    uint8_t   frame;        // Indice du motif binaire relatif à l'animation en cours.
+    uint8_t   pattern;      // Motif à afficher lors de la prochaine interruption.
+    Animation animation;    // Copie en SRAM du descripteur de l'animation en cours.
+};
+
+/**
+ * @brief Initalisation du séquenceur.
+ * 
+ * @note Tous les paramètres sont initialisés à zéro par défaut.
+ * 
+ *       Le séquenceur n'est manipulé que par la routine d'interruption du
+ *       Timer1. Si la boucle principale devait le consulter ou le modifier,
+ *       elle devrait le faire en suspendant les interruptions (cli() ... SREG).
+ */
+Player player = {
+    0, // animation_id
+    0, // repeat
+    0, // frame
+    0, // pattern
+    {} // animation
+};
+
+// ----------------------------------------------------------------------------
+// Gestion des LEDs
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Initialisation des broches de commande des LEDs.
+ */
+void initLeds() {
+
+    Leds::begin();
+
+}
+
+/**
+ * @brief Affichage d'un motif binaire 8-bits sur le chenillard à 8 LEDs.
+ * 
+ * @param n Entier compris dans l'intervalle [0,255].
+ * 
+ * @note Comme dans l'exercice 05, les registres PORTD et PORTB sont écrits
+ *       directement, chacun en une seule fois, plutôt que LED par LED avec
+ *       digitalWrite().
+ * 
+ *       Le câblage étant connu à la compilation, la classe Chaser effectue
+ *       ce calcul sans boucle ni lecture en table : un décalage et un masque
+ *       par port suffisent lorsque les LEDs sont branchées dans l'ordre.
+ */
+void ledWrite(const Leds::Frame pattern) {
+
+    BENCH_MARK(BENCH_WRITE_BEGIN);
+
+    Leds::write(pattern);
+
+    BENCH_MARK(BENCH_WRITE_END);
+
+}
+
+// ----------------------------------------------------------------------------
+// Lecture des données en mémoire flash
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Lecture d'un motif binaire en mémoire flash.
+ * 
+ * @param index Indice du motif dans le tableau `ANIMATION_FRAME`.
+ */
+uint8_t readFrame(const uint16_t index) {
+
+    return pgm_read_byte(&ANIMATION_FRAME.frame[index]);
+
+}
+
+/**
+ * @brief Lecture du descripteur d'une animation en mémoire flash.
+ * 
+ * @param index      Indice de l'animation (0 ≤ index < NUM_ANIMATIONS).
+ * @param pAnimation Structure de données en SRAM qui reçoit la copie.
+ */
+void readAnimation(const uint8_t index, Animation * const pAnimation) {
+
+    memcpy_P(pAnimation, &animation[index], sizeof(Animation));
+
+}
+
+// ----------------------------------------------------------------------------
+// Gestion des animations
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Lancement d'une animation.
+ * 
+ * @param index Indice de l'animation à lancer (0 ≤ index < NUM_ANIMATIONS)
+ * 
+ * @note On effectue l'initialisation des propriétés du séquenceur avec les données
+ *       de prise en charge de la nouvelle animation qui va démarrer. Le descripteur
+ *       de l'animation est recopié une fois pour toutes depuis la mémoire flash.
+ */
+void startAnimation(const uint8_t index) {
+
+    BENCH_MARK(BENCH_ANIMATION);
+
+    player.animation_id = index;
+    player.repeat       = 0;
+    player.frame        = 0;
+
+    readAnimation(index, &player.animation);
+
+}
+
+/**
+ * @brief Lecture incrémentale de l'animation courante.
+ * 
+ * @note Cette fonction est appelée par la routine d'interruption du Timer1.
+ *       Le motif à afficher a été lu à l'appel précédent : il est écrit sur
+ *       les ports dès l'entrée dans la fonction, de sorte que le délai entre
+ *       l'interruption et l'allumage des LEDs reste le même quel que soit le
+ *       motif, y compris lorsqu'une nouvelle animation démarre.
+ * 
+ *       La durée d'affichage de ce motif est programmée dans la foulée, avant
+ *       que la tête de lecture ne passe éventuellement à l'animation suivante.
+ */
+void playAnimation() {
+
+    BENCH_MARK(BENCH_PLAY_BEGIN);
+
+    // Définition d'un pointeur sur la structure de donnée qui décrit
+    // l'animation courante (la copie détenue par le séquenceur),
+    // permettant d'accéder directement à ses propriétés sans faire
+    // de copie locale.
+    // 
+    // Le mot-clef `const` utilisé 2 fois ici déclare que :
+    //   1. la structure de données pointée est constante,
+    //   2. le pointeur lui-même est de valeur constante,
+    const Animation * const pAnimation = &player.animation;
+
+    // Affichage du motif préparé lors de l'appel précédent :
+    ledWrite(player.pattern);
+
+    // Le compteur du Timer1 vient de repartir de zéro : la prochaine
+    // interruption surviendra lorsqu'il aura atteint la valeur de OCR1A,
+    // c'est-à-dire au terme de la durée d'affichage du motif.
+    timebaseSet(pAnimation->frame_period);
+    BENCH_TIMER1_PERIOD();
+
+    // Déplacement de la tête de lecture du séquenceur.
+    // Si l'animation courante n'est pas terminée...
+    if (player.frame + 1 < pAnimation->frames) {
+
+        // Alors on déplace la tête de lecture au prochain motif binaire
+        // de l'animation courante :
+        player.frame++;
+
+    // Sinon, c'est qu'on est arrivé au terme de l'animation courante.
+    } else {
+
+        // Auquel cas, on vérifie si on doit la répéter à nouveau...
+        if (player.repeat + 1 < pAnimation->repeat) {
+
+            // Il faut alors replacer la tête de lecture au début de l'animation :
+            player.frame = 0;
+            // Et incrémenter le nombre de répétitions opérées sur l'animation :
+            player.repeat++;
+
+        // Si l'animation ne devait pas être répétée une nouvelle fois,
+        // c'est que nous devons passer à la prochaine animation...
+        } else {
+
+            // L'indice de la nouvelle animation est donc incrémenté,
+            // et on vérifie également s'il ne faut pas redémarrer
+            // tout le processus à la première animation définie
+            // dans le tableau `ANIMATION_FRAME`, une fois qu'on a
+            // fait le tour de toutes les animations définies.
+            ++player.animation_id %= NUM_ANIMATIONS;
+
+            // Il ne reste plus qu'à lancer la nouvelle animation :
+            startAnimation(player.animation_id);
+
+        }
+
+    }
+
+    // Lecture du prochain motif à afficher, en dehors du chemin critique :
+    player.pattern = readFrame(pAnimation->start + player.frame);
+
+    BENCH_MARK(BENCH_PLAY_END);
+
+}
+
+// ----------------------------------------------------------------------------
+// Cadencement par le Timer1
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Configuration des timers.
+ * 
+ * @note Le Timer1 mesure la durée d'affichage de chaque motif (voir
+ *       lib/Timebase). Le framework Arduino configure le Timer1 en mode PWM
+ *       pour analogWrite() sur les broches D9 et D10 : on écrase entièrement
+ *       cette configuration. La fonction analogWrite() ne doit donc plus être
+ *       utilisée sur ces broches.
+ * 
+ *       L'interruption de débordement du Timer0, qui entretient millis(), est
+ *       désactivée : survenant toutes les 1,024 ms, elle retarderait de
+ *       quelques microsecondes l'affichage des motifs qu'elle croise, ce qui
+ *       n'est plus négligeable devant des durées de 20 µs. Le programme ne
+ *       doit donc plus compter sur millis(), micros() ni delay().
+ */
+void initTimer() {
+
+    TIMSK0 &= ~_BV(TOIE0);
+
+    timebaseBegin();
+
+}
+
+/**
+ * @brief Routine d'interruption du Timer1 : affichage du motif suivant.
+ * 
+ * @note Estimation de sa durée, en cycles d'horloge, d'après les durées des
+ *       instructions données par la documentation de l'ATmega328P, en
+ *       supposant que playAnimation() n'est pas intégrée à la routine (tous
+ *       les registres à la charge de l'appelé sont alors sauvegardés). Elle
+ *       reste à confirmer sur le listing du programme (avr-objdump -d) :
+ * 
+ *         fin de l'instruction en cours, prise en charge, saut    ≤ 11
+ *         sauvegarde de SREG et de 14 registres                      32
+ *         appel de playAnimation(), registres préservés              12
+ *         ledWrite()                                                ≈ 22
+ *         timebaseSet(), changement d'horloge compris               ≤ 23
+ *         avancée de la tête de lecture                             ≈ 19
+ *         readFrame()                                               ≈ 16
+ *         retours et restauration des registres                      47
+ *                                                     chemin courant ≈ 182
+ *         passage à l'animation suivante (modulo, __udivmodqi4)     ≈ 77
+ *         startAnimation(), memcpy_P() de 8 octets à 9 cycles      ≈ 126
+ *                                                         pire cas ≈ 385
+ * 
+ *       Les ports sont écrits environ 71 cycles (4,4 µs) après l'égalité du
+ *       compteur, et OCR1A l'est après 85 cycles : bien avant que le compteur
+ *       n'atteigne sa nouvelle valeur, même à 20 µs (320 cycles).
+ * 
+ *       À 20 µs, le chemin courant laisse environ 140 cycles par motif à la
+ *       boucle principale. En revanche, à la fin de l'animation #2, la routine
+ *       dépasse la période d'environ 65 cycles : l'interruption suivante est
+ *       servie en retard, et le premier motif de l'animation #3 s'affiche
+ *       environ 4 µs trop tard. Le compteur n'étant pas remis à zéro (le
+ *       pré-diviseur ne change pas), ce retard ne se cumule pas.
+ */
+ISR(TIMER1_COMPA_vect) {
+
+    playAnimation();
+
+}
+
+// ----------------------------------------------------------------------------
+// Squelette principal du programme
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Démarrage du programme.
+ */
+void setup() {
+
+    initLeds();
+    startAnimation(0);
+    player.pattern = readFrame(player.animation.start);
+    initTimer();
+
+}
+
+/**
+ * @brief Boucle de contrôle principale.
+ * 
+ * @note L'animation se déroule entièrement sous interruption : la boucle
+ *       principale est libre pour la lecture des entrées, les communications,
+ *       etc. Elle ne doit cependant pas appeler delay(), qui attendrait
+ *       indéfiniment l'avancée de millis() (voir initTimer()).
+ */
+void loop() {
+
+    BENCH_MARK(BENCH_LOOP);
+
+}
\ No newline at end of file
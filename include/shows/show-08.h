@@ -0,0 +1,125 @@
+/*
+ * -------------------------------------------------------------------------
+ * Spectacle généré par tools/show_compile.py à partir de show-08.show
+ * Ne pas modifier ce fichier : modifier la description, puis la recompiler.
+ * -------------------------------------------------------------------------
+ *
+ * Mémoire flash : 107 octets (67 motifs, 8 descripteurs de 5 octets)
+ * Mémoire vive  : 5 octets (copie du descripteur de l'animation en cours)
+ * Motifs joués  : 89, stockés : 67
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <Transition.h>
+
+/**
+ * @brief Nombre d'animations au programme du spectacle.
+ */
+const uint8_t NUM_ANIMATIONS = 8;
+
+/**
+ * @brief Motifs de toutes les animations, dans un seul tableau.
+ *
+ * @note Une séquence commune à plusieurs animations n'y figure qu'une fois.
+ */
+const uint8_t ANIMATION_FRAME[] PROGMEM = {
+    0b00000000, // rebond
+    0b00010000,
+    0b00001000,
+    0b00010000,
+    0b00100000,
+    0b00010000,
+    0b00001000,
+    0b00000100,
+    0b00001000,
+    0b00010000,
+    0b00100000,
+    0b01000000,
+    0b00100000,
+    0b00010000,
+    0b00001000,
+    0b00000100,
+    0b00000010,
+    0b00000100,
+    0b00001000,
+    0b00010000,
+    0b00100000,
+    0b01000000,
+    0b10000000, // balayage
+    0b01000000,
+    0b00100000,
+    0b00010000,
+    0b00001000,
+    0b00000100,
+    0b00000010,
+    0b00000001, // montee
+    0b00000010,
+    0b00000100,
+    0b00001000,
+    0b00010000,
+    0b00100000,
+    0b01000000,
+    0b10000000,
+    0b11100000, // trio
+    0b01110000,
+    0b00111000,
+    0b00011100,
+    0b00001110,
+    0b00000111,
+    0b00001110,
+    0b00011100,
+    0b00111000,
+    0b01110000,
+    0b00000000, // pulsation
+    0b00011000,
+    0b00111100,
+    0b01111110,
+    0b11111111,
+    0b01111110,
+    0b00111100,
+    0b00011000,
+    0b10000001, // ouverture
+    0b01000010,
+    0b00100100,
+    0b00011000,
+    0b00100100,
+    0b01000010,
+    0b00010001, // diagonale
+    0b00100010,
+    0b01000100,
+    0b10001000,
+    0b01010101, // alternance
+    0b10101010
+};
+
+/**
+ * @brief Descripteur d'une animation.
+ *
+ * @note L'indice de départ tient sur 8 bits : le séquenceur n'a pas de
+ *       calcul plus large à effectuer pour lire un motif.
+ */
+struct Animation {
+    uint8_t    start;          // Indice du motif de départ dans le tableau.
+    uint8_t    frames;         // Nombre de motifs constituant la séquence.
+    uint8_t    frame_delay_ms; // Durée d'affichage de chaque motif exprimée en millisecondes.
+    uint8_t    repeat;         // Nombre de répétitions de la séquence.
+    Transition transition;     // Transition qui amène cette animation (voir lib/Transition).
+};
+
+static_assert(sizeof(Animation) == 5, "Descripteur d'animation inattendu.");
+
+/**
+ * @brief Animations, dans l'ordre de lecture.
+ */
+const Animation animation[] PROGMEM = {
+    {    22,  14,  40,   4, DISSOLVE   }, // balayage   #0
+    {    55,   6,  50,   8, WIPE_OUT   }, // ouverture  #1
+    {    37,  10,  50,   5, SLIDE_DOWN }, // trio       #2
+    {    47,   8,  50,   6, WIPE_OUT   }, // pulsation  #3
+    {    65,   2, 120,  10, DISSOLVE   }, // alternance #4
+    {    61,   4,  80,   8, WIPE_UP    }, // diagonale  #5
+    {    29,   8,  60,   7, SLIDE_UP   }, // montee     #6
+    {     0,  37,  40,   1, WIPE_DOWN  }  // rebond     #7
+};
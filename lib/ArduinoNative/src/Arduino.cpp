@@ -0,0 +1,982 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Couche d'abstraction Arduino pour la machine hôte (environnement native)
+ * -------------------------------------------------------------------------
+ */
+
+#include "Arduino.h"
+#include "avr/eeprom.h"
+#include "avr/sleep.h"
+#include "Vcd.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+
+// ----------------------------------------------------------------------------
+// État de la carte simulée
+// ----------------------------------------------------------------------------
+
+hal::Port PORTB(8);
+hal::Port PORTC(14);
+hal::Port PORTD(0);
+
+uint8_t DDRB;
+uint8_t DDRC;
+uint8_t DDRD;
+
+uint8_t SREG = 0x80;
+
+hal::MarkerRegister GPIOR0;
+uint8_t             GPIOR1;
+uint8_t             GPIOR2;
+
+uint8_t TIMSK0 = _BV(TOIE0);
+
+uint8_t SMCR;
+
+uint8_t        TCCR1A;
+uint8_t        TCCR1B;
+hal::Counter16 TCNT1;
+uint16_t       OCR1A;
+uint8_t        TIMSK1;
+uint8_t        TIFR1;
+
+hal::PrescalerReset GTCCR;
+
+hal::SerialData   UDR0;
+hal::SerialStatus UCSR0A;
+uint8_t           UCSR0B;
+uint8_t           UCSR0C;
+uint16_t          UBRR0;
+
+uint8_t      SPCR;
+uint8_t      SPSR;
+hal::SpiData SPDR;
+
+/**
+ * @brief Routines d'interruption par défaut, remplacées par celles du programme.
+ */
+extern "C" __attribute__((weak)) void TIMER1_COMPA_vect(void) {}
+extern "C" __attribute__((weak)) void USART_RX_vect(void) {}
+extern "C" __attribute__((weak)) void SPI_STC_vect(void) {}
+
+/**
+ * @brief Points d'entrée par défaut, remplacés par ceux de l'exercice compilé
+ *        (un programme de test peut ne pas les définir).
+ */
+__attribute__((weak)) void setup() {}
+__attribute__((weak)) void loop() {}
+
+namespace hal {
+
+/**
+ * @brief Nombre de cycles d'horloge par microseconde.
+ */
+static const uint64_t CYCLES_PER_US = F_CPU / 1000000;
+
+/**
+ * @brief Date courante sur l'horloge virtuelle (en cycles d'horloge).
+ */
+static uint64_t clock_cycles;
+
+/**
+ * @brief État du Timer1 : valeur du compteur à une date donnée.
+ */
+static uint16_t timer1_count;
+static uint64_t timer1_sync;
+
+/**
+ * @brief État de la liaison série : flux émis par l'hôte, date d'arrivée du
+ *        prochain octet, dernier octet reçu et octets émis par le programme.
+ */
+static std::vector<uint8_t> serial_in;
+static size_t               serial_pos;
+static uint64_t             serial_interval;
+static uint64_t             serial_next;
+static uint8_t              serial_rx;
+static std::string          serial_out;
+
+/**
+ * @brief Contenu de l'EEPROM, et date de fin de l'écriture en cours.
+ */
+static uint8_t  eeprom[E2END + 1] = { 0 };
+static bool     eeprom_erased;
+static uint64_t eeprom_busy_until;
+
+/**
+ * @brief Durée d'écriture d'un octet en EEPROM (3,3 ms).
+ */
+static const uint64_t EEPROM_WRITE_CYCLES = 3300 * CYCLES_PER_US;
+
+/**
+ * @brief État du bus SPI : octet en cours d'émission et date de fin de
+ *        l'émission (UINT64_MAX si le bus est libre).
+ */
+static uint8_t  spi_tx;
+static uint64_t spi_done = UINT64_MAX;
+
+/**
+ * @brief État de la chaîne de registres à décalage : bits émis depuis le
+ *        dernier verrouillage (dans l'ordre d'émission), niveaux des sorties
+ *        et nombre de verrouillages.
+ */
+static std::vector<uint8_t> shift_bits;
+static std::vector<uint8_t> shift_out;
+static uint64_t             shift_latches;
+
+/**
+ * @brief Trace des changements d'état des broches.
+ */
+static std::vector<PinEvent> pin_trace;
+static uint64_t              trace_events;
+
+/**
+ * @brief Enregistreur VCD, qui remplace la trace en mémoire s'il est ouvert.
+ */
+static VcdWriter vcd;
+
+/**
+ * @brief Consigne un changement d'état.
+ */
+static void record(const PinEvent &e) {
+
+    trace_events++;
+
+    if (vcd.isOpen()) vcd.write(e);
+    else              pin_trace.push_back(e);
+
+}
+
+static void shiftLatch();
+
+void Port::write(const uint8_t value) {
+
+    const uint8_t changed = value_ ^ value;
+
+    for (uint8_t i=0; i<8; i++) {
+        if (changed & (1 << i)) {
+            record({ now(), uint16_t(first_pin_ + i), uint8_t((value >> i) & 0x1) });
+        }
+    }
+
+    value_ = value;
+
+    // Front montant du verrou de la chaîne de registres à décalage (D10).
+    if (this == &PORTB && (changed & value & _BV(2))) shiftLatch();
+
+}
+
+// ----------------------------------------------------------------------------
+// Marqueurs de la bibliothèque Bench
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Identifiant du marqueur d'affichage d'un motif (BENCH_FRAME).
+ */
+static const uint8_t MARKER_FRAME = 7;
+
+/**
+ * @brief Bilan des périodes d'affichage, et date du dernier motif affiché.
+ */
+static FrameStats frame_stats;
+static bool       frame_seen;
+static uint64_t   frame_at_us;
+static uint16_t   frame_ms;
+
+/**
+ * @brief Identifiant du marqueur d'affichage d'un motif dont la durée est
+ *        programmée dans le Timer1 (BENCH_FRAME_TIMER1).
+ */
+static const uint8_t MARKER_FRAME_TIMER1 = 8;
+
+/**
+ * @brief Bilans des durées programmées dans le Timer1, indexés par la durée
+ *        programmée, et date (en cycles) et durée programmée du dernier motif.
+ */
+static std::map<uint32_t, PeriodStats> period_stats;
+static bool                            period_seen;
+static uint64_t                        period_at;
+static uint32_t                        period_cycles;
+
+static uint16_t timer1Prescaler();
+
+MarkerRegister &MarkerRegister::operator=(const uint8_t value) {
+
+    value_ = value;
+
+    if (value == MARKER_FRAME) {
+
+        const uint64_t t = now();
+
+        if (frame_seen) {
+            const double actual_ms = (t - frame_at_us) / 1000.0;
+            const double late_ms   = actual_ms - frame_ms;
+            frame_stats.intended_ms += frame_ms;
+            frame_stats.actual_ms   += actual_ms;
+            if (late_ms > frame_stats.max_late_ms) frame_stats.max_late_ms = late_ms;
+            frame_stats.frames++;
+        }
+
+        frame_seen  = true;
+        frame_at_us = t;
+        frame_ms    = GPIOR1 | (GPIOR2 << 8);
+
+    }
+
+    if (value == MARKER_FRAME_TIMER1) {
+
+        if (period_seen) {
+            PeriodStats &p = period_stats[period_cycles];
+            const int64_t error = int64_t(clock_cycles - period_at) - period_cycles;
+            if (p.frames == 0 || error < p.min_error) p.min_error = error;
+            if (p.frames == 0 || error > p.max_error) p.max_error = error;
+            p.intended_cycles = period_cycles;
+            p.actual_cycles  += clock_cycles - period_at;
+            p.frames++;
+        }
+
+        period_seen   = true;
+        period_at     = clock_cycles;
+        period_cycles = (uint32_t(OCR1A) + 1) * timer1Prescaler();
+
+    }
+
+    return *this;
+
+}
+
+const FrameStats &frameStats() { return frame_stats; }
+
+std::vector<PeriodStats> periodStats() {
+
+    std::vector<PeriodStats> stats;
+
+    for (const auto &p : period_stats) stats.push_back(p.second);
+
+    return stats;
+
+}
+
+// ----------------------------------------------------------------------------
+// Timer1
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Facteur de division de l'horloge du Timer1 (0 si le timer est arrêté).
+ */
+static uint16_t timer1Prescaler() {
+
+    static const uint16_t PRESCALER[] = { 0, 1, 8, 64, 256, 1024, 0, 0 };
+
+    return PRESCALER[TCCR1B & 0x07];
+
+}
+
+/**
+ * @brief Met à jour le compteur du Timer1 jusqu'à la date courante.
+ */
+static void timer1Sync() {
+
+    const uint16_t prescaler = timer1Prescaler();
+
+    if (prescaler == 0) {
+        timer1_sync = clock_cycles;
+        return;
+    }
+
+    const uint64_t ticks = (clock_cycles - timer1_sync) / prescaler;
+
+    timer1_count += uint16_t(ticks);
+    timer1_sync  += ticks * prescaler;
+
+}
+
+/**
+ * @brief Date de la prochaine égalité entre le compteur et OCR1A.
+ */
+static uint64_t timer1NextMatch() {
+
+    const uint16_t prescaler = timer1Prescaler();
+
+    if (prescaler == 0) return UINT64_MAX;
+
+    const uint32_t ticks = timer1_count <= OCR1A
+        ? uint32_t(OCR1A - timer1_count) + 1
+        : 0x10000 - timer1_count + OCR1A + 1;
+
+    return timer1_sync + uint64_t(ticks) * prescaler;
+
+}
+
+/**
+ * @brief Traitement d'une égalité entre le compteur et OCR1A.
+ *
+ * @return `true` si la routine d'interruption a été exécutée.
+ */
+static bool timer1Match() {
+
+    timer1Sync();
+
+    // En mode CTC, le compteur repart de zéro.
+    if (TCCR1B & _BV(WGM12)) timer1_count = 0;
+
+    TIFR1 |= _BV(OCF1A);
+
+    if ((TIMSK1 & _BV(OCIE1A)) && (SREG & 0x80)) {
+
+        TIFR1 &= ~_BV(OCF1A);
+
+        cli();
+        TIMER1_COMPA_vect();
+        sei();
+
+        timer1Sync();
+
+        return true;
+
+    }
+
+    return false;
+
+}
+
+Counter16::operator uint16_t() const {
+
+    timer1Sync();
+    return timer1_count;
+
+}
+
+Counter16 &Counter16::operator=(const uint16_t value) {
+
+    timer1Sync();
+    timer1_count = value;
+    return *this;
+
+}
+
+PrescalerReset &PrescalerReset::operator=(const uint8_t value) {
+
+    // Les fractions de top déjà écoulées sont abandonnées.
+    if (value & _BV(PSRSYNC)) {
+        timer1Sync();
+        timer1_sync = clock_cycles;
+    }
+
+    return *this;
+
+}
+
+// ----------------------------------------------------------------------------
+// USART0
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Durée de transmission d'un octet sur la liaison (en cycles d'horloge) :
+ *        un bit de start, 8 bits de données et un bit de stop.
+ */
+static uint64_t serialByteCycles() {
+
+    return 10 * uint64_t(UCSR0A & _BV(U2X0) ? 8 : 16) * (UBRR0 + 1);
+
+}
+
+/**
+ * @brief Date d'arrivée du prochain octet émis par l'hôte.
+ */
+static uint64_t serialNextArrival() {
+
+    return serial_pos < serial_in.size() ? serial_next : UINT64_MAX;
+
+}
+
+/**
+ * @brief Réception d'un octet émis par l'hôte.
+ *
+ * @return `true` si la routine d'interruption a été exécutée.
+ */
+static bool serialArrival() {
+
+    timer1Sync();
+
+    const uint8_t value = serial_in[serial_pos++];
+    serial_next += std::max(serial_interval, serialByteCycles());
+
+    // Un octet qui arrive alors que le récepteur est désactivé est ignoré,
+    // et un octet qui arrive avant que le précédent ait été lu est perdu.
+    if (!(UCSR0B & _BV(RXEN0))) return false;
+
+    if (UCSR0A & _BV(RXC0)) {
+        UCSR0A |= _BV(DOR0);
+        return false;
+    }
+
+    serial_rx = value;
+    UCSR0A |= _BV(RXC0);
+
+    if ((UCSR0B & _BV(RXCIE0)) && (SREG & 0x80)) {
+
+        cli();
+        USART_RX_vect();
+        sei();
+
+        timer1Sync();
+
+        return true;
+
+    }
+
+    return false;
+
+}
+
+SerialData::operator uint8_t() const {
+
+    UCSR0A &= uint8_t(~(_BV(RXC0) | _BV(DOR0)));
+    return serial_rx;
+
+}
+
+SerialData &SerialData::operator=(const uint8_t value) {
+
+    if (UCSR0B & _BV(TXEN0)) {
+        serial_out.push_back(char(value));
+        UCSR0A |= _BV(TXC0);
+    }
+
+    return *this;
+
+}
+
+void serialInput(const std::vector<uint8_t> &data, const uint32_t bytes_per_second) {
+
+    serial_in       = data;
+    serial_pos      = 0;
+    serial_interval = bytes_per_second ? F_CPU / bytes_per_second : 0;
+    serial_next     = clock_cycles + std::max(serial_interval, serialByteCycles());
+
+}
+
+const std::string &serialOutput() { return serial_out; }
+
+// ----------------------------------------------------------------------------
+// SPI et chaîne de registres à décalage
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Durée d'émission d'un octet sur le bus (en cycles d'horloge).
+ */
+static uint64_t spiByteCycles() {
+
+    static const uint8_t DIVIDER[] = { 4, 16, 64, 128 };
+
+    const uint8_t divider = DIVIDER[SPCR & (_BV(SPR1) | _BV(SPR0))];
+
+    return 8 * uint64_t(SPSR & _BV(SPI2X) ? divider / 2 : divider);
+
+}
+
+/**
+ * @brief Fin de l'émission d'un octet.
+ *
+ * @return `true` si la routine d'interruption a été exécutée.
+ */
+static bool spiTransfer() {
+
+    timer1Sync();
+
+    spi_done = UINT64_MAX;
+
+    for (uint8_t i=0; i<8; i++) {
+        const uint8_t bit = SPCR & _BV(DORD) ? i : 7 - i;
+        shift_bits.push_back((spi_tx >> bit) & 0x1);
+    }
+
+    SPSR |= _BV(SPIF);
+
+    if ((SPCR & _BV(SPIE)) && (SREG & 0x80)) {
+
+        SPSR &= ~_BV(SPIF);
+
+        cli();
+        SPI_STC_vect();
+        sei();
+
+        timer1Sync();
+
+        return true;
+
+    }
+
+    return false;
+
+}
+
+/**
+ * @brief Transfert des bits émis sur les sorties de la chaîne.
+ */
+static void shiftLatch() {
+
+    if (shift_bits.empty()) return;
+
+    const size_t n = shift_bits.size();
+
+    if (shift_out.size() != n) shift_out.assign(n, 0);
+
+    for (size_t p=0; p<n; p++) {
+        const uint8_t level = shift_bits[n - 1 - p];
+        if (level != shift_out[p]) {
+            record({ now(), uint16_t(SHIFT_PIN_BASE + p), level });
+            shift_out[p] = level;
+        }
+    }
+
+    shift_bits.clear();
+    shift_latches++;
+
+}
+
+SpiData::operator uint8_t() const {
+
+    SPSR &= ~(_BV(SPIF) | _BV(WCOL));
+    return 0;
+
+}
+
+SpiData &SpiData::operator=(const uint8_t value) {
+
+    if ((SPCR & (_BV(SPE) | _BV(MSTR))) != (_BV(SPE) | _BV(MSTR))) return *this;
+
+    if (spi_done != UINT64_MAX) {
+        SPSR |= _BV(WCOL);
+        return *this;
+    }
+
+    SPSR    &= ~(_BV(SPIF) | _BV(WCOL));
+    spi_tx   = value;
+    spi_done = clock_cycles + spiByteCycles();
+
+    return *this;
+
+}
+
+uint64_t shiftLatches() { return shift_latches; }
+
+size_t shiftOutputs() { return shift_out.size(); }
+
+// ----------------------------------------------------------------------------
+// EEPROM
+// ----------------------------------------------------------------------------
+
+bool eepromReady() { return clock_cycles >= eeprom_busy_until; }
+
+/**
+ * @brief Case de l'EEPROM désignée par une adresse, après attente de la fin
+ *        de l'écriture en cours.
+ */
+static uint8_t &eepromCell(const void *p) {
+
+    if (!eeprom_erased) {
+        memset(eeprom, 0xff, sizeof(eeprom));
+        eeprom_erased = true;
+    }
+
+    if (!eepromReady()) advance((eeprom_busy_until - clock_cycles + CYCLES_PER_US - 1) / CYCLES_PER_US);
+
+    return eeprom[uintptr_t(p) & E2END];
+
+}
+
+/**
+ * @brief Démarrage de l'écriture d'un octet.
+ */
+static void eepromWrite(uint8_t &cell, const uint8_t value) {
+
+    cell = value;
+    eeprom_busy_until = clock_cycles + EEPROM_WRITE_CYCLES;
+
+}
+
+// ----------------------------------------------------------------------------
+// Horloge virtuelle
+// ----------------------------------------------------------------------------
+
+uint64_t now() { return clock_cycles / CYCLES_PER_US; }
+
+uint64_t cycles() { return clock_cycles; }
+
+/**
+ * @brief Durée cumulée des périodes de sommeil.
+ */
+static uint64_t sleep_cycles;
+
+/**
+ * @brief Traitement du prochain événement (égalité du Timer1, arrivée d'un
+ *        octet sur la liaison série, fin d'émission sur le bus SPI), s'il
+ *        survient au plus tard à la date `end`.
+ *
+ * @param ran Reçoit `true` si une routine d'interruption a été exécutée.
+ *
+ * @return `false` si aucun événement ne survient d'ici là.
+ */
+static bool nextEvent(const uint64_t end, bool &ran) {
+
+    const uint64_t match   = timer1NextMatch();
+    const uint64_t arrival = serialNextArrival();
+    const uint64_t sent    = spi_done;
+    const uint64_t next    = std::min({ match, arrival, sent });
+
+    if (next > end) return false;
+
+    clock_cycles = next;
+
+    ran = next == match   ? timer1Match()
+        : next == arrival ? serialArrival()
+        :                   spiTransfer();
+
+    return true;
+
+}
+
+void sleep() {
+
+    const uint64_t start = clock_cycles;
+    bool ran = false;
+
+    while (!ran) {
+        if (!nextEvent(UINT64_MAX, ran)) {
+            advance(1000);
+            break;
+        }
+    }
+
+    sleep_cycles += clock_cycles - start;
+
+    timer1Sync();
+
+}
+
+uint64_t sleepCycles() { return sleep_cycles; }
+
+void advance(const uint64_t us) {
+
+    const uint64_t end = clock_cycles + us * CYCLES_PER_US;
+
+    // Les événements sont traités dans l'ordre chronologique.
+    bool ran;
+    while (nextEvent(end, ran));
+
+    clock_cycles = end;
+
+    // Le programme reprend la main à cette date : toute modification des
+    // registres du timer prendra effet à partir d'ici.
+    timer1Sync();
+
+}
+
+void reset() {
+
+    clock_cycles = 0;
+
+    // On remet les registres à zéro sans consigner de changement d'état.
+    PORTB = 0; PORTC = 0; PORTD = 0;
+    pin_trace.clear();
+    trace_events = 0;
+
+    DDRB = DDRC = DDRD = 0;
+    SREG = 0x80;
+
+    GPIOR0 = 0;
+    GPIOR1 = GPIOR2 = 0;
+    frame_stats = {};
+    frame_seen  = false;
+    period_stats.clear();
+    period_seen = false;
+    frame_at_us = 0;
+    frame_ms    = 0;
+
+    TCCR1A = TCCR1B = TIMSK1 = TIFR1 = 0;
+    OCR1A  = 0;
+    timer1_count = 0;
+    timer1_sync  = 0;
+
+    UCSR0A = _BV(UDRE0);
+    UCSR0B = UCSR0C = 0;
+    UBRR0  = 0;
+    serial_in.clear();
+    serial_pos = 0;
+    serial_out.clear();
+
+    SPCR = SPSR = 0;
+    spi_done = UINT64_MAX;
+    shift_bits.clear();
+    shift_out.clear();
+    shift_latches = 0;
+
+    TIMSK0 = _BV(TOIE0);
+    SMCR   = 0;
+    sleep_cycles = 0;
+
+    eeprom_busy_until = 0;
+
+}
+
+const std::vector<PinEvent> &trace() { return pin_trace; }
+
+void clearTrace() { pin_trace.clear(); }
+
+uint64_t traceEvents() { return trace_events; }
+
+bool traceToVcd(const char *path) { return vcd.open(path); }
+
+uint64_t closeVcd() {
+
+    vcd.close(now());
+    return vcd.dropped();
+
+}
+
+void run(const uint64_t duration_us, const uint32_t step_us) {
+
+    run(duration_us, step_us, ::setup, ::loop);
+
+}
+
+void run(const uint64_t duration_us, const uint32_t step_us, void (*program_setup)(), void (*program_loop)()) {
+
+    const uint64_t end_us = now() + duration_us;
+
+    program_setup();
+
+    while (now() < end_us) {
+
+        const uint64_t before = clock_cycles;
+
+        program_loop();
+
+        // Une boucle qui a elle-même fait avancer l'horloge (avec delay())
+        // est considérée comme instantanée par ailleurs.
+        if (clock_cycles == before) advance(step_us);
+
+    }
+
+}
+
+} // namespace hal
+
+// ----------------------------------------------------------------------------
+// Fonctions du framework Arduino
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Registres associés à une broche numérique (D0 à D19).
+ */
+static hal::Port *pinPort(const uint8_t pin) {
+    return pin < 8 ? &PORTD : pin < 14 ? &PORTB : pin < 20 ? &PORTC : nullptr;
+}
+
+static uint8_t *pinDdr(const uint8_t pin) {
+    return pin < 8 ? &DDRD : pin < 14 ? &DDRB : pin < 20 ? &DDRC : nullptr;
+}
+
+static uint8_t pinBit(const uint8_t pin) {
+    return 1 << (pin < 8 ? pin : pin < 14 ? pin - 8 : pin - 14);
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+
+    hal::Port * const port = pinPort(pin);
+    if (port == nullptr) return;
+
+    uint8_t * const ddr = pinDdr(pin);
+    const uint8_t   bit = pinBit(pin);
+
+    if (mode == OUTPUT) {
+        *ddr |= bit;
+    } else {
+        *ddr &= ~bit;
+        if (mode == INPUT_PULLUP) *port |= bit; else *port &= ~bit;
+    }
+
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+
+    hal::Port * const port = pinPort(pin);
+    if (port == nullptr) return;
+
+    if (val == LOW) *port &= ~pinBit(pin); else *port |= pinBit(pin);
+
+}
+
+int digitalRead(uint8_t pin) {
+
+    hal::Port * const port = pinPort(pin);
+    return port != nullptr && (*port & pinBit(pin)) ? HIGH : LOW;
+
+}
+
+uint8_t eeprom_read_byte(const uint8_t *p) { return hal::eepromCell(p); }
+
+void eeprom_read_block(void *dst, const void *src, size_t n) {
+
+    for (size_t i=0; i<n; i++) {
+        static_cast<uint8_t *>(dst)[i] = eeprom_read_byte(static_cast<const uint8_t *>(src) + i);
+    }
+
+}
+
+void eeprom_write_byte(uint8_t *p, uint8_t value) { hal::eepromWrite(hal::eepromCell(p), value); }
+
+void eeprom_update_byte(uint8_t *p, uint8_t value) {
+
+    uint8_t &cell = hal::eepromCell(p);
+    if (cell != value) hal::eepromWrite(cell, value);
+
+}
+
+// Comme sur la carte, millis() et micros() débordent sur 32 bits.
+unsigned long millis() { return uint32_t(hal::now() / 1000); }
+unsigned long micros() { return uint32_t(hal::now()); }
+
+void delay(unsigned long ms)            { hal::advance(uint64_t(ms) * 1000); }
+void delayMicroseconds(unsigned int us) { hal::advance(us); }
+
+// ----------------------------------------------------------------------------
+// Programme principal de la simulation
+// ----------------------------------------------------------------------------
+
+#ifndef PIO_UNIT_TESTING
+
+/**
+ * @brief Exécute l'exercice compilé et affiche la trace des broches.
+ *
+ * @note Usage : program [--vcd fichier.vcd] [durée en secondes]
+ *                       [pas de loop() en µs]
+ *                       [fichier reçu sur la liaison série] [octets/s]
+ *
+ *       La durée de temps virtuel simulée vaut 10 s par défaut. Le pas entre
+ *       deux appels à loop() vaut 1000 µs par défaut : un pas plus long permet
+ *       de simuler une boucle principale chargée par d'autres traitements.
+ *
+ *       Le contenu du fichier éventuel est émis sur la liaison série, à la
+ *       cadence indiquée (au débit maximal de la liaison par défaut). Les
+ *       octets émis par le programme sont affichés sur la sortie d'erreur.
+ *
+ *       Chaque ligne de la sortie standard décrit un changement d'état :
+ *       date (µs), numéro de broche, niveau. Un résumé de la simulation
+ *       est affiché sur la sortie d'erreur.
+ *
+ *       Avec l'option --vcd, les changements d'état sont enregistrés au fil
+ *       de la simulation dans un fichier VCD, lisible par GTKWave, et la
+ *       sortie standard reste vide.
+ */
+int main(int argc, char **argv) {
+
+    if (argc > 2 && strcmp(argv[1], "--vcd") == 0) {
+
+        if (!hal::traceToVcd(argv[2])) {
+            fprintf(stderr, "%s : écriture impossible\n", argv[2]);
+            return 1;
+        }
+
+        argv[2] = argv[0];
+        argv   += 2;
+        argc   -= 2;
+
+    }
+
+    const double   seconds = argc > 1 ? atof(argv[1]) : 10.0;
+    const uint32_t step_us = argc > 2 ? atol(argv[2]) : 1000;
+
+    if (argc > 3) {
+
+        FILE * const f = fopen(argv[3], "rb");
+
+        if (f == nullptr) {
+            fprintf(stderr, "%s : lecture impossible\n", argv[3]);
+            return 1;
+        }
+
+        std::vector<uint8_t> data;
+        for (int c = fgetc(f); c != EOF; c = fgetc(f)) data.push_back(uint8_t(c));
+        fclose(f);
+
+        hal::serialInput(data, argc > 4 ? atol(argv[4]) : 0);
+
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    hal::run(uint64_t(seconds * 1e6), step_us);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const uint64_t dropped = hal::closeVcd();
+
+    for (const hal::PinEvent &e : hal::trace()) {
+        printf("%llu %u %u\n", (unsigned long long) e.time_us, e.pin, e.level);
+    }
+
+    fprintf(stderr, "%.3f s simulées en %.3f s (x%.0f), %llu changements d'état\n",
+            seconds, elapsed.count(), seconds / elapsed.count(), (unsigned long long) hal::traceEvents());
+
+    if (dropped) {
+        fprintf(stderr, "VCD : %llu changements d'état ignorés (sorties non déclarées)\n", (unsigned long long) dropped);
+    }
+
+    if (!hal::serialOutput().empty()) {
+        fprintf(stderr, "%s", hal::serialOutput().c_str());
+    }
+
+    // Bilan des marqueurs BENCH_FRAME, si le programme en a déposé
+    // (compilation avec la macro BENCH) :
+    const hal::FrameStats &f = hal::frameStats();
+
+    if (f.frames) {
+        fprintf(stderr, "période des motifs : n=%llu attendue=%.3f ms effective=%.3f ms retard max=%.3f ms dérive=%+.1f ms\n",
+                (unsigned long long) f.frames, f.intended_ms / f.frames, f.actual_ms / f.frames,
+                f.max_late_ms, f.actual_ms - f.intended_ms);
+    }
+
+    // Bilan des marqueurs BENCH_FRAME_TIMER1, par durée programmée :
+    const std::vector<hal::PeriodStats> periods = hal::periodStats();
+
+    if (!periods.empty()) {
+        fprintf(stderr, "durées programmées dans le Timer1 :\n");
+    }
+
+    const double cycles_per_us = F_CPU / 1e6;
+
+    for (const hal::PeriodStats &p : periods) {
+        fprintf(stderr, "  %12.4f µs  n=%-8llu effective=%.4f µs  écart min=%+.4f µs max=%+.4f µs\n",
+                p.intended_cycles / cycles_per_us, (unsigned long long) p.frames,
+                p.actual_cycles / cycles_per_us / p.frames,
+                p.min_error / cycles_per_us, p.max_error / cycles_per_us);
+    }
+
+    // Part du temps passé en sommeil, si le programme a mis le
+    // micro-contrôleur en sommeil :
+    if (hal::sleepCycles()) {
+        fprintf(stderr, "sommeil : %.2f %% du temps\n", 100.0 * hal::sleepCycles() / hal::cycles());
+    }
+
+    // Bilan de la chaîne de registres à décalage, si le programme l'a utilisée :
+    if (hal::shiftLatches()) {
+        fprintf(stderr, "registres à décalage : %zu sorties, %llu verrouillages (%.0f par seconde)\n",
+                hal::shiftOutputs(), (unsigned long long) hal::shiftLatches(), hal::shiftLatches() / seconds);
+    }
+
+    return 0;
+
+}
+
+#endif
@@ -0,0 +1,509 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Couche d'abstraction Arduino pour la machine hôte (environnement native)
+ * -------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Constantes et types du framework Arduino
+// ----------------------------------------------------------------------------
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT        0x0
+#define OUTPUT       0x1
+#define INPUT_PULLUP 0x2
+
+#define F_CPU 16000000UL
+
+typedef bool    boolean;
+typedef uint8_t byte;
+
+// ----------------------------------------------------------------------------
+// Horloge virtuelle et enregistrement de l'activité des broches
+// ----------------------------------------------------------------------------
+
+namespace hal {
+
+/**
+ * @brief Changement d'état d'une broche numérique.
+ */
+struct PinEvent {
+    uint64_t time_us; // Date du changement d'état sur l'horloge virtuelle.
+    uint16_t pin;     // Numéro de la broche (D0 à D19, ou sortie d'un 74HC595).
+    uint8_t  level;   // Nouveau niveau logique (LOW ou HIGH).
+};
+
+/**
+ * @brief Registre de port simulé.
+ *
+ * @note Le registre se manipule exactement comme les registres PORTx de
+ *       l'ATmega328P. Chaque écriture qui modifie le niveau d'une broche
+ *       est datée sur l'horloge virtuelle et consignée dans la trace.
+ */
+class Port {
+
+    public:
+
+        explicit Port(const uint8_t first_pin) : first_pin_(first_pin), value_(0) {}
+
+        operator uint8_t() const { return value_; }
+
+        Port &operator=(const uint8_t value)  { write(value);          return *this; }
+        Port &operator|=(const uint8_t value) { write(value_ | value); return *this; }
+        Port &operator&=(const uint8_t value) { write(value_ & value); return *this; }
+        Port &operator^=(const uint8_t value) { write(value_ ^ value); return *this; }
+
+        void write(const uint8_t value);
+
+    private:
+
+        uint8_t first_pin_; // Numéro de la broche associée au bit 0 du port.
+        uint8_t value_;     // Valeur courante du registre.
+
+};
+
+/**
+ * @brief Compteur 16 bits simulé (registre TCNT1).
+ *
+ * @note La valeur du compteur est calculée à la lecture, d'après l'horloge
+ *       virtuelle et la configuration du timer.
+ */
+class Counter16 {
+
+    public:
+
+        operator uint16_t() const;
+        Counter16 &operator=(const uint16_t value);
+
+};
+
+/**
+ * @brief Registre GTCCR simulé.
+ *
+ * @note Le bit PSRSYNC remet à zéro le pré-diviseur commun aux Timers 0 et
+ *       1 : le prochain top du Timer1 survient une période pleine plus tard.
+ */
+class PrescalerReset {
+
+    public:
+
+        operator uint8_t() const { return 0; }
+        PrescalerReset &operator=(const uint8_t value);
+
+};
+
+/**
+ * @brief Registre GPIOR0 simulé.
+ *
+ * @note Les marqueurs de la bibliothèque Bench y sont écrits lorsque la macro
+ *       BENCH est définie : chaque écriture est transmise à mark().
+ */
+class MarkerRegister {
+
+    public:
+
+        operator uint8_t() const { return value_; }
+
+        MarkerRegister &operator=(const uint8_t value);
+
+    private:
+
+        uint8_t value_ = 0;
+
+};
+
+/**
+ * @brief Registre UDR0 simulé.
+ *
+ * @note Une lecture retire l'octet reçu (et baisse le drapeau RXC0), une
+ *       écriture émet un octet, consigné dans serialOutput().
+ */
+class SerialData {
+
+    public:
+
+        operator uint8_t() const;
+        SerialData &operator=(const uint8_t value);
+
+};
+
+/**
+ * @brief Registre UCSR0A simulé.
+ *
+ * @note L'émission étant instantanée, le drapeau UDRE0 est toujours levé :
+ *       comme sur la carte, où il n'est accessible qu'en lecture, une
+ *       écriture du programme ne peut pas l'abaisser.
+ */
+class SerialStatus {
+
+    public:
+
+        operator uint8_t() const { return value_ | UDRE0_BIT; }
+
+        SerialStatus &operator=(const uint8_t value)  { value_ = value;  return *this; }
+        SerialStatus &operator|=(const uint8_t value) { value_ |= value; return *this; }
+        SerialStatus &operator&=(const uint8_t value) { value_ &= value; return *this; }
+
+    private:
+
+        static const uint8_t UDRE0_BIT = 1 << 5;
+
+        uint8_t value_ = 0;
+
+};
+
+/**
+ * @brief Registre SPDR simulé.
+ * 
+ * @note Une écriture lance l'émission d'un octet, qui dure 8 périodes de
+ *       l'horloge SCK. L'octet est alors décalé dans la chaîne de registres
+ *       à décalage simulée (voir shiftLatches()), le drapeau SPIF est levé
+ *       et l'interruption SPI_STC est déclenchée si elle est autorisée.
+ *       Une écriture pendant une émission est ignorée et lève WCOL.
+ */
+class SpiData {
+
+    public:
+
+        operator uint8_t() const;
+        SpiData &operator=(const uint8_t value);
+
+};
+
+/**
+ * @brief Numéro de broche attribué, dans la trace, à la première sortie de
+ *        la chaîne de registres à décalage.
+ */
+const uint16_t SHIFT_PIN_BASE = 100;
+
+/**
+ * @brief Nombre de verrouillages de la chaîne de registres à décalage.
+ * 
+ * @note Une chaîne de 74HC595 est simulée sur les broches du bus SPI :
+ *       données sur MOSI (D11), horloge sur SCK (D13) et verrou sur SS (D10).
+ *       Chaque front montant du verrou transfère les bits émis depuis le
+ *       verrouillage précédent sur les sorties : la sortie QA du premier
+ *       registre reçoit le dernier bit émis, et ainsi de suite le long de
+ *       la chaîne. La sortie d'indice `p` apparaît dans la trace sous le
+ *       numéro de broche SHIFT_PIN_BASE + p.
+ * 
+ *       La longueur de la chaîne est donc déduite du nombre de bits émis
+ *       entre deux verrouillages : seuls les verrouillages précédés d'au
+ *       moins un octet sont comptabilisés.
+ */
+uint64_t shiftLatches();
+
+/**
+ * @brief Nombre de sorties de la chaîne de registres à décalage (0 tant que
+ *        la chaîne n'a pas été verrouillée).
+ */
+size_t shiftOutputs();
+
+/**
+ * @brief Bilan de la période d'affichage des motifs, établi à partir des
+ *        marqueurs BENCH_FRAME (voir lib/Bench).
+ */
+struct FrameStats {
+    uint64_t frames;      // Nombre de périodes mesurées.
+    double   intended_ms; // Cumul des périodes attendues.
+    double   actual_ms;   // Cumul des périodes effectives.
+    double   max_late_ms; // Plus grand retard observé sur un motif.
+};
+
+/**
+ * @brief Bilan des périodes d'affichage depuis le lancement de la simulation.
+ *
+ * @note La dérive cumulée vaut `actual_ms - intended_ms`.
+ */
+const FrameStats &frameStats();
+
+/**
+ * @brief Bilan des durées d'affichage programmées dans le Timer1, établi à
+ *        partir des marqueurs BENCH_FRAME_TIMER1 (voir lib/Bench), pour l'une
+ *        des durées programmées.
+ */
+struct PeriodStats {
+    uint32_t intended_cycles; // Durée programmée : (OCR1A + 1) × pré-diviseur.
+    uint64_t frames;          // Nombre de motifs mesurés.
+    uint64_t actual_cycles;   // Cumul des durées effectives.
+    int64_t  min_error;       // Plus petit écart observé (cycles).
+    int64_t  max_error;       // Plus grand écart observé (cycles).
+};
+
+/**
+ * @brief Bilans des durées programmées dans le Timer1, par durée croissante.
+ */
+std::vector<PeriodStats> periodStats();
+
+/**
+ * @brief Date courante sur l'horloge virtuelle, exprimée en microsecondes.
+ */
+uint64_t now();
+
+/**
+ * @brief Date courante sur l'horloge virtuelle, exprimée en cycles d'horloge.
+ */
+uint64_t cycles();
+
+/**
+ * @brief Fait avancer l'horloge virtuelle.
+ *
+ * @note Les interruptions (Timer1, USART, SPI) qui surviennent pendant cet
+ *       intervalle sont déclenchées à leur date exacte.
+ */
+void advance(const uint64_t us);
+
+/**
+ * @brief Programme la réception d'un flux d'octets sur la liaison série.
+ *
+ * @param data           Octets émis par l'hôte.
+ * @param bytes_per_second Cadence d'émission de l'hôte.
+ *
+ * @note Les octets arrivent à intervalles réguliers, sans jamais dépasser le
+ *       débit de la liaison fixé par UBRR0 (10 bits par octet). Chaque octet
+ *       reçu lève le drapeau RXC0 et déclenche l'interruption USART_RX si elle
+ *       est autorisée. Un octet qui arrive alors que le précédent n'a pas été
+ *       lu est perdu et lève le drapeau DOR0 : contrairement à l'ATmega328P,
+ *       dont le récepteur dispose d'une file de 2 octets, la simulation n'en
+ *       conserve qu'un seul.
+ */
+void serialInput(const std::vector<uint8_t> &data, const uint32_t bytes_per_second);
+
+/**
+ * @brief Octets émis par le programme sur la liaison série.
+ */
+const std::string &serialOutput();
+
+/**
+ * @brief Réinitialise l'horloge virtuelle, les registres et la trace.
+ */
+void reset();
+
+/**
+ * @brief Trace des changements d'état des broches, dans l'ordre chronologique.
+ */
+const std::vector<PinEvent> &trace();
+
+/**
+ * @brief Vide la trace des changements d'état des broches.
+ */
+void clearTrace();
+
+/**
+ * @brief Nombre de changements d'état consignés depuis reset(), qu'ils
+ *        soient conservés dans la trace ou enregistrés dans un fichier VCD.
+ */
+uint64_t traceEvents();
+
+/**
+ * @brief Enregistre les changements d'état dans un fichier VCD, au fil de la
+ *        simulation, plutôt que dans la trace en mémoire (voir Vcd.h).
+ *
+ * @return `false` si le fichier ne peut pas être créé.
+ *
+ * @note La trace en mémoire reste alors vide : la mémoire occupée ne dépend
+ *       plus de la durée simulée.
+ */
+bool traceToVcd(const char *path);
+
+/**
+ * @brief Termine le fichier VCD à la date courante et le ferme.
+ *
+ * @return Nombre de changements d'état qui n'ont pas pu y être enregistrés.
+ */
+uint64_t closeVcd();
+
+/**
+ * @brief Exécute le programme pendant une durée donnée de temps virtuel.
+ *
+ * @param duration_us Durée de la simulation, exprimée en microsecondes.
+ * @param step_us     Pas d'avancement de l'horloge entre deux appels à loop().
+ *
+ * @note La fonction setup() est appelée une seule fois, puis loop() est appelée
+ *       en boucle. Le temps virtuel ne s'écoule qu'entre deux appels à loop()
+ *       (ou pendant un appel à delay()), de sorte que la simulation s'exécute
+ *       bien plus vite que le temps réel.
+ *
+ *       Un appel à loop() qui fait lui-même avancer l'horloge (avec delay())
+ *       n'est pas suivi d'un pas supplémentaire.
+ *
+ *       Avec le pas par défaut d'une milliseconde, chaque appel à loop() voit
+ *       une nouvelle valeur de millis() : c'est exactement ce que verrait une
+ *       boucle infiniment rapide sur la carte, puisque la valeur de millis()
+ *       ne change qu'une fois par milliseconde. Les programmes qui s'appuient
+ *       sur micros() devront utiliser un pas plus fin.
+ *
+ *       Les routines d'interruption s'exécutent entre deux appels à loop(),
+ *       jamais au beau milieu : les accès concurrents ne sont pas simulés.
+ */
+void run(const uint64_t duration_us, const uint32_t step_us = 1000);
+
+/**
+ * @brief Exécute un programme désigné par ses points d'entrée, plutôt que
+ *        les fonctions setup() et loop() globales.
+ *
+ * @note Plusieurs exercices peuvent ainsi être compilés dans un même
+ *       programme, chacun dans son propre espace de noms, et exécutés l'un
+ *       après l'autre (voir test/test_golden). L'état de la carte doit être
+ *       réinitialisé par reset() entre deux exécutions.
+ */
+void run(const uint64_t duration_us, const uint32_t step_us, void (*program_setup)(), void (*program_loop)());
+
+} // namespace hal
+
+// ----------------------------------------------------------------------------
+// Registres de l'ATmega328P
+// ----------------------------------------------------------------------------
+
+extern hal::Port PORTB; // Broches D8 à D13.
+extern hal::Port PORTC; // Broches D14 à D19 (A0 à A5).
+extern hal::Port PORTD; // Broches D0 à D7.
+
+extern uint8_t DDRB;
+extern uint8_t DDRC;
+extern uint8_t DDRD;
+
+extern uint8_t SREG;
+
+extern hal::MarkerRegister GPIOR0;
+extern uint8_t             GPIOR1;
+extern uint8_t             GPIOR2;
+
+inline void cli() { SREG &= 0x7f; }
+inline void sei() { SREG |= 0x80; }
+
+// Timer0 : le framework Arduino s'en sert pour millis(), micros() et delay().
+// Dans la simulation, ces fonctions lisent directement l'horloge virtuelle et
+// continuent donc de fonctionner même si l'interruption de débordement est
+// désactivée.
+
+extern uint8_t TIMSK0;
+
+#define TOIE0 0
+
+// Timer1 : seuls les modes normal et CTC (WGM12) sont simulés, ainsi que
+// l'interruption de comparaison A.
+
+extern uint8_t        TCCR1A;
+extern uint8_t        TCCR1B;
+extern hal::Counter16 TCNT1;
+extern uint16_t       OCR1A;
+extern uint8_t        TIMSK1;
+extern uint8_t        TIFR1;
+
+extern hal::PrescalerReset GTCCR;
+
+#define PSRSYNC 0
+
+#define CS10   0
+#define CS11   1
+#define CS12   2
+#define WGM12  3
+#define OCIE1A 1
+#define OCF1A  1
+
+#define _BV(bit) (1 << (bit))
+
+// USART0 : seule la réception (avec son interruption) est datée, l'émission
+// est instantanée.
+
+extern hal::SerialData   UDR0;
+extern hal::SerialStatus UCSR0A;
+extern uint8_t           UCSR0B;
+extern uint8_t           UCSR0C;
+extern uint16_t          UBRR0;
+
+#define RXC0   7
+#define TXC0   6
+#define UDRE0  5
+#define FE0    4
+#define DOR0   3
+#define U2X0   1
+#define RXCIE0 7
+#define RXEN0  4
+#define TXEN0  3
+#define UCSZ01 2
+#define UCSZ00 1
+
+// SPI : seul le mode maître est simulé. La durée de chaque émission est
+// fixée par le pré-diviseur d'horloge (SPR1, SPR0 et SPI2X).
+
+extern uint8_t      SPCR;
+extern uint8_t      SPSR;
+extern hal::SpiData SPDR;
+
+#define SPIE  7
+#define SPE   6
+#define DORD  5
+#define MSTR  4
+#define CPOL  3
+#define CPHA  2
+#define SPR1  1
+#define SPR0  0
+#define SPIF  7
+#define WCOL  6
+#define SPI2X 0
+
+// ----------------------------------------------------------------------------
+// Routines d'interruption (avr/interrupt.h)
+// ----------------------------------------------------------------------------
+
+#define ISR(vector, ...) extern "C" void vector(void)
+
+extern "C" void TIMER1_COMPA_vect(void);
+extern "C" void USART_RX_vect(void);
+extern "C" void SPI_STC_vect(void);
+
+inline void interrupts()   { sei(); }
+inline void noInterrupts() { cli(); }
+
+// ----------------------------------------------------------------------------
+// Accès à la mémoire flash (avr/pgmspace.h)
+// ----------------------------------------------------------------------------
+
+// La machine hôte n'a qu'un seul espace d'adressage : les données déclarées
+// PROGMEM se lisent comme n'importe quelle autre donnée.
+#define PROGMEM
+
+#define pgm_read_byte(addr)  (*(const uint8_t  *) (addr))
+#define pgm_read_word(addr)  (*(const uint16_t *) (addr))
+#define pgm_read_dword(addr) (*(const uint32_t *) (addr))
+
+#define memcpy_P memcpy
+
+// ----------------------------------------------------------------------------
+// Fonctions du framework Arduino
+// ----------------------------------------------------------------------------
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int  digitalRead(uint8_t pin);
+
+unsigned long millis();
+unsigned long micros();
+
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+// ----------------------------------------------------------------------------
+// Points d'entrée du programme Arduino
+// ----------------------------------------------------------------------------
+
+void setup();
+void loop();
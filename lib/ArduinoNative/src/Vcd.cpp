@@ -0,0 +1,158 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Enregistrement de la trace des broches au format VCD
+ * -------------------------------------------------------------------------
+ */
+
+#include "Vcd.h"
+
+namespace hal {
+
+/**
+ * @brief Nombre de broches numériques déclarées (D0 à D19).
+ */
+static const size_t NUM_PINS = 20;
+
+/**
+ * @brief Taille du tampon d'écriture du fichier.
+ */
+static const size_t BUFFER_SIZE = 1 << 16;
+
+bool VcdWriter::open(const char *path) {
+
+    close(0);
+
+    file_ = fopen(path, "w");
+
+    if (file_ == nullptr) return false;
+
+    setvbuf(file_, nullptr, _IOFBF, BUFFER_SIZE);
+
+    header_        = false;
+    time_us_       = 0;
+    shift_outputs_ = 0;
+    dropped_       = 0;
+    pending_.clear();
+
+    return true;
+
+}
+
+/**
+ * @brief Identifiant d'un signal : un ou plusieurs caractères imprimables,
+ *        de '!' à '~' (numération en base 94).
+ */
+std::string VcdWriter::id(size_t index) {
+
+    std::string s;
+
+    do {
+        s += char('!' + index % 94);
+        index /= 94;
+    } while (index);
+
+    return s;
+
+}
+
+/**
+ * @brief Écriture de l'en-tête : déclaration des signaux, puis valeurs
+ *        initiales (toutes les broches sont au niveau bas à la mise sous
+ *        tension).
+ */
+void VcdWriter::writeHeader() {
+
+    shift_outputs_ = shiftOutputs();
+
+    fprintf(file_, "$version ArduinoNative $end\n");
+    fprintf(file_, "$timescale 1 us $end\n");
+
+    fprintf(file_, "$scope module arduino $end\n");
+    for (size_t p=0; p<NUM_PINS; p++) {
+        fprintf(file_, "$var wire 1 %s D%zu $end\n", id(p).c_str(), p);
+    }
+    fprintf(file_, "$upscope $end\n");
+
+    if (shift_outputs_) {
+        fprintf(file_, "$scope module shift $end\n");
+        for (size_t p=0; p<shift_outputs_; p++) {
+            fprintf(file_, "$var wire 1 %s Q%zu $end\n", id(NUM_PINS + p).c_str(), p);
+        }
+        fprintf(file_, "$upscope $end\n");
+    }
+
+    fprintf(file_, "$enddefinitions $end\n");
+
+    fprintf(file_, "#0\n$dumpvars\n");
+    for (size_t i=0; i<NUM_PINS + shift_outputs_; i++) {
+        fprintf(file_, "0%s\n", id(i).c_str());
+    }
+    fprintf(file_, "$end\n");
+
+    header_ = true;
+
+    for (const PinEvent &e : pending_) writeChange(e);
+    pending_.clear();
+    pending_.shrink_to_fit();
+
+}
+
+void VcdWriter::writeChange(const PinEvent &e) {
+
+    size_t index;
+
+    if (e.pin < NUM_PINS) {
+        index = e.pin;
+    } else if (e.pin >= SHIFT_PIN_BASE && size_t(e.pin - SHIFT_PIN_BASE) < shift_outputs_) {
+        index = NUM_PINS + e.pin - SHIFT_PIN_BASE;
+    } else {
+        dropped_++;
+        return;
+    }
+
+    if (e.time_us != time_us_) {
+        fprintf(file_, "#%llu\n", (unsigned long long) e.time_us);
+        time_us_ = e.time_us;
+    }
+
+    fprintf(file_, "%d%s\n", e.level ? 1 : 0, id(index).c_str());
+
+}
+
+void VcdWriter::write(const PinEvent &e) {
+
+    if (file_ == nullptr) return;
+
+    if (!header_) {
+        if (pending_.empty() || e.time_us == pending_.front().time_us) {
+            pending_.push_back(e);
+            return;
+        }
+        writeHeader();
+    }
+
+    writeChange(e);
+
+}
+
+void VcdWriter::close(const uint64_t end_us) {
+
+    if (file_ == nullptr) return;
+
+    if (!header_) writeHeader();
+
+    // La dernière date fixe la durée de la capture affichée par GTKWave.
+    if (end_us > time_us_) fprintf(file_, "#%llu\n", (unsigned long long) end_us);
+
+    fclose(file_);
+    file_ = nullptr;
+
+}
+
+} // namespace hal
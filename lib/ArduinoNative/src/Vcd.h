@@ -0,0 +1,90 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Enregistrement de la trace des broches au format VCD
+ * -------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include "Arduino.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace hal {
+
+/**
+ * @brief Enregistreur de la trace des broches dans un fichier VCD (Value
+ *        Change Dump, IEEE 1364), lisible par GTKWave comme la capture
+ *        d'un analyseur logique.
+ *
+ * @note Les changements d'état sont écrits dans le fichier au fur et à
+ *       mesure : la mémoire occupée reste constante, quelle que soit la
+ *       durée simulée.
+ *
+ *       L'en-tête du fichier déclare toutes les broches D0 à D19, ainsi que
+ *       les sorties de la chaîne de registres à décalage. La longueur de la
+ *       chaîne n'étant connue qu'à son premier verrouillage, l'écriture de
+ *       l'en-tête est différée jusqu'à ce que l'horloge dépasse la date du
+ *       premier changement d'état : seuls les changements de cette première
+ *       date sont conservés en mémoire d'ici là. Les changements d'une
+ *       sortie non déclarée (chaîne allongée en cours de simulation) sont
+ *       ignorés et décomptés.
+ */
+class VcdWriter {
+
+    public:
+
+        ~VcdWriter() { close(0); }
+
+        /**
+         * @brief Création du fichier.
+         *
+         * @return `false` si le fichier ne peut pas être créé.
+         */
+        bool open(const char *path);
+
+        /**
+         * @brief Indique si un fichier est ouvert.
+         */
+        bool isOpen() const { return file_ != nullptr; }
+
+        /**
+         * @brief Écriture d'un changement d'état (dans l'ordre chronologique).
+         */
+        void write(const PinEvent &e);
+
+        /**
+         * @brief Fermeture du fichier, dont la dernière date est `end_us`.
+         */
+        void close(const uint64_t end_us);
+
+        /**
+         * @brief Nombre de changements d'état ignorés.
+         */
+        uint64_t dropped() const { return dropped_; }
+
+    private:
+
+        void writeHeader();
+        void writeChange(const PinEvent &e);
+
+        static std::string id(size_t index);
+
+        FILE                 *file_          = nullptr;
+        bool                  header_        = false;   // En-tête écrit.
+        std::vector<PinEvent> pending_;                 // Changements en attente de l'en-tête.
+        uint64_t              time_us_       = 0;       // Dernière date écrite.
+        size_t                shift_outputs_ = 0;       // Sorties déclarées de la chaîne.
+        uint64_t              dropped_       = 0;       // Changements ignorés.
+
+};
+
+} // namespace hal
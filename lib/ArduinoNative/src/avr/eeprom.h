@@ -0,0 +1,45 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Mémoire EEPROM simulée (sous-ensemble de avr/eeprom.h)
+ * -------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Adresse du dernier octet de l'EEPROM (1 Ko sur l'ATmega328P).
+ */
+#define E2END 0x3ff
+
+namespace hal {
+
+/**
+ * @brief Indique si l'EEPROM est disponible (aucune écriture en cours).
+ */
+bool eepromReady();
+
+} // namespace hal
+
+/**
+ * @note Comme sur l'ATmega328P, l'écriture d'un octet dure 3,3 ms : les
+ *       fonctions d'écriture démarrent l'opération et rendent la main
+ *       aussitôt, mais toute lecture ou écriture ultérieure attend (en faisant
+ *       avancer l'horloge virtuelle) que l'opération précédente soit terminée.
+ *       Le contenu de l'EEPROM vaut initialement 0xff, et n'est pas effacé
+ *       par hal::reset().
+ */
+#define eeprom_is_ready() hal::eepromReady()
+
+uint8_t eeprom_read_byte(const uint8_t *p);
+void    eeprom_read_block(void *dst, const void *src, size_t n);
+void    eeprom_write_byte(uint8_t *p, uint8_t value);
+void    eeprom_update_byte(uint8_t *p, uint8_t value);
@@ -0,0 +1,56 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Modes de sommeil simulés (sous-ensemble de avr/sleep.h)
+ * -------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+extern uint8_t SMCR;
+
+#define SE  0
+#define SM0 1
+#define SM1 2
+#define SM2 3
+
+#define SLEEP_MODE_IDLE      0
+#define SLEEP_MODE_PWR_DOWN  (1 << SM1)
+#define SLEEP_MODE_PWR_SAVE  ((1 << SM1) | (1 << SM0))
+
+namespace hal {
+
+/**
+ * @brief Met le micro-contrôleur en sommeil jusqu'à la prochaine interruption.
+ *
+ * @note L'horloge virtuelle avance jusqu'à la date de la prochaine routine
+ *       d'interruption, qui est exécutée avant le réveil. Seul le mode IDLE
+ *       est simulé fidèlement : dans les autres modes, les périphériques
+ *       cadencés par l'horloge système (Timer1, USART, SPI) devraient être
+ *       arrêtés, ce que la simulation ne fait pas.
+ *
+ *       Faute d'interruption à venir, le sommeil dure une milliseconde.
+ */
+void sleep();
+
+/**
+ * @brief Durée cumulée des périodes de sommeil (en cycles d'horloge).
+ */
+uint64_t sleepCycles();
+
+} // namespace hal
+
+inline void set_sleep_mode(const uint8_t mode) { SMCR = (SMCR & ~((1 << SM2) | (1 << SM1) | (1 << SM0))) | mode; }
+
+inline void sleep_enable()  { SMCR |= 1 << SE; }
+inline void sleep_disable() { SMCR &= ~(1 << SE); }
+inline void sleep_cpu()     { if (SMCR & (1 << SE)) hal::sleep(); }
+
+inline void sleep_mode() { sleep_enable(); sleep_cpu(); sleep_disable(); }
@@ -0,0 +1,70 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Marqueurs de mesure des performances sous simulateur AVR
+ * -------------------------------------------------------------------------
+ */
+
+#pragma once
+
+/**
+ * @brief Identifiants des marqueurs.
+ * 
+ * @note Chaque marqueur est écrit dans le registre GPIOR0 de l'ATmega328P,
+ *       que le banc de mesure (bench/simavr) surveille pour dater, au cycle
+ *       d'horloge près, les points de passage du programme.
+ */
+#define BENCH_LOOP         1 // Entrée dans loop().
+#define BENCH_WRITE_BEGIN  2 // Entrée dans ledWrite().
+#define BENCH_WRITE_END    3 // Sortie de ledWrite().
+#define BENCH_PLAY_BEGIN   4 // Entrée dans playAnimation().
+#define BENCH_PLAY_END     5 // Sortie de playAnimation().
+#define BENCH_ANIMATION    6 // Lancement d'une nouvelle animation.
+#define BENCH_FRAME        7 // Affichage d'un motif (suivi de la période attendue).
+#define BENCH_FRAME_TIMER1 8 // Affichage d'un motif, dont la durée est programmée dans le Timer1.
+
+#ifdef BENCH
+
+// Dans l'environnement native, les registres GPIOR sont simulés par la
+// bibliothèque ArduinoNative, qui exploite elle-même les marqueurs.
+#ifdef __AVR__
+#include <avr/io.h>
+#else
+#include <Arduino.h>
+#endif
+
+/**
+ * @brief Dépose un marqueur (2 cycles d'horloge : ldi + out).
+ */
+#define BENCH_MARK(id) (GPIOR0 = (id))
+
+/**
+ * @brief Signale l'affichage d'un motif, ainsi que la durée (en millisecondes)
+ *        qui doit s'écouler avant l'affichage du motif suivant.
+ */
+#define BENCH_FRAME_PERIOD(ms) do {             \
+    const uint16_t bench_period_ms = (ms);      \
+    GPIOR1 = bench_period_ms & 0xff;            \
+    GPIOR2 = bench_period_ms >> 8;              \
+    GPIOR0 = BENCH_FRAME;                       \
+} while (0)
+
+/**
+ * @brief Signale l'affichage d'un motif, dont la durée vient d'être programmée
+ *        dans le Timer1 en mode CTC : le banc de mesure la déduit lui-même des
+ *        registres OCR1A et TCCR1B, au cycle d'horloge près.
+ */
+#define BENCH_TIMER1_PERIOD() (GPIOR0 = BENCH_FRAME_TIMER1)
+
+#else
+
+#define BENCH_MARK(id)         ((void) 0)
+#define BENCH_FRAME_PERIOD(ms) ((void) 0)
+#define BENCH_TIMER1_PERIOD()  ((void) 0)
+
+#endif
@@ -0,0 +1,228 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Commande d'une rampe de LEDs décrite à la compilation
+ * -------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+namespace chaser {
+
+/**
+ * @brief Type entier le plus court qui compte au moins `N` bits.
+ */
+template <bool C, typename T, typename F> struct Select              { typedef T type; };
+template <typename T, typename F>         struct Select<false, T, F> { typedef F type; };
+
+template <uint8_t N>
+struct Frame {
+    typedef typename Select<(N <= 8), uint8_t, typename Select<(N <= 16), uint16_t, uint32_t>::type>::type type;
+};
+
+/**
+ * @brief Ports de l'ATmega328P.
+ *
+ * @note Sur les cartes Uno et Nano, les broches D0 à D7 sont câblées sur les
+ *       bits 0 à 7 du port D, les broches D8 à D13 sur les bits 0 à 5 du
+ *       port B, et les broches D14 à D19 (A0 à A5) sur les bits 0 à 5 du
+ *       port C.
+ */
+enum Port : uint8_t { D, B, C, NONE };
+
+constexpr uint8_t portOf(const uint8_t pin)    { return pin < 8 ? D : pin < 14 ? B : pin < 20 ? C : NONE; }
+constexpr uint8_t firstPin(const uint8_t port) { return port == D ? 0 : port == B ? 8 : 14; }
+constexpr uint8_t bitOf(const uint8_t pin)     { return 1 << (pin - firstPin(portOf(pin))); }
+
+/**
+ * @brief Indice de la LED branchée sur une broche.
+ */
+template <uint8_t... Pins>
+constexpr uint8_t indexOf(const uint8_t pin) {
+    const uint8_t p[] = { Pins... };
+    uint8_t i = 0;
+    while (p[i] != pin) i++;
+    return i;
+}
+
+/**
+ * @brief Vérifie que chaque LED est branchée sur une broche distincte, entre
+ *        D0 et D19.
+ */
+template <uint8_t... Pins>
+constexpr bool valid() {
+    const uint8_t p[] = { Pins... };
+    for (uint8_t i=0; i<sizeof...(Pins); i++) {
+        if (portOf(p[i]) == NONE) return false;
+        for (uint8_t j=0; j<i; j++) if (p[j] == p[i]) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Masque des bits d'un port occupés par les LEDs.
+ */
+template <uint8_t... Pins>
+constexpr uint8_t mask(const uint8_t port) {
+    return ((portOf(Pins) == port ? bitOf(Pins) : 0) | ...);
+}
+
+/**
+ * @brief Décalage qui amène le bit d'indice `i` du motif sur le bit du port
+ *        qui commande la LED d'indice `i` (calculé sur la première LED du port).
+ */
+template <uint8_t... Pins>
+constexpr int8_t shift(const uint8_t port) {
+    const uint8_t p[] = { Pins... };
+    for (uint8_t i=0; i<sizeof...(Pins); i++) if (portOf(p[i]) == port) return p[i] - firstPin(port) - i;
+    return 0;
+}
+
+/**
+ * @brief Vérifie que le motif se transpose sur un port par un simple décalage.
+ *
+ * @note C'est le cas lorsque les LEDs d'un même port sont branchées dans
+ *       l'ordre sur des bits consécutifs, comme sur notre montage (D5 à D12).
+ */
+template <uint8_t... Pins>
+constexpr bool shiftable(const uint8_t port) {
+    const uint8_t p[] = { Pins... };
+    for (uint8_t i=0; i<sizeof...(Pins); i++) {
+        if (portOf(p[i]) == port && p[i] - firstPin(port) - i != shift<Pins...>(port)) return false;
+    }
+    return true;
+}
+
+} // namespace chaser
+
+/**
+ * @brief Rampe de LEDs branchées sur les broches `Pins`, de la LED d'indice 0
+ *        à la dernière.
+ *
+ * @note Le câblage est entièrement connu à la compilation : le type des
+ *       motifs, les masques des ports, les décalages et la séquence
+ *       d'initialisation en sont déduits par le compilateur. L'écriture d'un
+ *       motif ne consulte donc aucune table, et aucune boucle ne subsiste
+ *       dans le code généré.
+ *
+ *       Exemple, pour le montage de l'atelier :
+ *
+ *           typedef Chaser<5, 6, 7, 8, 9, 10, 11, 12> Leds;
+ *
+ *           Leds::begin();
+ *           Leds::write(0b10000001);
+ */
+template <uint8_t... Pins>
+class Chaser {
+
+    public:
+
+        /**
+         * @brief Nombre de LEDs.
+         */
+        static constexpr uint8_t size = sizeof...(Pins);
+
+        /**
+         * @brief Motif binaire : le bit `i` commande la LED d'indice `i`.
+         */
+        typedef typename chaser::Frame<size>::type Frame;
+
+        static_assert(size > 0 && size <= 32, "La rampe doit compter de 1 à 32 LEDs.");
+        static_assert(chaser::valid<Pins...>(), "Chaque LED doit être branchée sur une broche distincte, de D0 à D19.");
+
+    private:
+
+        /**
+         * @brief Bit du motif qui commande la LED branchée sur une broche.
+         */
+        template <uint8_t PIN>
+        static constexpr Frame LED_BIT = Frame(1) << chaser::indexOf<Pins...>(PIN);
+
+        /**
+         * @brief Bits d'un port qui affichent un motif.
+         *
+         * @note Si le câblage le permet, le motif est simplement décalé sur le
+         *       port. Sinon, chaque bit du motif est reporté sur le bit du port
+         *       correspondant, par une suite de tests et de OU logiques que le
+         *       compilateur déroule entièrement. Le choix est fait à la
+         *       compilation : une seule des deux branches subsiste.
+         */
+        template <uint8_t PORT>
+        static uint8_t bits(const Frame pattern) {
+
+            constexpr uint8_t m = chaser::mask<Pins...>(PORT);
+            constexpr int8_t  s = chaser::shift<Pins...>(PORT);
+
+            if constexpr (m == 0) {
+                return 0;
+            } else if constexpr (chaser::shiftable<Pins...>(PORT)) {
+                return uint8_t(s >= 0 ? pattern << s : pattern >> -s) & m;
+            } else {
+                uint8_t b = 0;
+                ((b |= chaser::portOf(Pins) == PORT && (pattern & LED_BIT<Pins>) ? chaser::bitOf(Pins) : 0), ...);
+                return b;
+            }
+
+        }
+
+    public:
+
+        /**
+         * @brief Masques des bits des ports D, B et C occupés par les LEDs.
+         */
+        static constexpr uint8_t PORTD_MASK = chaser::mask<Pins...>(chaser::D);
+        static constexpr uint8_t PORTB_MASK = chaser::mask<Pins...>(chaser::B);
+        static constexpr uint8_t PORTC_MASK = chaser::mask<Pins...>(chaser::C);
+
+        /**
+         * @brief Bits des ports D, B et C qui affichent un motif.
+         */
+        static uint8_t portD(const Frame pattern) { return bits<chaser::D>(pattern); }
+        static uint8_t portB(const Frame pattern) { return bits<chaser::B>(pattern); }
+        static uint8_t portC(const Frame pattern) { return bits<chaser::C>(pattern); }
+
+        /**
+         * @brief Configuration des broches de commande des LEDs en sortie.
+         *
+         * @note Chaque port n'est configuré qu'une seule fois, pour toutes les
+         *       LEDs qu'il commande.
+         */
+        static void begin() {
+
+            if (PORTD_MASK) DDRD |= PORTD_MASK;
+            if (PORTB_MASK) DDRB |= PORTB_MASK;
+            if (PORTC_MASK) DDRC |= PORTC_MASK;
+
+        }
+
+        /**
+         * @brief Affichage d'un motif binaire.
+         *
+         * @note Les interruptions sont suspendues le temps de la lecture-
+         *       modification-écriture des ports, pour ne pas écraser une
+         *       broche qu'une routine d'interruption modifierait entre-temps.
+         *       Un port entièrement occupé par les LEDs est écrit sans être lu.
+         */
+        static void write(const Frame pattern) {
+
+            const uint8_t portd = portD(pattern);
+            const uint8_t portb = portB(pattern);
+            const uint8_t portc = portC(pattern);
+
+            const uint8_t sreg = SREG;
+            cli();
+            if (PORTD_MASK) PORTD = PORTD_MASK == 0xff ? portd : (PORTD & ~PORTD_MASK) | portd;
+            if (PORTB_MASK) PORTB = PORTB_MASK == 0xff ? portb : (PORTB & ~PORTB_MASK) | portb;
+            if (PORTC_MASK) PORTC = PORTC_MASK == 0xff ? portc : (PORTC & ~PORTC_MASK) | portc;
+            SREG = sreg;
+
+        }
+
+};
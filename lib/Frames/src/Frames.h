@@ -0,0 +1,186 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Générateurs de séquences de motifs évalués à la compilation
+ * -------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Séquence de motifs binaires de longueur fixe.
+ *
+ * @note Toutes les fonctions qui suivent sont déclarées `constexpr` : lorsque
+ *       leur résultat sert à initialiser une constante, le compilateur les
+ *       évalue lui-même et n'inscrit dans le firmware que les motifs obtenus.
+ *       Elles ne coûtent donc aucun cycle d'exécution au micro-contrôleur.
+ */
+template <uint16_t N>
+struct Frames {
+    static constexpr uint16_t size = N;
+    uint8_t frame[N];
+};
+
+// ----------------------------------------------------------------------------
+// Outils
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Motif dont les `width` bits de poids faible sont à 1.
+ */
+constexpr uint8_t lowBits(const uint8_t width) {
+
+    return width >= 8 ? 0xff : (1 << width) - 1;
+
+}
+
+/**
+ * @brief Motif symétrique (bit 7 ↔ bit 0, bit 6 ↔ bit 1, etc.).
+ */
+constexpr uint8_t reverse(const uint8_t pattern) {
+
+    uint8_t r = 0;
+
+    for (uint8_t i=0; i<8; i++) {
+        if (pattern & (1 << i)) r |= 0x80 >> i;
+    }
+
+    return r;
+
+}
+
+// ----------------------------------------------------------------------------
+// Générateurs
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Balayage : le motif est décalé d'un bit à chaque étape.
+ *
+ * @tparam N       Nombre de motifs.
+ * @param  pattern Motif de départ.
+ * @param  left    Sens du décalage (vers les bits de poids fort si `true`).
+ */
+template <uint16_t N>
+constexpr Frames<N> scan(const uint8_t pattern, const bool left = true) {
+
+    Frames<N> f {};
+    uint8_t   p = pattern;
+
+    for (uint16_t i=0; i<N; i++) {
+        f.frame[i] = p;
+        p = left ? p << 1 : p >> 1;
+    }
+
+    return f;
+
+}
+
+/**
+ * @brief Rebond : un bloc de `WIDTH` LEDs part du bit de poids fort, descend
+ *        jusqu'au bas de la rampe, puis remonte.
+ *
+ * @tparam WIDTH Largeur du bloc (1 pour un simple point, 3 pour KITT).
+ * @tparam LEDS  Nombre de LEDs parcourues, à partir du bit 7.
+ */
+template <uint8_t WIDTH, uint8_t LEDS = 8>
+constexpr Frames<2 * (LEDS - WIDTH)> bounce() {
+
+    static_assert(0 < WIDTH && WIDTH < LEDS && LEDS <= 8, "Bloc ou rampe de largeur invalide.");
+
+    Frames<2 * (LEDS - WIDTH)> f {};
+
+    const uint8_t top   = lowBits(WIDTH) << (8 - WIDTH);
+    const uint8_t steps = LEDS - WIDTH;
+
+    for (uint8_t i=0; i<steps; i++) {
+        f.frame[i]         = top >> i;
+        f.frame[steps + i] = top >> (steps - i);
+    }
+
+    return f;
+
+}
+
+/**
+ * @brief Remplissage : les LEDs s'allument une à une, à partir du bas de la
+ *        rampe, jusqu'à ce qu'elles soient toutes allumées, puis s'éteignent
+ *        dans l'ordre inverse.
+ *
+ * @tparam LEDS Nombre de LEDs remplies, à partir du bit 7.
+ */
+template <uint8_t LEDS = 8>
+constexpr Frames<2 * LEDS> fill() {
+
+    static_assert(0 < LEDS && LEDS <= 8, "Rampe de largeur invalide.");
+
+    Frames<2 * LEDS> f {};
+
+    for (uint8_t i=0; i<LEDS; i++) {
+        f.frame[i]              = (lowBits(i) << (8 - LEDS)) & 0xff;
+        f.frame[2*LEDS - i - 1] = (lowBits(i + 1) << (8 - LEDS)) & 0xff;
+    }
+
+    return f;
+
+}
+
+/**
+ * @brief Alternance d'un motif et de son complément.
+ */
+constexpr Frames<2> alternate(const uint8_t pattern) {
+
+    return Frames<2> {{ pattern, uint8_t(~pattern) }};
+
+}
+
+// ----------------------------------------------------------------------------
+// Transformations
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Miroir : chaque motif est complété par son symétrique.
+ *
+ * @note Appliqué à une séquence qui n'occupe que la moitié haute de la rampe,
+ *       on obtient une animation symétrique par rapport au centre.
+ */
+template <uint16_t N>
+constexpr Frames<N> mirror(const Frames<N> &s) {
+
+    Frames<N> f {};
+
+    for (uint16_t i=0; i<N; i++) {
+        f.frame[i] = s.frame[i] | reverse(s.frame[i]);
+    }
+
+    return f;
+
+}
+
+/**
+ * @brief Concaténation de plusieurs séquences.
+ */
+template <uint16_t A, uint16_t B>
+constexpr Frames<A + B> concat(const Frames<A> &a, const Frames<B> &b) {
+
+    Frames<A + B> f {};
+
+    for (uint16_t i=0; i<A; i++) f.frame[i]     = a.frame[i];
+    for (uint16_t i=0; i<B; i++) f.frame[A + i] = b.frame[i];
+
+    return f;
+
+}
+
+template <uint16_t A, typename... S>
+constexpr auto concat(const Frames<A> &a, const S &... s) {
+
+    return concat(a, concat(s...));
+
+}
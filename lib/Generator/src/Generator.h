@@ -0,0 +1,103 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Générateurs de motifs calculés à l'exécution
+ * -------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * @brief Origine des motifs d'une animation.
+ *
+ * @note Une animation lit habituellement ses motifs dans un tableau rangé en
+ *       mémoire flash (TABLE). Les autres générateurs les calculent à la
+ *       volée, à partir d'un unique octet d'état : une séquence aussi longue
+ *       qu'on le souhaite n'occupe alors aucune place en mémoire flash.
+ *
+ *       Chaque étape se résume à quelques instructions (décalage, rotation,
+ *       ou exclusif), soit une dizaine de cycles d'horloge.
+ */
+enum Generator : uint8_t {
+    TABLE,       // Motifs lus dans le tableau des motifs.
+    LFSR,        // Scintillement pseudo-aléatoire (registre à décalage de Galois, période 255).
+    GRAY,        // Comptage en code de Gray : une seule LED change d'état à chaque motif.
+    JOHNSON,     // Compteur de Johnson : la rampe se remplit puis se vide (période 16).
+    RULE_30,     // Automate cellulaire élémentaire, règle 30 (chaotique).
+    RULE_90,     // Automate cellulaire élémentaire, règle 90 (triangle de Sierpiński).
+    RULE_110     // Automate cellulaire élémentaire, règle 110.
+};
+
+/**
+ * @brief Polynôme du registre à décalage : x^8 + x^6 + x^5 + x^4 + 1.
+ *
+ * @note Ce polynôme est primitif : à partir de tout état non nul, le
+ *       registre parcourt les 255 motifs non nuls avant de se répéter. L'état
+ *       nul, lui, ne change jamais : il est refusé comme état initial.
+ */
+const uint8_t LFSR_TAPS = 0xb8;
+
+/**
+ * @brief Rotation du motif d'un bit vers le bit 7 (le bit 7 revient en 0).
+ */
+inline uint8_t rotateUp(const uint8_t s) {
+
+    return s << 1 | s >> 7;
+
+}
+
+/**
+ * @brief Rotation du motif d'un bit vers le bit 0 (le bit 0 revient en 7).
+ */
+inline uint8_t rotateDown(const uint8_t s) {
+
+    return s >> 1 | s << 7;
+
+}
+
+/**
+ * @brief Motif affiché pour un état donné du générateur.
+ *
+ * @note Seul le compteur de Gray distingue le motif de son état : l'état
+ *       est un compteur binaire, dont on affiche le code de Gray.
+ */
+inline uint8_t generatorFrame(const Generator type, const uint8_t state) {
+
+    return type == GRAY ? state ^ state >> 1 : state;
+
+}
+
+/**
+ * @brief État suivant du générateur.
+ *
+ * @note Les automates cellulaires traitent la rampe comme un anneau : les
+ *       voisines de la LED d'indice `i` sont les LEDs d'indices `i + 1`
+ *       (à gauche) et `i - 1` (à droite), modulo 8. Une rotation du motif
+ *       aligne ainsi les voisines de chaque LED sur celle-ci, et la règle
+ *       s'applique aux 8 LEDs à la fois par de simples opérations logiques.
+ */
+inline uint8_t generatorStep(const Generator type, const uint8_t state) {
+
+    const uint8_t left  = rotateDown(state);
+    const uint8_t right = rotateUp(state);
+
+    switch (type) {
+
+        case LFSR:     return state & 1 ? state >> 1 ^ LFSR_TAPS : state >> 1;
+        case GRAY:     return state + 1;
+        case JOHNSON:  return state << 1 | (~state >> 7 & 1);
+        case RULE_30:  return left ^ (state | right);
+        case RULE_90:  return left ^ right;
+        case RULE_110: return (state ^ right) | (state & ~left);
+        default:       return state;
+
+    }
+
+}
@@ -0,0 +1,258 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Compteurs de performances embarqués
+ * -------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * @brief Activation des compteurs.
+ *
+ * @note Contrairement aux marqueurs de lib/Bench, qui ne servent que sous
+ *       simulateur, les compteurs fonctionnent sur la carte elle-même : ils
+ *       sont donc actifs par défaut. Ils peuvent être retirés à la
+ *       compilation, sans modifier le programme :
+ *
+ *           -D PERF=0
+ *
+ *       Les sondes ne génèrent alors plus aucun code.
+ */
+#ifndef PERF
+#define PERF 1
+#endif
+
+/**
+ * @brief Sections de code dont la durée est mesurée.
+ */
+enum PerfSpan : uint8_t {
+    PERF_PLAY,  // playAnimation() (ledWrite() compris).
+    PERF_WRITE, // ledWrite().
+    PERF_PROBE, // Section vide, mesurée au démarrage pour étalonner les sondes.
+    PERF_SPANS
+};
+
+/**
+ * @brief Histogramme des retards d'affichage des motifs : la classe 0
+ *        compte les retards inférieurs à 64 µs, et chaque classe suivante
+ *        couvre un intervalle deux fois plus large que la précédente
+ *        ([64,128[, [128,256[, ... [2048,4096[). La dernière classe compte
+ *        tous les retards d'au moins 4096 µs.
+ */
+const uint8_t PERF_LATE_BINS  = 8;
+const uint8_t PERF_LATE_SHIFT = 6;
+
+/**
+ * @brief Retard (en microsecondes) au-delà duquel une échéance est
+ *        considérée comme manquée.
+ *
+ * @note Sur la carte, millis() progresse par pas de 1,024 ms, et saute
+ *       parfois une milliseconde : un séquenceur cadencé par millis()
+ *       constate donc normalement ses échéances avec un retard pouvant
+ *       atteindre une milliseconde. Seul un retard supérieur trahit une
+ *       boucle trop lente.
+ */
+#ifndef PERF_MISS_US
+#define PERF_MISS_US 2000
+#endif
+
+/**
+ * @brief Durées cumulées d'une section de code (en cycles d'horloge).
+ */
+struct PerfTime {
+    uint32_t cycles; // Durée cumulée.
+    uint32_t calls;  // Nombre d'exécutions.
+    uint16_t max;    // Durée de l'exécution la plus longue.
+};
+
+/**
+ * @brief Compteurs de performances.
+ *
+ * @note Tous les compteurs ont une taille fixe. Les compteurs de 32 bits ne
+ *       débordent qu'au bout de plusieurs jours de fonctionnement ; les
+ *       classes de l'histogramme, sur 16 bits, restent bloquées à leur
+ *       valeur maximale.
+ */
+struct Perf {
+    PerfTime time[PERF_SPANS];     // Durées des sections mesurées.
+    uint32_t loops;                // Itérations de loop() dans la seconde en cours.
+    uint32_t loops_per_s;          // Itérations de loop() dans la dernière seconde écoulée.
+    uint32_t second;               // Début de la seconde en cours (millisecondes).
+    uint32_t frames;               // Nombre de motifs affichés.
+    uint32_t missed;               // Nombre d'échéances manquées.
+    uint16_t late[PERF_LATE_BINS]; // Histogramme des retards d'affichage.
+    uint8_t  bias;                 // Durée mesurée d'une section vide (cycles).
+    uint8_t  cost;                 // Coût total d'une paire de sondes (cycles).
+};
+
+/**
+ * @brief Compteurs de performances du programme.
+ *
+ * @note Tous les compteurs sont initialisés à zéro par défaut.
+ */
+inline Perf perf = {};
+
+#if PERF
+
+/**
+ * @brief Début d'une section mesurée : relevé du compteur du Timer1.
+ */
+#define PERF_SPAN_BEGIN(span) const uint16_t perf_start_##span = TCNT1
+
+/**
+ * @brief Fin d'une section mesurée, qui doit figurer dans la même portée
+ *        que son début (et précéder chaque `return` de la section).
+ */
+#define PERF_SPAN_END(span)   perfSpanEnd(span, perf_start_##span)
+
+/**
+ * @brief Itération de la boucle principale.
+ */
+#define PERF_LOOP(now)        perfLoop(now)
+
+/**
+ * @brief Affichage d'un motif dont l'échéance (en millisecondes) est passée.
+ */
+#define PERF_FRAME(deadline)  perfFrame(deadline)
+
+/**
+ * @brief Cumul de la durée d'une section mesurée.
+ *
+ * @note La fonction n'est jamais développée en ligne : le coût d'une sonde
+ *       reste ainsi le même partout, ce qui permet de l'étalonner une fois
+ *       pour toutes (voir perfBegin()).
+ */
+__attribute__((noinline)) inline void perfSpanEnd(const PerfSpan span, const uint16_t start) {
+
+    const uint16_t elapsed = TCNT1 - start;
+    const uint16_t cycles  = elapsed > perf.bias ? elapsed - perf.bias : 0;
+
+    PerfTime &t = perf.time[span];
+
+    t.cycles += cycles;
+    t.calls++;
+    if (cycles > t.max) t.max = cycles;
+
+}
+
+/**
+ * @brief Décompte des itérations de la boucle principale, par seconde.
+ */
+inline void perfLoop(const uint32_t now) {
+
+    perf.loops++;
+
+    if (now - perf.second >= 1000) {
+        perf.loops_per_s = perf.loops;
+        perf.loops       = 0;
+        perf.second      = now;
+    }
+
+}
+
+/**
+ * @brief Relevé du retard d'affichage d'un motif sur son échéance.
+ *
+ * @param deadline Échéance du motif (millisecondes).
+ *
+ * @note Le retard est mesuré avec micros(), dont la résolution (4 µs) est
+ *       bien meilleure que celle de l'échéancier lui-même.
+ */
+inline void perfFrame(const uint32_t deadline) {
+
+    const int32_t  late = micros() - deadline * 1000;
+    const uint32_t us   = late > 0 ? late : 0;
+
+    uint32_t v   = us >> PERF_LATE_SHIFT;
+    uint8_t  bin = 0;
+
+    while (v && bin < PERF_LATE_BINS - 1) {
+        v >>= 1;
+        bin++;
+    }
+
+    if (perf.late[bin] != UINT16_MAX) perf.late[bin]++;
+    if (us >= PERF_MISS_US) perf.missed++;
+
+    perf.frames++;
+
+}
+
+/**
+ * @brief Remise à zéro des compteurs (l'étalonnage des sondes est conservé).
+ */
+inline void perfReset() {
+
+    const uint8_t bias = perf.bias;
+    const uint8_t cost = perf.cost;
+
+    perf        = {};
+    perf.bias   = bias;
+    perf.cost   = cost;
+    perf.second = millis();
+
+}
+
+/**
+ * @brief Démarrage des compteurs.
+ *
+ * @note Le Timer1 compte les cycles d'horloge (sans prédiviseur) : une
+ *       section mesurée doit donc durer moins de 65536 cycles (4 ms). Les
+ *       interruptions qui surviennent pendant une section (celle du Timer0
+ *       notamment) sont comptées dans sa durée, et gonflent parfois le
+ *       maximum de quelques microsecondes.
+ *
+ *       Deux mesures d'une section vide étalonnent les sondes :
+ *
+ *         - le biais, durée mesurée d'une section vide, est retranché de
+ *           chaque mesure,
+ *         - le coût, durée totale d'une paire de sondes, indique ce que
+ *           l'instrumentation retire au programme à chaque section mesurée.
+ */
+inline void perfBegin() {
+
+    TCCR1A = 0;
+    TCCR1B = _BV(CS10);
+
+    perf.bias = 0;
+
+    {
+        PERF_SPAN_BEGIN(PERF_PROBE);
+        PERF_SPAN_END(PERF_PROBE);
+    }
+
+    perf.bias = perf.time[PERF_PROBE].max;
+
+    const uint16_t start = TCNT1;
+
+    {
+        PERF_SPAN_BEGIN(PERF_PROBE);
+        PERF_SPAN_END(PERF_PROBE);
+    }
+
+    const uint16_t elapsed = TCNT1 - start;
+    perf.cost = elapsed > perf.bias ? elapsed - perf.bias : 0;
+
+    perfReset();
+
+}
+
+#else
+
+#define PERF_SPAN_BEGIN(span) ((void) 0)
+#define PERF_SPAN_END(span)   ((void) 0)
+#define PERF_LOOP(now)        ((void) 0)
+#define PERF_FRAME(deadline)  ((void) 0)
+
+inline void perfReset() {}
+inline void perfBegin() {}
+
+#endif
@@ -0,0 +1,515 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Programme de lecture des animations (playlist)
+ * -------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * @brief Codes des instructions.
+ *
+ * @note Le programme est une suite d'octets rangée en mémoire flash : chaque
+ *       instruction tient dans son code, suivi de ses opérandes.
+ *
+ *         PLAY    a n         joue l'animation `a`, `n` fois de suite
+ *         LOOP    n           exécute `n` fois les instructions jusqu'au END
+ *         END                 fin du corps de la boucle
+ *         JUMP    adresse     poursuit à l'adresse indiquée
+ *         SHUFFLE k a1 … ak   joue les `k` animations, dans un ordre aléatoire
+ *         PICK    a0 … a15    joue l'une des animations, tirée au sort
+ *         HOLD    t           fige la rampe pendant `t` × 100 ms
+ *
+ *       Un programme s'écrit avec les fonctions de l'espace de noms
+ *       `playlist`, puis il est assemblé à la compilation (voir assemble()).
+ */
+enum PlaylistCode : uint8_t {
+    PLAYLIST_PLAY,
+    PLAYLIST_LOOP,
+    PLAYLIST_END,
+    PLAYLIST_JUMP,
+    PLAYLIST_SHUFFLE,
+    PLAYLIST_PICK,
+    PLAYLIST_HOLD_FOR
+};
+
+/**
+ * @brief Nombre maximal de boucles imbriquées.
+ */
+const uint8_t PLAYLIST_DEPTH = 4;
+
+/**
+ * @brief Nombre maximal d'animations d'un bloc SHUFFLE.
+ */
+const uint8_t PLAYLIST_SHUFFLE_MAX = 8;
+
+/**
+ * @brief Nombre de cases du tirage au sort d'une instruction PICK : chaque
+ *        animation en occupe un nombre proportionnel à son poids.
+ */
+const uint8_t PLAYLIST_PICK_SLOTS = 16;
+
+/**
+ * @brief Durée élémentaire d'une instruction HOLD (ms).
+ */
+const uint16_t PLAYLIST_HOLD_MS = 100;
+
+/**
+ * @brief Valeur renvoyée par playlistNext() lorsque le programme demande de
+ *        figer la rampe (la durée est alors donnée par `Playlist::hold`).
+ */
+const uint8_t PLAYLIST_HOLD = 0xff;
+
+/**
+ * @brief État de l'interpréteur, en SRAM (24 octets).
+ */
+struct Playlist {
+    uint8_t  pc;                              // Adresse de la prochaine instruction.
+    uint8_t  animation;                       // Animation de l'instruction PLAY en cours.
+    uint8_t  remaining;                       // Lectures restantes de cette animation.
+    uint8_t  depth;                           // Nombre de boucles ouvertes.
+    uint8_t  loop_pc[PLAYLIST_DEPTH];         // Adresse du corps de chaque boucle ouverte.
+    uint8_t  loop_left[PLAYLIST_DEPTH];       // Passages restants dans chaque boucle ouverte.
+    uint8_t  shuffle[PLAYLIST_SHUFFLE_MAX];   // Animations du bloc SHUFFLE pas encore jouées.
+    uint8_t  shuffle_left;                    // Nombre de ces animations.
+    uint8_t  hold;                            // Durée de la dernière instruction HOLD (× 100 ms).
+    uint16_t random;                          // État du générateur pseudo-aléatoire.
+};
+
+/**
+ * @brief Démarrage du programme.
+ *
+ * @param seed Graine du générateur pseudo-aléatoire (non nulle). Sur la
+ *             carte, on peut la tirer du bruit d'une entrée analogique non
+ *             connectée : la même graine rejoue le même programme.
+ */
+inline void playlistBegin(Playlist &p, const uint16_t seed) {
+
+    p = {};
+    p.random = seed ? seed : 1;
+
+}
+
+/**
+ * @brief Tirage d'un octet pseudo-aléatoire (xorshift sur 16 bits).
+ */
+inline uint8_t playlistRandom(Playlist &p) {
+
+    uint16_t x = p.random;
+
+    x ^= x << 7;
+    x ^= x >> 9;
+    x ^= x << 8;
+
+    p.random = x;
+
+    return x >> 8;
+
+}
+
+/**
+ * @brief Exécution du programme jusqu'à la prochaine animation à jouer.
+ *
+ * @param code Programme assemblé, en mémoire flash.
+ *
+ * @return Indice de l'animation, ou PLAYLIST_HOLD.
+ *
+ * @note Chaque instruction s'exécute en un temps borné : un bloc SHUFFLE
+ *       retire une animation au hasard parmi celles qui restent, en la
+ *       remplaçant par la dernière, et un tirage PICK se réduit à la lecture
+ *       d'une case.
+ *       L'assembleur garantit en outre qu'une animation (ou un HOLD) est
+ *       atteinte en un nombre fini d'instructions de contrôle : le coût d'un
+ *       changement d'animation ne dépend pas de la durée du spectacle.
+ */
+inline uint8_t playlistNext(Playlist &p, const uint8_t * const code) {
+
+    if (p.remaining) {
+        p.remaining--;
+        return p.animation;
+    }
+
+    if (p.shuffle_left) {
+        const uint8_t i = (playlistRandom(p) * p.shuffle_left) >> 8;
+        const uint8_t a = p.shuffle[i];
+        p.shuffle[i] = p.shuffle[--p.shuffle_left];
+        return a;
+    }
+
+    while (true) {
+
+        const uint8_t * const op = code + p.pc;
+
+        switch (pgm_read_byte(op)) {
+
+            case PLAYLIST_PLAY:
+                p.animation = pgm_read_byte(op + 1);
+                p.remaining = pgm_read_byte(op + 2) - 1;
+                p.pc += 3;
+                return p.animation;
+
+            case PLAYLIST_LOOP:
+                p.loop_pc[p.depth]   = p.pc + 2;
+                p.loop_left[p.depth] = pgm_read_byte(op + 1);
+                p.depth++;
+                p.pc += 2;
+                break;
+
+            case PLAYLIST_END:
+                if (--p.loop_left[p.depth - 1]) {
+                    p.pc = p.loop_pc[p.depth - 1];
+                } else {
+                    p.depth--;
+                    p.pc += 1;
+                }
+                break;
+
+            case PLAYLIST_JUMP:
+                p.pc = pgm_read_byte(op + 1);
+                break;
+
+            case PLAYLIST_SHUFFLE:
+                p.shuffle_left = pgm_read_byte(op + 1);
+                memcpy_P(p.shuffle, op + 2, p.shuffle_left);
+                p.pc += 2 + p.shuffle_left;
+                return playlistNext(p, code);
+
+            case PLAYLIST_PICK:
+                p.pc += 1 + PLAYLIST_PICK_SLOTS;
+                return pgm_read_byte(op + 1 + (playlistRandom(p) & (PLAYLIST_PICK_SLOTS - 1)));
+
+            default: // PLAYLIST_HOLD_FOR
+                p.hold = pgm_read_byte(op + 1);
+                p.pc += 2;
+                return PLAYLIST_HOLD;
+
+        }
+
+    }
+
+}
+
+// ----------------------------------------------------------------------------
+// Écriture et assemblage d'un programme
+// ----------------------------------------------------------------------------
+
+namespace playlist {
+
+/**
+ * @brief Erreurs détectées à l'assemblage (voir lib/ShowBuilder).
+ */
+void error_count_is_zero();
+void error_unknown_animation();
+void error_shuffle_too_large();
+void error_weights_are_zero();
+void error_loop_too_deep();
+void error_unmatched_end();
+void error_unterminated_loop();
+void error_jump_out_of_range();
+void error_jump_into_loop();
+void error_program_too_long();
+void error_no_animation_reached();
+
+/**
+ * @brief Instruction, avant assemblage.
+ *
+ * @note Les opérandes sont déjà dans leur forme finale, sauf la cible d'un
+ *       JUMP, donnée par le rang de l'instruction visée dans le programme.
+ */
+struct Op {
+    uint8_t code;                         // Code de l'instruction.
+    uint8_t size;                         // Nombre d'octets (code compris).
+    uint8_t arg[PLAYLIST_PICK_SLOTS];     // Opérandes.
+};
+
+/**
+ * @brief Animation candidate d'un tirage au sort, et son poids.
+ */
+struct Choice {
+    uint8_t animation;
+    uint8_t weight;
+};
+
+constexpr Choice choice(const uint8_t animation, const uint8_t weight) {
+
+    return { animation, weight };
+
+}
+
+/**
+ * @brief Lecture de l'animation `animation`, `times` fois de suite.
+ */
+constexpr Op play(const uint8_t animation, const uint8_t times = 1) {
+
+    if (times == 0) error_count_is_zero();
+
+    return { PLAYLIST_PLAY, 3, { animation, times } };
+
+}
+
+/**
+ * @brief Début d'une boucle de `times` passages, close par end().
+ */
+constexpr Op loop(const uint8_t times) {
+
+    if (times == 0) error_count_is_zero();
+
+    return { PLAYLIST_LOOP, 2, { times } };
+
+}
+
+/**
+ * @brief Fin du corps de la boucle ouverte par le loop() qui précède.
+ */
+constexpr Op end() {
+
+    return { PLAYLIST_END, 1, {} };
+
+}
+
+/**
+ * @brief Saut à l'instruction de rang `target` (0 pour la première).
+ */
+constexpr Op jump(const uint8_t target) {
+
+    return { PLAYLIST_JUMP, 2, { target } };
+
+}
+
+/**
+ * @brief Figement de la rampe pendant `tenths` × 100 ms.
+ */
+constexpr Op hold(const uint8_t tenths) {
+
+    if (tenths == 0) error_count_is_zero();
+
+    return { PLAYLIST_HOLD_FOR, 2, { tenths } };
+
+}
+
+/**
+ * @brief Lecture des animations données, une fois chacune, dans un ordre
+ *        tiré au sort à chaque passage.
+ */
+template <typename... A>
+constexpr Op shuffle(const A... animation) {
+
+    static_assert(sizeof...(A) > 0, "Un bloc SHUFFLE compte au moins une animation.");
+
+    if (sizeof...(A) > PLAYLIST_SHUFFLE_MAX) error_shuffle_too_large();
+
+    return { PLAYLIST_SHUFFLE, uint8_t(2 + sizeof...(A)), { uint8_t(sizeof...(A)), uint8_t(animation)... } };
+
+}
+
+/**
+ * @brief Lecture de l'une des animations données, tirée au sort selon son
+ *        poids.
+ *
+ * @note Les 16 cases du tirage sont réparties à la compilation au prorata
+ *       des poids (méthode du plus fort reste) : une animation de poids 3,
+ *       face à une autre de poids 1, en occupe 12. Une animation dont le
+ *       poids est trop faible pour lui valoir une case n'est jamais tirée.
+ */
+template <typename... C>
+constexpr Op pick(const C... choices) {
+
+    const Choice c[] = { choices... };
+    const size_t n   = sizeof...(C);
+
+    uint16_t total = 0;
+    for (size_t i=0; i<n; i++) total += c[i].weight;
+
+    if (total == 0) error_weights_are_zero();
+
+    Op op = { PLAYLIST_PICK, 1 + PLAYLIST_PICK_SLOTS, {} };
+
+    uint8_t  slots[n]     = {};
+    uint16_t remainder[n] = {};
+    uint8_t  used         = 0;
+
+    for (size_t i=0; i<n; i++) {
+        slots[i]     = c[i].weight * PLAYLIST_PICK_SLOTS / total;
+        remainder[i] = c[i].weight * PLAYLIST_PICK_SLOTS % total;
+        used        += slots[i];
+    }
+
+    for (; used < PLAYLIST_PICK_SLOTS; used++) {
+        size_t best = 0;
+        for (size_t i=1; i<n; i++) {
+            if (remainder[i] > remainder[best]) best = i;
+        }
+        slots[best]++;
+        remainder[best] = 0;
+    }
+
+    uint8_t s = 0;
+    for (size_t i=0; i<n; i++) {
+        for (uint8_t k=0; k<slots[i]; k++) op.arg[s++] = c[i].animation;
+    }
+
+    return op;
+
+}
+
+/**
+ * @brief Indique si une instruction rend la main au séquenceur.
+ */
+constexpr bool emits(const Op &op) {
+
+    return op.code == PLAYLIST_PLAY || op.code == PLAYLIST_SHUFFLE || op.code == PLAYLIST_PICK || op.code == PLAYLIST_HOLD_FOR;
+
+}
+
+/**
+ * @brief Taille du programme assemblé (octets), saut final compris.
+ */
+template <size_t N>
+constexpr size_t size(const Op (&program)[N]) {
+
+    size_t bytes = 2;
+
+    for (size_t i=0; i<N; i++) bytes += program[i].size;
+
+    return bytes;
+
+}
+
+/**
+ * @brief Programme assemblé.
+ */
+template <size_t SIZE>
+struct Code {
+
+    uint8_t byte[SIZE];
+
+    static constexpr size_t size = SIZE;
+
+};
+
+/**
+ * @brief Assemblage d'un programme, à la compilation.
+ *
+ * @param program    Instructions du programme.
+ * @param animations Nombre d'animations de l'enchaînement.
+ *
+ * @note Un saut vers la première instruction est ajouté à la fin : le
+ *       programme recommence indéfiniment. L'assembleur vérifie :
+ *
+ *         - les indices des animations,
+ *         - l'appariement des boucles et leur profondeur,
+ *         - les cibles des sauts, qui ne peuvent pas entrer dans une boucle,
+ *         - que toute suite d'instructions de contrôle (LOOP, END, JUMP)
+ *           aboutit à une animation ou à un HOLD.
+ *
+ *           constexpr playlist::Op PROGRAM[] = {
+ *               playlist::play(0),
+ *               playlist::loop(3),
+ *                   playlist::shuffle(1, 2, 3),
+ *               playlist::end()
+ *           };
+ *
+ *           const auto PLAYLIST PROGMEM =
+ *               playlist::assemble<playlist::size(PROGRAM)>(PROGRAM, NUM_ANIMATIONS);
+ */
+template <size_t SIZE, size_t N>
+constexpr Code<SIZE> assemble(const Op (&program)[N], const uint8_t animations) {
+
+    if (SIZE > 256) error_program_too_long();
+
+    // Adresse de chaque instruction, et de la fin de chaque boucle.
+    size_t address[N + 1] = {};
+    size_t loop_of[N + 1] = {};   // Rang du loop() qui ouvre la boucle contenant chaque instruction, + 1.
+    size_t match[N + 1]   = {};   // Pour un end(), rang du loop() correspondant.
+    size_t open[PLAYLIST_DEPTH] = {};
+    size_t depth = 0;
+
+    for (size_t i=0; i<N; i++) {
+
+        address[i + 1] = address[i] + program[i].size;
+        loop_of[i]     = depth ? open[depth - 1] + 1 : 0;
+
+        const Op &op = program[i];
+
+        if (op.code == PLAYLIST_PLAY && op.arg[0] >= animations) error_unknown_animation();
+        if (op.code == PLAYLIST_SHUFFLE) {
+            for (uint8_t k=0; k<op.arg[0]; k++) {
+                if (op.arg[1 + k] >= animations) error_unknown_animation();
+            }
+        }
+        if (op.code == PLAYLIST_PICK) {
+            for (uint8_t k=0; k<PLAYLIST_PICK_SLOTS; k++) {
+                if (op.arg[k] >= animations) error_unknown_animation();
+            }
+        }
+        if (op.code == PLAYLIST_JUMP && op.arg[0] >= N) error_jump_out_of_range();
+
+        if (op.code == PLAYLIST_LOOP) {
+            if (depth == PLAYLIST_DEPTH) error_loop_too_deep();
+            open[depth++] = i;
+        }
+        if (op.code == PLAYLIST_END) {
+            if (depth == 0) error_unmatched_end();
+            match[i] = open[--depth];
+        }
+
+    }
+
+    if (depth) error_unterminated_loop();
+
+    // Un saut ne peut viser qu'une instruction de la même boucle (ou hors de
+    // toute boucle), faute de quoi le compteur de passages n'existerait pas.
+    for (size_t i=0; i<N; i++) {
+        if (program[i].code == PLAYLIST_JUMP && loop_of[program[i].arg[0]] != loop_of[i]) error_jump_into_loop();
+    }
+
+    // Recherche d'un cycle d'instructions de contrôle : une instruction est
+    // sûre si elle rend la main, ou si toutes celles qui peuvent la suivre
+    // sont sûres. Le saut final (rang N) mène à la première instruction.
+    bool safe[N + 1] = {};
+
+    for (size_t pass=0; pass<=N; pass++) {
+        for (size_t i=0; i<=N; i++) {
+            if (i == N) {
+                safe[i] = safe[0];
+            } else if (emits(program[i])) {
+                safe[i] = true;
+            } else if (program[i].code == PLAYLIST_JUMP) {
+                safe[i] = safe[program[i].arg[0]];
+            } else if (program[i].code == PLAYLIST_END) {
+                safe[i] = safe[match[i] + 1] && safe[i + 1];
+            } else {
+                safe[i] = safe[i + 1];
+            }
+        }
+    }
+
+    for (size_t i=0; i<=N; i++) {
+        if (!safe[i]) error_no_animation_reached();
+    }
+
+    Code<SIZE> code = {};
+
+    for (size_t i=0; i<N; i++) {
+        const Op &op = program[i];
+        code.byte[address[i]] = op.code;
+        for (uint8_t k=1; k<op.size; k++) code.byte[address[i] + k] = op.arg[k - 1];
+        if (op.code == PLAYLIST_JUMP) code.byte[address[i] + 1] = uint8_t(address[op.arg[0]]);
+    }
+
+    code.byte[address[N]]     = PLAYLIST_JUMP;
+    code.byte[address[N] + 1] = 0;
+
+    return code;
+
+}
+
+} // namespace playlist
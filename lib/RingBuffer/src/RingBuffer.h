@@ -0,0 +1,101 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * File circulaire à un producteur et un consommateur, sans verrou
+ * -------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief File circulaire d'octets, partagée entre un producteur et un
+ *        consommateur (typiquement deux routines d'interruption, ou une
+ *        routine d'interruption et la boucle principale).
+ *
+ * @tparam N Capacité de la file : une puissance de 2, au plus égale à 128.
+ *
+ * @note Le producteur est le seul à modifier l'indice d'écriture `head_`,
+ *       le consommateur le seul à modifier l'indice de lecture `tail_`.
+ *       Chacun de ces indices tient sur un octet, dont la lecture et
+ *       l'écriture sont atomiques sur AVR : aucune section critique n'est
+ *       donc nécessaire, ni d'un côté, ni de l'autre.
+ *
+ *       Les indices ne sont pas ramenés dans l'intervalle [0,N) : ils
+ *       progressent librement et débordent naturellement à 256. Leur
+ *       différence donne toujours le nombre d'octets en attente, ce qui
+ *       permet de distinguer une file pleine d'une file vide sans sacrifier
+ *       de case. Le masque `N - 1` donne la case correspondante.
+ */
+template <uint8_t N>
+class RingBuffer {
+
+    static_assert(N > 0 && N <= 128 && (N & (N - 1)) == 0, "La capacité doit être une puissance de 2, au plus égale à 128.");
+
+    public:
+
+        /**
+         * @brief Ajoute un octet à la file (côté producteur).
+         *
+         * @return false si la file est pleine : l'octet est alors perdu.
+         */
+        bool push(const uint8_t value) {
+
+            const uint8_t head = head_;
+
+            if (uint8_t(head - tail_) == N) return false;
+
+            buffer_[head & (N - 1)] = value;
+
+            // L'octet doit être rangé avant que l'indice ne le rende visible :
+            // la barrière interdit au compilateur d'inverser les deux écritures.
+            __asm__ __volatile__ ("" ::: "memory");
+            head_ = head + 1;
+
+            return true;
+
+        }
+
+        /**
+         * @brief Retire le plus ancien octet de la file (côté consommateur).
+         *
+         * @return false si la file est vide.
+         */
+        bool pop(uint8_t &value) {
+
+            const uint8_t tail = tail_;
+
+            if (head_ == tail) return false;
+
+            value = buffer_[tail & (N - 1)];
+
+            // De même, la case doit être lue avant d'être rendue au producteur :
+            __asm__ __volatile__ ("" ::: "memory");
+            tail_ = tail + 1;
+
+            return true;
+
+        }
+
+        /**
+         * @brief Nombre d'octets en attente (valeur indicative pour le
+         *        producteur comme pour le consommateur, puisque l'autre
+         *        partie peut la modifier à tout instant).
+         */
+        uint8_t size() const { return head_ - tail_; }
+
+        static constexpr uint8_t capacity() { return N; }
+
+    private:
+
+        uint8_t          buffer_[N];
+        volatile uint8_t head_ = 0; // Indice d'écriture (producteur).
+        volatile uint8_t tail_ = 0; // Indice de lecture (consommateur).
+
+};
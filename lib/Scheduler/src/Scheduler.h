@@ -0,0 +1,96 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Échéancier périodique sans dérive
+ * -------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Échéance d'une tâche périodique.
+ *
+ * @note Le test habituel `if (now - last > period) { ...; last = now; }`
+ *       dérive de deux façons :
+ *
+ *         - la comparaison stricte ajoute une milliseconde à chaque période,
+ *         - la date de référence est celle à laquelle la boucle a constaté
+ *           l'échéance, et non l'échéance elle-même : le retard de la boucle
+ *           s'ajoute à chaque période.
+ *
+ *       Ici, l'échéance suivante est calculée à partir de la précédente
+ *       (`next += period`). Un retard ponctuel de la boucle décale donc un
+ *       seul motif, jamais ceux qui suivent.
+ *
+ *       Les dates sont comparées par différence signée, ce qui reste correct
+ *       lorsque millis() déborde (au bout de 49 jours environ).
+ */
+struct Deadline {
+    uint32_t next; // Date de la prochaine échéance.
+};
+
+/**
+ * @brief Comportement de l'échéancier après un dépassement, c'est-à-dire
+ *        lorsque la boucle a laissé passer plus d'une période.
+ */
+enum Overrun : uint8_t {
+    CATCH_UP, // Les échéances manquées sont rattrapées, l'une après l'autre,
+              // aussi vite que la boucle le permet.
+    SKIP      // Les échéances manquées sont abandonnées : l'échéance suivante
+              // est la première qui tombe dans le futur, dans la même phase.
+              // Pour rester synchrone, l'appelant doit alors sauter autant
+              // de motifs qu'il y a eu d'échéances abandonnées.
+};
+
+/**
+ * @brief Fixe la première échéance.
+ *
+ * @param d     Échéancier.
+ * @param now   Date courante.
+ * @param delay Délai avant la première échéance.
+ */
+inline void deadlineStart(Deadline &d, const uint32_t now, const uint32_t delay) {
+
+    d.next = now + delay;
+
+}
+
+/**
+ * @brief Indique si l'échéance est atteinte.
+ */
+inline bool deadlineReached(const Deadline &d, const uint32_t now) {
+
+    return int32_t(now - d.next) >= 0;
+
+}
+
+/**
+ * @brief Programme l'échéance suivante, une période après l'échéance atteinte.
+ *
+ * @param d      Échéancier.
+ * @param now    Date courante.
+ * @param period Période qui sépare l'échéance atteinte de la suivante.
+ * @param policy Comportement après un dépassement.
+ *
+ * @return Nombre d'échéances abandonnées (toujours 0 avec CATCH_UP).
+ */
+inline uint16_t deadlineAdvance(Deadline &d, const uint32_t now, const uint32_t period, const Overrun policy = CATCH_UP) {
+
+    d.next += period;
+
+    if (policy == CATCH_UP || period == 0 || !deadlineReached(d, now)) return 0;
+
+    const uint32_t skipped = (now - d.next) / period + 1;
+
+    d.next += skipped * period;
+
+    return skipped > UINT16_MAX ? UINT16_MAX : skipped;
+
+}
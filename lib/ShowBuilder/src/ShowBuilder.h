@@ -0,0 +1,359 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Construction d'un enchaînement d'animations à la compilation
+ * -------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <Generator.h>
+#include <Transition.h>
+
+namespace show {
+
+/**
+ * @brief Erreurs détectées à la compilation.
+ *
+ * @note Ces fonctions ne sont jamais définies : appelées au cours de
+ *       l'évaluation d'une expression constante, elles la rendent invalide,
+ *       et le compilateur cite leur nom dans son message d'erreur.
+ */
+void error_frame_delay_is_zero();
+void error_repeat_is_zero();
+void error_steps_is_zero();
+void error_generator_is_table();
+void error_lfsr_seed_is_zero();
+void error_timing_index_too_large();
+void error_timing_track_too_long();
+
+/**
+ * @brief Animation déclarée : sa liste de motifs et ses paramètres de
+ *        lecture. Les motifs ne sont pas recopiés : l'animation désigne le
+ *        tableau qui les déclare.
+ */
+template <typename F, size_t N>
+struct Entry {
+
+    const F    (&frames)[N];   // Motifs de l'animation.
+    uint8_t    frame_delay_ms; // Durée d'affichage de chaque motif exprimée en millisecondes.
+    uint8_t    repeat;         // Nombre de répétitions de la séquence.
+    Transition transition;     // Transition qui amène cette animation (voir lib/Transition).
+
+    typedef F Frame;
+    static constexpr size_t size  = N; // Nombre de motifs ajoutés au tableau.
+    static constexpr size_t track = 0; // Nombre d'indices de durée ajoutés à la piste.
+
+};
+
+/**
+ * @brief Animation déclarée avec une durée propre à chacun de ses motifs.
+ *
+ * @note Chaque motif est accompagné d'un indice de durée (de 0 à 15), qui
+ *       désigne un coefficient dans une table de durées partagée par toutes
+ *       les animations, définie par le programme. Les indices sont rangés
+ *       deux par octet dans une piste commune, à raison de 4 bits par motif.
+ */
+template <typename F, size_t N>
+struct Timed {
+
+    Entry<F, N>   entry;       // Motifs et paramètres de lecture.
+    const uint8_t (&timing)[N]; // Indice de durée de chaque motif.
+
+    typedef F Frame;
+    static constexpr size_t size  = N;
+    static constexpr size_t track = N;
+
+};
+
+/**
+ * @brief Animation dont les motifs sont calculés à l'exécution par un
+ *        générateur (voir lib/Generator) : elle n'ajoute aucun motif au
+ *        tableau.
+ */
+struct Generated {
+
+    Generator  generator;      // Générateur des motifs.
+    uint8_t    seed;           // État initial du générateur.
+    uint8_t    steps;          // Nombre de motifs calculés par répétition.
+    uint8_t    frame_delay_ms; // Durée d'affichage de chaque motif exprimée en millisecondes.
+    uint8_t    repeat;         // Nombre de répétitions de la séquence.
+    Transition transition;     // Transition qui amène cette animation (voir lib/Transition).
+
+    typedef uint8_t Frame;
+    static constexpr size_t size  = 0;
+    static constexpr size_t track = 0;
+
+};
+
+/**
+ * @brief Déclaration d'une animation.
+ *
+ * @param frames         Motifs de l'animation.
+ * @param frame_delay_ms Durée d'affichage de chaque motif (1 à 255 ms).
+ * @param repeat         Nombre de répétitions de la séquence (1 à 255).
+ * @param transition     Transition qui amène cette animation.
+ */
+template <typename F, size_t N>
+constexpr Entry<F, N> play(const F (&frames)[N], const uint8_t frame_delay_ms, const uint8_t repeat, const Transition transition = CUT) {
+
+    static_assert(N <= 255, "Une animation compte au plus 255 motifs.");
+
+    if (frame_delay_ms == 0) error_frame_delay_is_zero();
+    if (repeat == 0)         error_repeat_is_zero();
+
+    return { frames, frame_delay_ms, repeat, transition };
+
+}
+
+/**
+ * @brief Déclaration d'une animation dont chaque motif a sa propre durée.
+ *
+ * @param timing Indice de durée de chaque motif (0 à 15) : la durée d'un
+ *               motif vaut `frame_delay_ms`, multipliée par le coefficient
+ *               que désigne son indice.
+ */
+template <typename F, size_t N>
+constexpr Timed<F, N> play(const F (&frames)[N], const uint8_t frame_delay_ms, const uint8_t repeat, const Transition transition, const uint8_t (&timing)[N]) {
+
+    for (size_t i=0; i<N; i++) {
+        if (timing[i] > 15) error_timing_index_too_large();
+    }
+
+    return { play(frames, frame_delay_ms, repeat, transition), timing };
+
+}
+
+/**
+ * @brief Déclaration d'une animation calculée par un générateur.
+ *
+ * @param generator      Générateur des motifs (autre que TABLE).
+ * @param seed           État initial du générateur (non nul pour LFSR).
+ * @param steps          Nombre de motifs calculés par répétition (1 à 255).
+ * @param frame_delay_ms Durée d'affichage de chaque motif (1 à 255 ms).
+ * @param repeat         Nombre de répétitions de la séquence (1 à 255).
+ * @param transition     Transition qui amène cette animation.
+ *
+ * @note Le générateur n'est pas réinitialisé d'une répétition à l'autre :
+ *       la séquence se poursuit sur `steps × repeat` motifs.
+ */
+constexpr Generated generate(const Generator generator, const uint8_t seed, const uint8_t steps, const uint8_t frame_delay_ms, const uint8_t repeat, const Transition transition = CUT) {
+
+    if (generator == TABLE)          error_generator_is_table();
+    if (generator == LFSR && !seed)  error_lfsr_seed_is_zero();
+    if (steps == 0)                  error_steps_is_zero();
+    if (frame_delay_ms == 0)         error_frame_delay_is_zero();
+    if (repeat == 0)                 error_repeat_is_zero();
+
+    return { generator, seed, steps, frame_delay_ms, repeat, transition };
+
+}
+
+/**
+ * @brief Tableau de taille fixe, qui peut être recopié d'un bloc (et donc
+ *        servir à initialiser une donnée rangée en mémoire flash).
+ */
+template <typename T, size_t N>
+struct Array {
+
+    T item[N];
+
+    constexpr const T &operator[](const size_t i) const { return item[i]; }
+    constexpr T       &operator[](const size_t i)       { return item[i]; }
+
+    static constexpr size_t size = N;
+
+};
+
+/**
+ * @brief Enchaînement d'animations : tous les motifs, mis bout à bout, et
+ *        le descripteur de chaque animation.
+ *
+ * @tparam A Type des descripteurs, dont les champs sont, dans l'ordre :
+ *           `start`, `frames`, `frame_delay_ms`, `repeat` et `transition`,
+ *           suivis de `generator` si l'enchaînement compte des animations
+ *           calculées. Pour celles-ci, `start` reçoit l'état initial du
+ *           générateur, et `frames` le nombre de motifs par répétition. Si
+ *           l'enchaînement compte des animations à durées variables, les
+ *           descripteurs ont en outre un champ `track`, qui reçoit la
+ *           position de leur premier indice de durée dans la piste.
+ * @tparam F Type des motifs.
+ * @tparam E Types des animations déclarées.
+ */
+template <typename A, typename F, typename... E>
+struct Show {
+    Array<F, (E::size + ... + 0)> frames;    // Motifs de toutes les animations.
+    Array<A, sizeof...(E)>        animation; // Descripteurs, dans l'ordre de lecture.
+    Array<uint8_t, ((E::track + ... + 0) + 2) / 2> timing; // Piste des indices de durée (4 bits par motif).
+};
+
+/**
+ * @brief Position courante de la construction : descripteur, motif et
+ *        indice de durée suivants.
+ *
+ * @note La position 0 de la piste est réservée : son indice, nul, est celui
+ *       que lisent tous les motifs des animations à durée fixe.
+ */
+struct Cursor {
+    size_t index = 0;
+    size_t start = 0;
+    size_t track = 1;
+};
+
+/**
+ * @brief Type des motifs de la première animation déclarée.
+ */
+template <typename E, typename...>
+struct FrameOf {
+    typedef typename E::Frame type;
+};
+
+/**
+ * @brief Ajout d'une animation à la suite des précédentes.
+ *
+ * @note Le descripteur est initialisé à zéro, puis rempli champ par champ :
+ *       les champs propres à un exercice (générateur, piste de durées) que
+ *       l'animation n'utilise pas restent ainsi nuls.
+ */
+template <typename A, typename S, typename F, size_t N>
+constexpr void append(S &s, Cursor &c, const Entry<F, N> &e) {
+
+    for (size_t i=0; i<N; i++) s.frames[c.start + i] = e.frames[i];
+
+    A a{};
+    a.start          = decltype(A::start)(c.start);
+    a.frames         = uint8_t(N);
+    a.frame_delay_ms = e.frame_delay_ms;
+    a.repeat         = e.repeat;
+    a.transition     = e.transition;
+
+    s.animation[c.index] = a;
+
+    c.start += N;
+    c.index++;
+
+}
+
+template <typename A, typename S, typename F, size_t N>
+constexpr void append(S &s, Cursor &c, const Timed<F, N> &e) {
+
+    for (size_t i=0; i<N; i++) {
+        const size_t position = c.track + i;
+        s.timing[position / 2] |= e.timing[i] << (position % 2 ? 4 : 0);
+    }
+
+    if (c.track > decltype(A::track)(~0)) error_timing_track_too_long();
+
+    append<A>(s, c, e.entry);
+
+    s.animation[c.index - 1].track = decltype(A::track)(c.track);
+
+    c.track += N;
+
+}
+
+template <typename A, typename S>
+constexpr void append(S &s, Cursor &c, const Generated &e) {
+
+    A a{};
+    a.start          = e.seed;
+    a.frames         = e.steps;
+    a.frame_delay_ms = e.frame_delay_ms;
+    a.repeat         = e.repeat;
+    a.transition     = e.transition;
+    a.generator      = e.generator;
+
+    s.animation[c.index++] = a;
+
+}
+
+/**
+ * @brief Construction de l'enchaînement, à partir des animations dans leur
+ *        ordre de lecture.
+ *
+ * @note Les motifs sont mis bout à bout, dans l'ordre des animations : les
+ *       champs `start` et `frames` de chaque descripteur en sont déduits.
+ *       Le résultat doit être affecté à une variable `constexpr` : toute la
+ *       construction a alors lieu à la compilation, et seuls les tableaux
+ *       recopiés en mémoire flash subsistent dans le programme.
+ *
+ *           constexpr auto SHOW = show::build<Animation>(
+ *               show::play(BALAYAGE, 40, 4, DISSOLVE),
+ *               show::play(REBOND,   40, 1, WIPE_DOWN)
+ *           );
+ *
+ *           const auto ANIMATION_FRAME PROGMEM = SHOW.frames;
+ *           const auto animation       PROGMEM = SHOW.animation;
+ */
+template <typename A, typename... E, typename F = typename FrameOf<E...>::type>
+constexpr Show<A, F, E...> build(const E &... entries) {
+
+    static_assert(sizeof...(E) > 0 && sizeof...(E) <= 255, "Un enchaînement compte de 1 à 255 animations.");
+    static_assert((E::size + ... + 0) <= size_t(decltype(A::start)(~0)) + 1, "Le champ `start` ne peut pas indexer tous les motifs.");
+    static_assert((... && (sizeof(typename E::Frame) == sizeof(F))), "Toutes les animations doivent avoir le même type de motif.");
+
+    Show<A, F, E...> s = {};
+    Cursor           c;
+
+    (append<A>(s, c, entries), ...);
+
+    return s;
+
+}
+
+/**
+ * @brief Vérifie qu'une table de descripteurs désigne des séquences non
+ *        vides, situées dans le tableau des motifs, et qui ne se chevauchent
+ *        pas (deux animations peuvent toutefois partager la même séquence).
+ *
+ * @note S'utilise avec static_assert, sur une table construite par build()
+ *       comme sur une table écrite à la main (déclarée `constexpr`). Les
+ *       animations calculées par un générateur ne sont pas concernées.
+ */
+template <typename D>
+constexpr auto stored(const D &d, int) -> decltype(d.generator, bool()) {
+
+    return d.generator == TABLE;
+
+}
+
+template <typename D>
+constexpr bool stored(const D &, long) {
+
+    return true;
+
+}
+
+template <typename T>
+constexpr bool valid(const T &animation, const size_t count, const size_t frames) {
+
+    for (size_t i=0; i<count; i++) {
+
+        if (!stored(animation[i], 0)) continue;
+
+        const size_t start = animation[i].start;
+        const size_t end   = start + animation[i].frames;
+
+        if (animation[i].frames == 0 || end > frames) return false;
+
+        for (size_t j=0; j<i; j++) {
+            if (!stored(animation[j], 0)) continue;
+            const size_t other_start = animation[j].start;
+            const size_t other_end   = other_start + animation[j].frames;
+            const bool   same        = start == other_start && end == other_end;
+            if (!same && start < other_end && other_start < end) return false;
+        }
+
+    }
+
+    return true;
+
+}
+
+} // namespace show
@@ -0,0 +1,150 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Base de temps à la microseconde fournie par le Timer1
+ * -------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * @brief Durée programmée dans le Timer1, en mode CTC.
+ *
+ * @note La durée vaut (compare + 1) tops d'horloge du Timer1, dont la
+ *       fréquence est celle du micro-contrôleur divisée par le pré-diviseur
+ *       que désigne `clock`. Le pré-diviseur est choisi le plus petit
+ *       possible : plus il est petit, plus le top est court, et plus la
+ *       durée obtenue est proche de la durée demandée.
+ *
+ *         pré-diviseur   top        durées            écart maximal
+ *               1        0,0625 µs  20 µs à 4,096 ms  aucun (µs entières)
+ *               8        0,5 µs     jusqu'à 32,77 ms  aucun (µs entières)
+ *              64        4 µs       jusqu'à 262,1 ms  ±2 µs
+ *             256        16 µs      jusqu'à 1,048 s   ±8 µs
+ *            1024        64 µs      jusqu'à 4,194 s   ±32 µs
+ */
+struct TimerPeriod {
+    uint8_t  clock;   // Sélection de l'horloge (bits CS12:CS10 de TCCR1B).
+    uint16_t compare; // Valeur du registre OCR1A.
+};
+
+/**
+ * @brief Durée minimale d'un motif (µs).
+ *
+ * @note La routine d'interruption doit avoir reprogrammé OCR1A avant que le
+ *       compteur ne l'atteigne, et se terminer le plus souvent avant
+ *       l'interruption suivante. Dans l'exercice 21, elle dure environ 182
+ *       cycles, et jusqu'à 385 cycles lorsqu'une nouvelle animation démarre
+ *       (estimation détaillée avec la routine). À 20 µs (320 cycles), le
+ *       motif qui suit un changement d'animation est donc retardé de
+ *       quelques microsecondes.
+ */
+const uint32_t TIMEBASE_MIN_US = 20;
+
+/**
+ * @brief Durée maximale d'un motif (µs), avec le pré-diviseur de 1024.
+ */
+const uint32_t TIMEBASE_MAX_US = 65536UL * 1024 / (F_CPU / 1000000);
+
+/**
+ * @brief Pré-diviseurs du Timer1, indexés par les bits CS12:CS10.
+ */
+constexpr uint16_t TIMER1_PRESCALER[] = { 0, 1, 8, 64, 256, 1024 };
+
+/**
+ * @brief Erreurs détectées à la compilation (voir lib/ShowBuilder).
+ */
+void error_period_too_short();
+void error_period_too_long();
+
+/**
+ * @brief Conversion d'une durée exprimée en microsecondes.
+ *
+ * @note Destinée à être évaluée à la compilation : le séquenceur n'a plus
+ *       qu'à recopier les deux valeurs dans les registres du Timer1.
+ */
+constexpr TimerPeriod timerPeriod(const uint32_t us) {
+
+    if (us < TIMEBASE_MIN_US) error_period_too_short();
+    if (us > TIMEBASE_MAX_US) error_period_too_long();
+
+    const uint32_t cycles = us * (F_CPU / 1000000);
+
+    uint8_t clock = 1;
+
+    while (cycles > 65536UL * TIMER1_PRESCALER[clock]) clock++;
+
+    const uint32_t prescaler = TIMER1_PRESCALER[clock];
+    const uint32_t ticks     = (cycles + prescaler / 2) / prescaler;
+
+    return { clock, uint16_t(ticks - 1) };
+
+}
+
+/**
+ * @brief Durée effectivement programmée (en cycles d'horloge).
+ */
+constexpr uint32_t timerCycles(const TimerPeriod &p) {
+
+    return (uint32_t(p.compare) + 1) * TIMER1_PRESCALER[p.clock];
+
+}
+
+/**
+ * @brief Configuration du Timer1 en mode CTC (Clear Timer on Compare match),
+ *        avec l'interruption de comparaison A.
+ *
+ * @note Le premier appel à la routine d'interruption survient au prochain
+ *       top, et programme la durée du premier motif.
+ */
+inline void timebaseBegin() {
+
+    noInterrupts();
+
+    TCCR1A = 0;                  // sorties OC1A et OC1B déconnectées
+    TCCR1B = _BV(WGM12) | 1;     // mode CTC, pas de pré-division
+    TCNT1  = 0;
+    OCR1A  = 0;
+    TIMSK1 = _BV(OCIE1A);        // interruption de comparaison A
+
+    interrupts();
+
+}
+
+/**
+ * @brief Programmation de la durée qui commence, depuis la routine
+ *        d'interruption de comparaison.
+ *
+ * @note Le compteur vient de repartir de zéro : la prochaine interruption
+ *       surviendra lorsqu'il atteindra la nouvelle valeur de OCR1A. Il a
+ *       cependant déjà compté les quelques tops écoulés depuis l'égalité,
+ *       au rythme de l'ancienne horloge : lorsque celle-ci change, il est
+ *       remis à zéro, ce qui allonge cette durée du temps de prise en charge
+ *       de l'interruption (quelques microsecondes), une fois par changement.
+ *
+ *       Le pré-diviseur, lui, tourne en permanence : sans remise à zéro, le
+ *       premier top à la nouvelle horloge surviendrait n'importe quand dans
+ *       sa période, jusqu'à 1023 cycles (64 µs) trop tôt avec une division
+ *       par 1024. Le bit PSRSYNC le remet à zéro en même temps que le
+ *       compteur. Ce pré-diviseur est commun avec le Timer0, dont le rythme
+ *       est alors légèrement perturbé : c'est sans conséquence ici, puisque
+ *       millis() n'est plus utilisée.
+ */
+inline void timebaseSet(const TimerPeriod &p) {
+
+    OCR1A = p.compare;
+
+    if ((TCCR1B & 0x07) != p.clock) {
+        TCCR1B = _BV(WGM12) | p.clock;
+        GTCCR  = _BV(PSRSYNC);
+        TCNT1  = 0;
+    }
+
+}
@@ -0,0 +1,105 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Transitions entre deux motifs binaires
+ * -------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * @brief Types de transitions d'un motif sortant vers un motif entrant.
+ *
+ * @note Une transition compte TRANSITION_STEPS étapes. L'étape 0 correspond
+ *       au motif sortant, l'étape TRANSITION_STEPS au motif entrant : seules
+ *       les étapes intermédiaires sont donc à afficher.
+ *
+ *       Chaque étape est calculée à la volée à partir des deux motifs, par
+ *       de simples masques et décalages : aucune séquence de raccord n'a
+ *       besoin d'être stockée en mémoire flash.
+ */
+enum Transition : uint8_t {
+    CUT,         // Passage immédiat au motif entrant (aucune étape intermédiaire).
+    WIPE_UP,     // Le motif entrant recouvre le sortant, du bit 0 vers le bit 7.
+    WIPE_DOWN,   // Le motif entrant recouvre le sortant, du bit 7 vers le bit 0.
+    WIPE_OUT,    // Le motif entrant recouvre le sortant, du centre vers les bords.
+    DISSOLVE,    // Les LEDs basculent une à une, dans un ordre pseudo-aléatoire.
+    SLIDE_UP,    // Le motif entrant pousse le sortant vers le bit 7.
+    SLIDE_DOWN   // Le motif entrant pousse le sortant vers le bit 0.
+};
+
+/**
+ * @brief Nombre d'étapes d'une transition (une par LED).
+ */
+const uint8_t TRANSITION_STEPS = 8;
+
+/**
+ * @brief Masques des LEDs déjà gagnées par le motif entrant, à chaque étape.
+ *
+ * @note Les masques sont lus dans de petites tables plutôt que calculés par
+ *       un décalage variable : sur AVR, `1 << step` se traduit par une boucle,
+ *       alors qu'une lecture en table prend toujours le même temps.
+ */
+const uint8_t TRANSITION_MASK[][TRANSITION_STEPS + 1] PROGMEM = {
+    { 0x00, 0x01, 0x03, 0x07, 0x0f, 0x1f, 0x3f, 0x7f, 0xff }, // WIPE_UP
+    { 0x00, 0x80, 0xc0, 0xe0, 0xf0, 0xf8, 0xfc, 0xfe, 0xff }, // WIPE_DOWN
+    { 0x00, 0x08, 0x18, 0x1c, 0x3c, 0x3e, 0x7e, 0x7f, 0xff }, // WIPE_OUT
+    { 0x00, 0x08, 0x48, 0x49, 0x69, 0x6b, 0xeb, 0xef, 0xff }  // DISSOLVE (bits 3, 6, 0, 5, 1, 7, 2, 4)
+};
+
+/**
+ * @brief Puissances de 2 utilisées par les glissements, pour la même raison :
+ *        décaler un octet de `n` bits revient à le multiplier par 2^n, ce que
+ *        le multiplicateur matériel de l'AVR fait en un temps constant.
+ */
+const uint16_t TRANSITION_SHIFT[TRANSITION_STEPS + 1] PROGMEM = {
+    1, 2, 4, 8, 16, 32, 64, 128, 256
+};
+
+/**
+ * @brief Motif affiché à une étape donnée d'une transition.
+ *
+ * @param type Type de transition.
+ * @param from Motif sortant.
+ * @param to   Motif entrant.
+ * @param step Étape de la transition (0 ≤ step ≤ TRANSITION_STEPS).
+ */
+inline uint8_t transitionFrame(const Transition type, const uint8_t from, const uint8_t to, const uint8_t step) {
+
+    switch (type) {
+
+        case WIPE_UP:
+        case WIPE_DOWN:
+        case WIPE_OUT:
+        case DISSOLVE: {
+            const uint8_t mask = pgm_read_byte(&TRANSITION_MASK[type - WIPE_UP][step]);
+            return (to & mask) | (from & ~mask);
+        }
+
+        // Les deux motifs, accolés, glissent d'un bit par étape devant la
+        // fenêtre des 8 LEDs : l'octet de poids faible d'un produit donne le
+        // motif décalé vers le haut, l'octet de poids fort les bits qui
+        // débordent, c'est-à-dire le motif décalé vers le bas.
+        case SLIDE_UP: {
+            const uint16_t k = pgm_read_word(&TRANSITION_SHIFT[step]);
+            return uint8_t(from * k) | uint16_t(to * k) >> 8;
+        }
+
+        case SLIDE_DOWN: {
+            const uint16_t k = pgm_read_word(&TRANSITION_SHIFT[TRANSITION_STEPS - step]);
+            return uint16_t(from * k) >> 8 | uint8_t(to * k);
+        }
+
+        default:
+            return step < TRANSITION_STEPS ? from : to;
+
+    }
+
+}
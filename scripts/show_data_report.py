@@ -0,0 +1,53 @@
+# -------------------------------------------------------------------------
+# Atelier de programmation Robotic 974
+# -------------------------------------------------------------------------
+# Bilan mémoire des données de l'enchaînement d'animations
+# -------------------------------------------------------------------------
+#
+# Script exécuté par PlatformIO après l'édition des liens du firmware.
+# Il relève, dans la table des symboles, les tableaux qui décrivent
+# l'enchaînement d'animations (ANIMATION_*, animation) et indique pour
+# chacun la place occupée en mémoire flash et en mémoire vive (SRAM).
+#
+# Sur AVR, les adresses à partir de 0x800000 désignent la SRAM : une
+# donnée qui s'y trouve (section .data) occupe aussi la flash, où est
+# stockée sa valeur initiale recopiée au démarrage.
+
+import re
+import subprocess
+
+Import("env")
+
+SHOW_SYMBOL = re.compile(r"^(ANIMATION\w*|animation)(\..*)?$")
+SRAM_ORIGIN = 0x800000
+SRAM_SIZE   = 2048
+
+
+def show_data_report(source, target, env):
+
+    nm  = env.subst("$CC").replace("gcc", "nm")
+    elf = str(target[0])
+
+    output = subprocess.check_output([nm, "-C", "-S", "--size-sort", elf], universal_newlines=True)
+
+    flash = sram = 0
+    lines = []
+
+    for line in output.splitlines():
+        fields = line.split()
+        if len(fields) != 4 or not SHOW_SYMBOL.match(fields[3]):
+            continue
+        address, size, name = int(fields[0], 16), int(fields[1], 16), fields[3].split(".")[0]
+        in_sram = address >= SRAM_ORIGIN
+        flash  += 0 if fields[2] in "bB" else size
+        sram   += size if in_sram else 0
+        lines.append("  %-24s %6d octets  %s" % (name, size, "SRAM + flash" if in_sram else "flash"))
+
+    print("Données de l'enchaînement d'animations :")
+    for line in lines:
+        print(line)
+    print("  %-24s %6d octets en flash, %d octets en SRAM (%.1f %% des %d octets)"
+          % ("total", flash, sram, 100.0 * sram / SRAM_SIZE, SRAM_SIZE))
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", show_data_report)
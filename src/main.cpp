@@ -19,7 +19,15 @@
  * 
  *       Chaque programme est indépendant des autres et vous ne pouvez en
  *       compiler qu'un seul à la fois.
+ * 
+ *       Le programme peut également être désigné au moment de la compilation,
+ *       sans modifier ce fichier, en définissant la macro EXERCISE :
+ * 
+ *           -D EXERCISE='"05-binary-counter.h"'
  */
+#ifdef EXERCISE
+#include EXERCISE
+#else
 // #include "00-minimal-arduino-program.h"
 // #include "01-simple-blink.h"
 // #include "02-one-way-scanning.h"
@@ -28,4 +36,20 @@
 // #include "05-binary-counter.h"
 // #include "06-simple-animation.h"
 // #include "07-animations-v1.h"
-#include "08-animations-v2.h"
\ No newline at end of file
+// #include "08-animations-v2.h"
+// #include "09-compressed-animations.h"
+// #include "10-procedural-animations.h"
+// #include "11-timer-player.h"
+// #include "12-bcm-brightness.h"
+// #include "13-uart-streaming.h"
+// #include "14-eeprom-show-upload.h"
+// #include "15-shift-register-spi.h"
+// #include "16-layered-players.h"
+// #include "17-tickless-sleep.h"
+// #include "18-perf-counters.h"
+// #include "19-compiled-show.h"
+// #include "20-generated-animations.h"
+// #include "21-microsecond-timebase.h"
+// #include "22-frame-durations.h"
+#include "23-playlist.h"
+#endif
\ No newline at end of file
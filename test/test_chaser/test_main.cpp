@@ -0,0 +1,133 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Tests de la classe Chaser : écritures dans les ports D, B et C
+ * -------------------------------------------------------------------------
+ */
+
+/**
+ * @brief Tests des câblages autres que la rampe de 8 LEDs des exercices.
+ *
+ * @note Pour chaque câblage, tous les motifs possibles sont affichés, et les
+ *       registres PORTD, PORTB et PORTC obtenus sont comparés à ceux que
+ *       donne un calcul naïf, LED par LED. Les bits des ports qui ne
+ *       commandent aucune LED sont mis à 1 au préalable : ils doivent rester
+ *       intacts.
+ *
+ *       Les câblages dans l'ordre des broches sont affichés par décalage,
+ *       les autres bit par bit (voir lib/Chaser) : les deux méthodes sont
+ *       donc vérifiées.
+ *
+ *       Lancement des tests :
+ *
+ *           pio test -e native -f test_chaser
+ */
+
+#include <Arduino.h>
+#include <Chaser.h>
+
+#include <unity.h>
+
+#include <cstdio>
+
+// ----------------------------------------------------------------------------
+// Calcul de référence
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Valeurs attendues des ports D, B et C, LED par LED.
+ *
+ * @param pins    Broches des LEDs, de la LED d'indice 0 à la dernière.
+ * @param size    Nombre de LEDs.
+ * @param pattern Motif affiché.
+ * @param port    Valeurs initiales des ports D, B et C, que l'on modifie.
+ */
+void expected(const uint8_t *pins, const uint8_t size, const uint32_t pattern, uint8_t port[3]) {
+
+    for (uint8_t i=0; i<size; i++) {
+
+        const uint8_t p   = pins[i];
+        const uint8_t n   = p < 8 ? 0 : p < 14 ? 1 : 2;
+        const uint8_t bit = 1 << (p - (n == 0 ? 0 : n == 1 ? 8 : 14));
+
+        port[n] = (pattern >> i) & 1 ? port[n] | bit : port[n] & ~bit;
+
+    }
+
+}
+
+/**
+ * @brief Affichage de tous les motifs d'un câblage, et comparaison des ports.
+ */
+template <uint8_t... Pins>
+void check() {
+
+    typedef Chaser<Pins...> Leds;
+
+    const uint8_t pins[] = { Pins... };
+    const uint8_t size   = Leds::size;
+
+    hal::reset();
+    Leds::begin();
+
+    // Les LEDs, et elles seules, sont en sortie.
+    uint8_t ddr[3] = { 0, 0, 0 };
+    expected(pins, size, 0xffffffff, ddr);
+
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(ddr[0], DDRD, "DDRD");
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(ddr[1], DDRB, "DDRB");
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(ddr[2], DDRC, "DDRC");
+
+    PORTD = 0xff;
+    PORTB = 0xff;
+    PORTC = 0xff;
+
+    uint8_t port[3] = { 0xff, 0xff, 0xff };
+
+    for (uint32_t pattern=0; pattern < (uint32_t(1) << size); pattern++) {
+
+        Leds::write(typename Leds::Frame(pattern));
+        expected(pins, size, pattern, port);
+
+        if (PORTD != port[0] || PORTB != port[1] || PORTC != port[2]) {
+            char message[128];
+            snprintf(message, sizeof(message),
+                     "motif 0x%04x : attendu D=0x%02x B=0x%02x C=0x%02x, obtenu D=0x%02x B=0x%02x C=0x%02x",
+                     (unsigned) pattern, port[0], port[1], port[2],
+                     uint8_t(PORTD), uint8_t(PORTB), uint8_t(PORTC));
+            TEST_FAIL_MESSAGE(message);
+        }
+
+    }
+
+}
+
+// ----------------------------------------------------------------------------
+// Tests
+// ----------------------------------------------------------------------------
+
+void test_in_order_12()  { check<2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13>(); }
+void test_in_order_16()  { check<2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17>(); }
+void test_shuffled_12()  { check<9, 4, 12, 6, 3, 13, 2, 7, 10, 5, 11, 8>(); }
+void test_reversed_16()  { check<17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2>(); }
+
+void setUp() {}
+void tearDown() {}
+
+int main() {
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_in_order_12);
+    RUN_TEST(test_in_order_16);
+    RUN_TEST(test_shuffled_12);
+    RUN_TEST(test_reversed_16);
+
+    return UNITY_END();
+
+}
@@ -0,0 +1,341 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Tests de non-régression : comparaison avec des traces de référence
+ * -------------------------------------------------------------------------
+ */
+
+/**
+ * @brief Tests de non-régression des exercices 02 à 10, 19, 20, 22 et 23.
+ *
+ * @note Chaque exercice est exécuté sur l'horloge virtuelle de
+ *       lib/ArduinoNative, puis la suite des motifs affichés sur la rampe
+ *       (date, motif) est comparée à une trace de référence, enregistrée
+ *       dans le dossier `golden`. Le premier motif qui diffère est signalé.
+ *
+ *       Les exercices 09 et 10 ne changent que le stockage des animations de
+ *       l'exercice 07, et l'exercice 19 celui de l'exercice 08 : ils sont
+ *       comparés à la trace de référence de l'exercice qu'ils reprennent.
+ *
+ *       Les exercices définissent tous leurs propres fonctions setup() et
+ *       loop() : chacun est donc inclus dans son propre espace de noms. Les
+ *       bibliothèques qu'ils utilisent sont incluses au préalable, une fois
+ *       pour toutes, hors de ces espaces de noms.
+ *
+ *       Lancement des tests :
+ *
+ *           pio test -e native
+ *
+ *       Lorsqu'une modification du comportement d'un exercice est voulue,
+ *       les traces de référence sont régénérées en définissant la variable
+ *       d'environnement GOLDEN_UPDATE :
+ *
+ *           GOLDEN_UPDATE=1 pio test -e native
+ */
+
+#include <Arduino.h>
+#include <Bench.h>
+#include <Chaser.h>
+#include <Frames.h>
+#include <Generator.h>
+#include <Playlist.h>
+#include <Scheduler.h>
+#include <ShowBuilder.h>
+#include <Transition.h>
+
+#include <unity.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace ex02 {
+#include "02-one-way-scanning.h"
+}
+
+namespace ex03 {
+#include "03-two-way-scanning.h"
+}
+
+namespace ex04 {
+#include "04-revised-blink.h"
+}
+
+namespace ex05 {
+#include "05-binary-counter.h"
+}
+
+namespace ex06 {
+#include "06-simple-animation.h"
+}
+
+namespace ex07 {
+#include "07-animations-v1.h"
+}
+
+namespace ex08 {
+#include "08-animations-v2.h"
+}
+
+namespace ex09 {
+#include "09-compressed-animations.h"
+}
+
+namespace ex10 {
+#include "10-procedural-animations.h"
+}
+
+namespace ex19 {
+#include "19-compiled-show.h"
+}
+
+// La macro SHOW, qui désigne le spectacle de l'exercice 19, masquerait le
+// spectacle que les exercices suivants construisent sous ce nom.
+#undef SHOW
+
+namespace ex20 {
+#include "20-generated-animations.h"
+}
+
+namespace ex22 {
+#include "22-frame-durations.h"
+}
+
+namespace ex23 {
+#include "23-playlist.h"
+}
+
+// ----------------------------------------------------------------------------
+// Définition des constantes
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Durée simulée de chaque exercice (µs), et pas de l'horloge entre
+ *        deux appels à loop().
+ */
+const uint64_t DURATION_US = 120000000;
+const uint32_t STEP_US     = 1000;
+
+/**
+ * @brief Broche de la LED d'indice 0 : la LED d'indice `i` est branchée sur
+ *        la broche D(5 + i) dans tous les exercices.
+ */
+const uint8_t FIRST_LED_PIN = 5;
+const uint8_t NUM_LEDS      = 8;
+
+// ----------------------------------------------------------------------------
+// Traces des motifs affichés
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Motif affiché sur la rampe à une date donnée.
+ */
+struct Frame {
+    uint64_t time_us; // Date de l'affichage.
+    uint8_t  pattern; // Motif : le bit `i` correspond à la LED d'indice `i`.
+};
+
+typedef std::vector<Frame> Trace;
+
+/**
+ * @brief Exécution d'un exercice et relevé des motifs affichés.
+ *
+ * @note Les changements d'état de même date sont regroupés : le motif
+ *       retenu est celui qu'affiche la rampe une fois tous appliqués, et il
+ *       n'est consigné que s'il diffère du précédent.
+ */
+Trace play(void (*setup)(), void (*loop)()) {
+
+    hal::reset();
+    hal::run(DURATION_US, STEP_US, setup, loop);
+
+    Trace trace;
+    uint8_t pattern = 0;
+
+    const std::vector<hal::PinEvent> &events = hal::trace();
+
+    for (size_t i=0; i<events.size(); i++) {
+
+        const hal::PinEvent &e = events[i];
+
+        if (e.pin >= FIRST_LED_PIN && e.pin < FIRST_LED_PIN + NUM_LEDS) {
+            const uint8_t bit = 1 << (e.pin - FIRST_LED_PIN);
+            pattern = e.level ? pattern | bit : pattern & ~bit;
+        }
+
+        const bool last = i + 1 == events.size() || events[i + 1].time_us != e.time_us;
+
+        if (last && (trace.empty() || trace.back().pattern != pattern)) {
+            trace.push_back({ e.time_us, pattern });
+        }
+
+    }
+
+    return trace;
+
+}
+
+/**
+ * @brief Chemin de la trace de référence d'un exercice, rangée à côté de ce
+ *        fichier source.
+ */
+std::string goldenPath(const char *name) {
+
+    std::string dir = __FILE__;
+    dir.erase(dir.find_last_of("/\\") + 1);
+
+    return dir + "golden/" + name + ".txt";
+
+}
+
+/**
+ * @brief Lecture d'une trace de référence.
+ *
+ * @note Chaque ligne donne la date (µs) et le motif (en hexadécimal). Les
+ *       lignes qui commencent par `#` sont des commentaires.
+ */
+bool readGolden(const std::string &path, Trace &trace) {
+
+    FILE * const f = fopen(path.c_str(), "r");
+
+    if (f == nullptr) return false;
+
+    char line[64];
+
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long long time_us;
+        unsigned pattern;
+        if (line[0] != '#' && sscanf(line, "%llu %x", &time_us, &pattern) == 2) {
+            trace.push_back({ time_us, uint8_t(pattern) });
+        }
+    }
+
+    fclose(f);
+
+    return true;
+
+}
+
+/**
+ * @brief Écriture d'une trace de référence.
+ */
+bool writeGolden(const std::string &path, const char *name, const Trace &trace) {
+
+    FILE * const f = fopen(path.c_str(), "w");
+
+    if (f == nullptr) return false;
+
+    fprintf(f, "# %s.h : %llu s simulées, pas de %u µs\n", name, (unsigned long long) DURATION_US / 1000000, (unsigned) STEP_US);
+    fprintf(f, "# date (µs), motif (bit i = LED d'indice i, sur la broche D%u+i)\n", (unsigned) FIRST_LED_PIN);
+
+    for (const Frame &frame : trace) {
+        fprintf(f, "%llu 0x%02x\n", (unsigned long long) frame.time_us, frame.pattern);
+    }
+
+    fclose(f);
+
+    return true;
+
+}
+
+/**
+ * @brief Exécution d'un exercice et comparaison avec sa trace de référence.
+ *
+ * @param golden Trace de référence, lorsque l'exercice doit reproduire
+ *               exactement un exercice précédent (par défaut, la sienne).
+ *               Elle n'est alors pas régénérée par GOLDEN_UPDATE, mais
+ *               comparée à celle que l'exercice précédent vient d'écrire.
+ */
+void check(const char *name, void (*setup)(), void (*loop)(), const char *golden = nullptr) {
+
+    const auto start = std::chrono::steady_clock::now();
+    const Trace actual = play(setup, loop);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    char message[160];
+
+    snprintf(message, sizeof(message), "%s : %zu motifs, %llu s simulées en %.2f ms",
+             name, actual.size(), (unsigned long long) DURATION_US / 1000000, elapsed.count() * 1e3);
+    TEST_MESSAGE(message);
+
+    const std::string path = goldenPath(golden ? golden : name);
+
+    if (getenv("GOLDEN_UPDATE") && golden == nullptr) {
+        TEST_ASSERT_TRUE_MESSAGE(writeGolden(path, name, actual), path.c_str());
+        return;
+    }
+
+    Trace expected;
+
+    TEST_ASSERT_TRUE_MESSAGE(readGolden(path, expected), path.c_str());
+
+    for (size_t i=0; i<expected.size() && i<actual.size(); i++) {
+
+        const Frame &e = expected[i];
+        const Frame &a = actual[i];
+
+        if (e.time_us != a.time_us || e.pattern != a.pattern) {
+            snprintf(message, sizeof(message),
+                     "motif n°%zu : attendu 0x%02x à %llu µs, obtenu 0x%02x à %llu µs",
+                     i, e.pattern, (unsigned long long) e.time_us, a.pattern, (unsigned long long) a.time_us);
+            TEST_FAIL_MESSAGE(message);
+        }
+
+    }
+
+    if (expected.size() != actual.size()) {
+        snprintf(message, sizeof(message), "%zu motifs attendus, %zu obtenus", expected.size(), actual.size());
+        TEST_FAIL_MESSAGE(message);
+    }
+
+}
+
+// ----------------------------------------------------------------------------
+// Tests
+// ----------------------------------------------------------------------------
+
+void test_02_one_way_scanning()       { check("02-one-way-scanning",       ex02::setup, ex02::loop); }
+void test_03_two_way_scanning()       { check("03-two-way-scanning",       ex03::setup, ex03::loop); }
+void test_04_revised_blink()          { check("04-revised-blink",          ex04::setup, ex04::loop); }
+void test_05_binary_counter()         { check("05-binary-counter",         ex05::setup, ex05::loop); }
+void test_06_simple_animation()       { check("06-simple-animation",       ex06::setup, ex06::loop); }
+void test_07_animations_v1()          { check("07-animations-v1",          ex07::setup, ex07::loop); }
+void test_08_animations_v2()          { check("08-animations-v2",          ex08::setup, ex08::loop); }
+void test_09_compressed_animations()  { check("09-compressed-animations",  ex09::setup, ex09::loop, "07-animations-v1"); }
+void test_10_procedural_animations()  { check("10-procedural-animations",  ex10::setup, ex10::loop, "07-animations-v1"); }
+void test_19_compiled_show()          { check("19-compiled-show",          ex19::setup, ex19::loop, "08-animations-v2"); }
+void test_20_generated_animations()   { check("20-generated-animations",   ex20::setup, ex20::loop); }
+void test_22_frame_durations()        { check("22-frame-durations",        ex22::setup, ex22::loop); }
+void test_23_playlist()               { check("23-playlist",               ex23::setup, ex23::loop); }
+
+void setUp() {}
+void tearDown() {}
+
+int main() {
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_02_one_way_scanning);
+    RUN_TEST(test_03_two_way_scanning);
+    RUN_TEST(test_04_revised_blink);
+    RUN_TEST(test_05_binary_counter);
+    RUN_TEST(test_06_simple_animation);
+    RUN_TEST(test_07_animations_v1);
+    RUN_TEST(test_08_animations_v2);
+    RUN_TEST(test_09_compressed_animations);
+    RUN_TEST(test_10_procedural_animations);
+    RUN_TEST(test_19_compiled_show);
+    RUN_TEST(test_20_generated_animations);
+    RUN_TEST(test_22_frame_durations);
+    RUN_TEST(test_23_playlist);
+
+    return UNITY_END();
+
+}
@@ -0,0 +1,135 @@
+/*
+ * -------------------------------------------------------------------------
+ * Atelier de programmation Robotic 974
+ * © 2020 Stéphane Calderoni
+ * -------------------------------------------------------------------------
+ * Introduction à la programmation des cartes Arduino
+ * Implémentation d'un chenillard à 8 LEDs
+ * -------------------------------------------------------------------------
+ * Tests du téléversement d'un spectacle en EEPROM (exercice 14)
+ * -------------------------------------------------------------------------
+ */
+
+/**
+ * @brief Tests de la vérification des images téléversées.
+ *
+ * @note Chaque test téléverse une image d'une seule animation de 2 motifs,
+ *       paquet par paquet, sur la liaison série simulée, puis compare les
+ *       réponses de la carte à celles attendues. Une image refusée ne doit
+ *       jamais devenir le spectacle actif.
+ *
+ *       Sur l'AVR, où `int` ne fait que 16 bits, une animation qui commençait
+ *       au motif 0xffff échappait au contrôle des bornes (0xffff + 2 = 1).
+ *       Sur l'ordinateur, `int` fait 32 bits et ce débordement n'a pas lieu :
+ *       le test vérifie donc le refus de l'image, mais seul le contrôle sans
+ *       addition de checkImage() le garantit aussi sur la carte.
+ *
+ *       Lancement des tests :
+ *
+ *           pio test -e native -f test_upload
+ */
+
+#include "14-eeprom-show-upload.h"
+
+#include <unity.h>
+
+#include <string>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Hôte simulé
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Ajout d'un paquet du protocole de téléversement à un flux d'octets.
+ */
+void append(std::vector<uint8_t> &stream, const uint8_t command, const std::vector<uint8_t> &data) {
+
+    uint8_t crc = crc8(crc8(0, command), data.size());
+    for (const uint8_t c : data) crc = crc8(crc, c);
+
+    stream.push_back(PACKET_SYNC);
+    stream.push_back(command);
+    stream.push_back(data.size());
+    stream.insert(stream.end(), data.begin(), data.end());
+    stream.push_back(crc);
+
+}
+
+/**
+ * @brief Téléversement d'une image d'une animation de 2 motifs.
+ *
+ * @param start  Indice du premier motif de l'animation.
+ * @param frames Nombre de motifs de l'animation.
+ *
+ * @return Les réponses de la carte.
+ */
+std::string upload_image(const uint16_t start, const uint8_t frames) {
+
+    const std::vector<uint8_t> image = {
+        1, 2, 0,                                         // 1 animation, 2 motifs
+        uint8_t(start), uint8_t(start >> 8), frames, 10, 1, CUT,
+        0b00011000, 0b00100100
+    };
+
+    uint16_t crc = 0xffff;
+    for (const uint8_t c : image) crc = crc16(crc, c);
+
+    std::vector<uint8_t> data = { 0, 0 };
+    data.insert(data.end(), image.begin(), image.end());
+
+    std::vector<uint8_t> stream;
+    append(stream, 'B', { uint8_t(image.size()), 0 });
+    append(stream, 'W', data);
+    append(stream, 'C', { uint8_t(crc), uint8_t(crc >> 8) });
+
+    hal::reset();
+    hal::serialInput(stream, 1000);
+    hal::run(1000000, 100);
+
+    return hal::serialOutput();
+
+}
+
+// ----------------------------------------------------------------------------
+// Tests
+// ----------------------------------------------------------------------------
+
+const std::string REFUSED  = { char(ACK), char(ACK), char(NAK) };
+const std::string ACCEPTED = { char(ACK), char(ACK), char(ACK) };
+
+void test_start_overflow() {
+
+    TEST_ASSERT_TRUE_MESSAGE(upload_image(0xffff, 2) == REFUSED, "réponses");
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(0xff, eeprom_read_byte(eeprom(EEPROM_ACTIVE)), "emplacement actif");
+
+}
+
+void test_frames_out_of_range() {
+
+    TEST_ASSERT_TRUE_MESSAGE(upload_image(1, 2) == REFUSED, "réponses");
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(0xff, eeprom_read_byte(eeprom(EEPROM_ACTIVE)), "emplacement actif");
+
+}
+
+void test_valid_image() {
+
+    TEST_ASSERT_TRUE_MESSAGE(upload_image(0, 2) == ACCEPTED, "réponses");
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(0, eeprom_read_byte(eeprom(EEPROM_ACTIVE)), "emplacement actif");
+
+}
+
+void setUp() {}
+void tearDown() {}
+
+int main() {
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_start_overflow);
+    RUN_TEST(test_frames_out_of_range);
+    RUN_TEST(test_valid_image);
+
+    return UNITY_END();
+
+}
@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+# -------------------------------------------------------------------------
+# Atelier de programmation Robotic 974
+# -------------------------------------------------------------------------
+# Codec de compression des séquences de motifs (exercice 09)
+# -------------------------------------------------------------------------
+#
+# Une séquence compressée est une suite d'opérations. Chaque opération
+# occupe un octet d'en-tête `ooonnnnn`, éventuellement suivi d'octets de
+# données, et produit un ou plusieurs motifs à partir du motif précédent
+# (qui vaut 0 au début de la séquence) :
+#
+#   000nnnnn           HOLD    répète le motif précédent, n+1 fois
+#   001nnnnn           SHL     décale le motif d'un bit à gauche, n+1 fois
+#   010nnnnn           SHR     décale le motif d'un bit à droite, n+1 fois
+#   011nnnnn           ROL     fait tourner le motif d'un bit à gauche, n+1 fois
+#   100nnnnn           ROR     fait tourner le motif d'un bit à droite, n+1 fois
+#   101nnnnn mask      XOR     applique le masque `mask` (ou exclusif), n+1 fois
+#   110nnnnn f0 .. fn  LITERAL produit les n+1 motifs qui suivent, tels quels
+#   111p0bbb           TOGGLE  inverse le bit b (p = 0) ou les bits b et b+1
+#                              (p = 1), une seule fois
+#
+# Le décodeur n'a donc jamais plus de deux octets à lire pour produire un
+# motif. L'encodeur cherche, par programmation dynamique, la suite
+# d'opérations la plus courte qui reproduit exactement la séquence.
+#
+# Usage : show_codec.py fichier
+#
+#   Le fichier décrit une animation par ligne, sous la forme d'une liste de
+#   motifs binaires (par exemple `10000000 01000000 00100000`). Le script
+#   affiche le tableau ANIMATION_STREAM[] correspondant, ainsi que les
+#   indices de départ et nombres de motifs de chaque animation.
+
+import sys
+
+HOLD, SHL, SHR, ROL, ROR, XOR, LITERAL, TOGGLE = range(8)
+
+MAX_RUN = 32
+
+NAMES = ["HOLD", "SHL", "SHR", "ROL", "ROR", "XOR", "LITERAL", "TOGGLE"]
+
+
+def step(op, pattern, mask=0):
+    """Motif produit par une itération de l'opération `op`."""
+    if op == HOLD:
+        return pattern
+    if op == SHL:
+        return (pattern << 1) & 0xff
+    if op == SHR:
+        return pattern >> 1
+    if op == ROL:
+        return ((pattern << 1) | (pattern >> 7)) & 0xff
+    if op == ROR:
+        return ((pattern >> 1) | (pattern << 7)) & 0xff
+    return pattern ^ mask
+
+
+def toggle_mask(code):
+    """Masque appliqué par l'opération TOGGLE d'en-tête `code`."""
+    bit = code & 0x07
+    return (0x03 << bit) & 0xff if code & 0x10 else 1 << bit
+
+
+def toggle_code(delta):
+    """En-tête TOGGLE qui produit le masque `delta`, ou None."""
+    for code in range(0xe0, 0x100):
+        if code & 0x08 or (code & 0x10 and code & 0x07 == 7):
+            continue
+        if toggle_mask(code) == delta:
+            return code
+    return None
+
+
+def encode(frames):
+    """Encode une séquence de motifs et retourne la liste des octets."""
+
+    n = len(frames)
+    INF = float("inf")
+
+    # cost[i] : taille minimale de l'encodage des i premiers motifs.
+    cost = [0] + [INF] * n
+    choice = [None] * (n + 1)
+
+    for i in range(n):
+
+        if cost[i] == INF:
+            continue
+
+        previous = frames[i - 1] if i else 0
+
+        def offer(j, size, data):
+            if cost[i] + size < cost[j]:
+                cost[j] = cost[i] + size
+                choice[j] = (i, data)
+
+        # Opérations sans donnée, répétées.
+        for op in (HOLD, SHL, SHR, ROL, ROR):
+            pattern = previous
+            for k in range(1, min(MAX_RUN, n - i) + 1):
+                pattern = step(op, pattern)
+                if pattern != frames[i + k - 1]:
+                    break
+                offer(i + k, 1, [(op << 5) | (k - 1)])
+
+        # Masque XOR répété.
+        mask = frames[i] ^ previous
+        pattern = previous
+        for k in range(1, min(MAX_RUN, n - i) + 1):
+            pattern ^= mask
+            if pattern != frames[i + k - 1]:
+                break
+            offer(i + k, 2, [(XOR << 5) | (k - 1), mask])
+
+        # Motifs littéraux.
+        for k in range(1, min(MAX_RUN, n - i) + 1):
+            offer(i + k, 1 + k, [(LITERAL << 5) | (k - 1)] + frames[i:i + k])
+
+        # Inversion d'un bit ou de deux bits voisins.
+        code = toggle_code(mask)
+        if code is not None:
+            offer(i + 1, 1, [code])
+
+    stream = []
+    j = n
+    while j:
+        i, data = choice[j]
+        stream[:0] = data
+        j = i
+
+    return stream
+
+
+def decode(stream, count):
+    """Décode `count` motifs : réplique exacte du décodeur de l'exercice 09."""
+
+    frames = []
+    cursor = 0
+    pattern = 0
+    run = 0
+    op = mask = 0
+
+    while len(frames) < count:
+
+        if run == 0:
+            code = stream[cursor]
+            cursor += 1
+            op, run = code >> 5, (code & 0x1f) + 1
+            if op == XOR:
+                mask = stream[cursor]
+                cursor += 1
+            elif op == TOGGLE:
+                mask, run = toggle_mask(code), 1
+
+        if op == LITERAL:
+            pattern = stream[cursor]
+            cursor += 1
+        elif op == TOGGLE:
+            pattern ^= mask
+        else:
+            pattern = step(op, pattern, mask)
+
+        run -= 1
+        frames.append(pattern)
+
+    return frames
+
+
+def describe(stream):
+    """Liste lisible des opérations d'un flux encodé."""
+
+    ops = []
+    cursor = 0
+    while cursor < len(stream):
+        code = stream[cursor]
+        op, n = code >> 5, (code & 0x1f) + 1
+        if op == TOGGLE:
+            ops.append("TOGGLE 0x%02x" % toggle_mask(code))
+            cursor += 1
+        elif op == XOR:
+            ops.append("XOR 0x%02x x%d" % (stream[cursor + 1], n))
+            cursor += 2
+        elif op == LITERAL:
+            ops.append("LITERAL x%d" % n)
+            cursor += 1 + n
+        else:
+            ops.append("%s x%d" % (NAMES[op], n))
+            cursor += 1
+    return ", ".join(ops)
+
+
+def main(path):
+
+    animations = []
+    with open(path) as f:
+        for line in f:
+            line = line.split("#")[0].split()
+            if line:
+                animations.append([int(frame, 2) for frame in line])
+
+    start = 0
+    total_raw = 0
+
+    print("const uint8_t ANIMATION_STREAM[] PROGMEM = {")
+    for index, frames in enumerate(animations):
+        stream = encode(frames)
+        assert decode(stream, len(frames)) == frames
+        print()
+        print("    // animation #%d : %d motifs, %d octets (%s)" % (index, len(frames), len(stream), describe(stream)))
+        print()
+        for i in range(0, len(stream), 8):
+            print("    " + ", ".join("0x%02x" % b for b in stream[i:i + 8]) + ",")
+        animations[index] = (start, len(frames))
+        start += len(stream)
+        total_raw += len(frames)
+    print()
+    print("};")
+    print()
+    for index, (first, count) in enumerate(animations):
+        print("// animation #%d : start = %d, frames = %d" % (index, first, count))
+    print("// %d octets compressés pour %d motifs (%.1f fois moins)" % (start, total_raw, total_raw / start))
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 2:
+        sys.exit("usage: show_codec.py fichier")
+    main(sys.argv[1])
@@ -0,0 +1,275 @@
+#!/usr/bin/env python3
+# -------------------------------------------------------------------------
+# Atelier de programmation Robotic 974
+# -------------------------------------------------------------------------
+# Compilateur de spectacles : description textuelle → en-tête C++ (flash)
+# -------------------------------------------------------------------------
+#
+# Le spectacle est décrit par un fichier texte. Chaque animation porte un
+# nom, et est déclarée par une ligne :
+#
+#   animation nom durée répétitions [transition]
+#
+# suivie de ses motifs, écrits en binaire (par exemple `10000001`, le bit de
+# gauche commandant la LED d'indice 7), sur autant de lignes que l'on veut.
+# La durée d'affichage de chaque motif est exprimée en millisecondes, et la
+# transition qui amène l'animation est l'une de celles définies dans
+# lib/Transition (CUT par défaut).
+#
+# Les animations sont jouées dans l'ordre de leur déclaration, à moins
+# qu'une ligne :
+#
+#   show nom nom nom ...
+#
+# ne fixe l'ordre de lecture. Une même animation peut alors y figurer
+# plusieurs fois, sans que ses motifs soient dupliqués.
+#
+# Le compilateur vérifie la description (noms, motifs, durées, répétitions,
+# transitions), puis calcule lui-même l'emplacement de chaque animation dans
+# le tableau des motifs : les séquences identiques, ou contenues dans une
+# autre, ne sont stockées qu'une seule fois. Le type des indices est le plus
+# court possible (8 bits si le tableau compte au plus 256 motifs), ce qui
+# épargne au séquenceur des calculs sur 16 bits.
+#
+# Usage :
+#
+#   show_compile.py spectacle.show include/shows/spectacle.h
+#
+#       Écrit l'en-tête, et affiche la place qu'il occupe en mémoire flash
+#       et en mémoire vive (SRAM).
+
+import argparse
+import os
+import sys
+
+TRANSITIONS = ["CUT", "WIPE_UP", "WIPE_DOWN", "WIPE_OUT", "DISSOLVE", "SLIDE_UP", "SLIDE_DOWN"]
+
+NUM_LEDS = 8
+MAX_ANIMATIONS = 255
+MAX_FRAMES = 65535
+
+
+class ShowError(Exception):
+    pass
+
+
+def parse(path):
+    """Animations déclarées (nom → (durée, répétitions, transition, motifs))
+    et ordre de lecture."""
+    animations = {}
+    order = None
+    current = None
+
+    def error(number, message):
+        raise ShowError("%s:%d : %s" % (path, number, message))
+
+    def number_in(number, text, what):
+        if not text.isdigit() or not 1 <= int(text) <= 255:
+            error(number, "%s invalide : '%s' (de 1 à 255)" % (what, text))
+        return int(text)
+
+    with open(path) as f:
+        for number, line in enumerate(f, 1):
+            words = line.split("#")[0].split()
+            if not words:
+                continue
+
+            if words[0] == "animation":
+                if len(words) not in (4, 5):
+                    error(number, "syntaxe : animation nom durée répétitions [transition]")
+                name = words[1]
+                if not name.isidentifier():
+                    error(number, "nom d'animation invalide : '%s'" % name)
+                if name in animations:
+                    error(number, "animation '%s' déjà déclarée" % name)
+                delay = number_in(number, words[2], "durée")
+                repeat = number_in(number, words[3], "nombre de répétitions")
+                transition = words[4].upper() if len(words) == 5 else "CUT"
+                if transition not in TRANSITIONS:
+                    error(number, "transition inconnue : '%s' (%s)" % (words[4], ", ".join(TRANSITIONS)))
+                current = name
+                animations[name] = (delay, repeat, transition, [], number)
+
+            elif words[0] == "show":
+                if order is not None:
+                    error(number, "ordre de lecture déjà fixé")
+                order = [(name, number) for name in words[1:]]
+                current = None
+
+            else:
+                if current is None:
+                    error(number, "motif hors d'une animation")
+                for word in words:
+                    if len(word) != NUM_LEDS or set(word) - set("01"):
+                        error(number, "motif invalide : '%s' (%d chiffres binaires)" % (word, NUM_LEDS))
+                    animations[current][3].append(int(word, 2))
+
+    for name, (delay, repeat, transition, frames, number) in animations.items():
+        if not frames:
+            error(number, "l'animation '%s' ne compte aucun motif" % name)
+        if len(frames) > 255:
+            error(number, "l'animation '%s' compte %d motifs (255 au plus)" % (name, len(frames)))
+
+    if order is None:
+        order = [(name, animations[name][4]) for name in animations]
+
+    for name, number in order:
+        if name not in animations:
+            error(number, "animation inconnue : '%s'" % name)
+
+    if not order:
+        raise ShowError("%s : spectacle vide" % path)
+    if len(order) > MAX_ANIMATIONS:
+        raise ShowError("%s : %d animations au programme (%d au plus)" % (path, len(order), MAX_ANIMATIONS))
+
+    unused = [name for name in animations if name not in {n for n, _ in order}]
+    for name in unused:
+        print("%s:%d : avertissement : l'animation '%s' n'est jamais jouée" % (path, animations[name][4], name),
+              file=sys.stderr)
+
+    return animations, [name for name, _ in order]
+
+
+def find(storage, frames):
+    """Position d'une séquence dans le tableau des motifs, ou -1."""
+    n = len(frames)
+    for start in range(len(storage) - n + 1):
+        if storage[start:start + n] == frames:
+            return start
+    return -1
+
+
+def layout(animations, names):
+    """Tableau des motifs et position de chaque animation jouée.
+
+    Les séquences les plus longues sont placées en premier, afin que les
+    plus courtes puissent s'y retrouver. Une séquence qui n'y figure pas est
+    ajoutée à la fin du tableau, en la faisant chevaucher la fin de celui-ci
+    lorsque c'est possible."""
+    storage = []
+    start = {}
+    for name in sorted(set(names), key=lambda n: (-len(animations[n][3]), names.index(n))):
+        frames = animations[name][3]
+        position = find(storage, frames)
+        if position < 0:
+            overlap = next(k for k in range(min(len(frames), len(storage)), -1, -1)
+                           if k == 0 or storage[-k:] == frames[:k])
+            position = len(storage) - overlap
+            storage += frames[overlap:]
+        start[name] = position
+    if len(storage) > MAX_FRAMES:
+        raise ShowError("%d motifs (%d au plus)" % (len(storage), MAX_FRAMES))
+    return storage, start
+
+
+def header(source, animations, names, storage, start):
+    """Texte de l'en-tête et bilan mémoire."""
+    index_type = "uint8_t" if len(storage) <= 256 else "uint16_t"
+    index_size = 1 if index_type == "uint8_t" else 2
+    descriptor = index_size + 4
+    raw = sum(len(animations[name][3]) for name in names)
+    flash = len(storage) + descriptor * len(names)
+
+    owners = {}
+    for name in names:
+        owners.setdefault(start[name], []).append(name)
+
+    out = []
+    out.append("/*")
+    out.append(" * -------------------------------------------------------------------------")
+    out.append(" * Spectacle généré par tools/show_compile.py à partir de %s" % source)
+    out.append(" * Ne pas modifier ce fichier : modifier la description, puis la recompiler.")
+    out.append(" * -------------------------------------------------------------------------")
+    out.append(" *")
+    out.append(" * Mémoire flash : %d octets (%d motifs, %d descripteurs de %d octets)"
+               % (flash, len(storage), len(names), descriptor))
+    out.append(" * Mémoire vive  : %d octets (copie du descripteur de l'animation en cours)" % descriptor)
+    out.append(" * Motifs joués  : %d, stockés : %d" % (raw, len(storage)))
+    out.append(" */")
+    out.append("")
+    out.append("#pragma once")
+    out.append("")
+    out.append("#include <Arduino.h>")
+    out.append("#include <Transition.h>")
+    out.append("")
+    out.append("/**")
+    out.append(" * @brief Nombre d'animations au programme du spectacle.")
+    out.append(" */")
+    out.append("const uint8_t NUM_ANIMATIONS = %d;" % len(names))
+    out.append("")
+    out.append("/**")
+    out.append(" * @brief Motifs de toutes les animations, dans un seul tableau.")
+    out.append(" *")
+    out.append(" * @note Une séquence commune à plusieurs animations n'y figure qu'une fois.")
+    out.append(" */")
+    out.append("const uint8_t ANIMATION_FRAME[] PROGMEM = {")
+    for i, frame in enumerate(storage):
+        comment = ""
+        if i in owners:
+            comment = " // " + ", ".join(owners[i])
+        separator = "," if i + 1 < len(storage) else " "
+        out.append("    0b{:08b}{}{}".format(frame, separator, comment).rstrip())
+    out.append("};")
+    out.append("")
+    out.append("/**")
+    out.append(" * @brief Descripteur d'une animation.")
+    out.append(" *")
+    out.append(" * @note L'indice de départ tient sur %s : le séquenceur n'a pas de" % ("8 bits" if index_size == 1 else "16 bits"))
+    out.append(" *       calcul plus large à effectuer pour lire un motif.")
+    out.append(" */")
+    out.append("struct Animation {")
+    out.append("    %-10s start;          // Indice du motif de départ dans le tableau." % index_type)
+    out.append("    uint8_t    frames;         // Nombre de motifs constituant la séquence.")
+    out.append("    uint8_t    frame_delay_ms; // Durée d'affichage de chaque motif exprimée en millisecondes.")
+    out.append("    uint8_t    repeat;         // Nombre de répétitions de la séquence.")
+    out.append("    Transition transition;     // Transition qui amène cette animation (voir lib/Transition).")
+    out.append("};")
+    out.append("")
+    out.append("static_assert(sizeof(Animation) == %d, \"Descripteur d'animation inattendu.\");" % descriptor)
+    out.append("")
+    out.append("/**")
+    out.append(" * @brief Animations, dans l'ordre de lecture.")
+    out.append(" */")
+    out.append("const Animation animation[] PROGMEM = {")
+    width = max(len(name) for name in names)
+    for i, name in enumerate(names):
+        delay, repeat, transition, frames, _ = animations[name]
+        separator = "," if i + 1 < len(names) else " "
+        out.append("    { %5d, %3d, %3d, %3d, %-10s }%s // %-*s #%d"
+                   % (start[name], len(frames), delay, repeat, transition, separator, width, name, i))
+    out.append("};")
+    out.append("")
+
+    report = "%d octets en flash (%d motifs stockés pour %d joués), %d octets en SRAM" % (
+        flash, len(storage), raw, descriptor)
+
+    return "\n".join(out), report
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compilation d'un spectacle en en-tête C++.")
+    parser.add_argument("show", help="description du spectacle")
+    parser.add_argument("output", help="en-tête à générer")
+    args = parser.parse_args()
+
+    try:
+        animations, names = parse(args.show)
+        storage, start = layout(animations, names)
+    except ShowError as e:
+        sys.exit(str(e))
+
+    # Vérification : chaque animation se relit à l'identique.
+    for name in names:
+        frames = animations[name][3]
+        assert storage[start[name]:start[name] + len(frames)] == frames
+
+    text, report = header(os.path.basename(args.show), animations, names, storage, start)
+
+    with open(args.output, "w") as f:
+        f.write(text)
+
+    print("%s : %s" % (args.output, report))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+# -------------------------------------------------------------------------
+# Atelier de programmation Robotic 974
+# -------------------------------------------------------------------------
+# Téléversement d'un spectacle dans l'EEPROM de la carte (exercice 14)
+# -------------------------------------------------------------------------
+#
+# Le spectacle est décrit par un fichier texte, à raison d'une animation par
+# ligne, sous la forme :
+#
+#   durée répétitions transition : motif motif motif ...
+#
+# où la durée d'affichage de chaque motif est exprimée en millisecondes, la
+# transition est l'une de celles définies dans lib/Transition (CUT, WIPE_UP,
+# WIPE_DOWN, WIPE_OUT, DISSOLVE, SLIDE_UP, SLIDE_DOWN), et chaque motif est
+# écrit en binaire (par exemple `10000001`).
+#
+# Usage :
+#
+#   show_upload.py spectacle.txt port /dev/ttyUSB0
+#
+#       Téléverse le spectacle sur la carte (115200 bit/s, avec pyserial).
+#       Chaque paquet est acquitté par la carte avant l'envoi du suivant.
+#
+#   show_upload.py spectacle.txt file paquets.bin
+#
+#       Écrit la suite des paquets dans un fichier, à transmettre au
+#       programme compilé dans l'environnement native, à une cadence assez
+#       lente pour laisser à la carte le temps d'écrire en EEPROM :
+#
+#           program 20 1000 paquets.bin 250 > trace.txt
+
+import argparse
+import struct
+import sys
+import time
+
+TRANSITIONS = ["CUT", "WIPE_UP", "WIPE_DOWN", "WIPE_OUT", "DISSOLVE", "SLIDE_UP", "SLIDE_DOWN"]
+
+MAX_ANIMATIONS = 16
+MAX_FRAMES = 384
+CHUNK = 32
+
+SYNC, ACK, NAK = 0x7e, 0x06, 0x15
+
+
+def crc8(data):
+    crc = 0
+    for value in data:
+        crc ^= value
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07 if crc & 0x80 else crc << 1) & 0xff
+    return crc
+
+
+def crc16(data):
+    crc = 0xffff
+    for value in data:
+        crc ^= value << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021 if crc & 0x8000 else crc << 1) & 0xffff
+    return crc
+
+
+def parse(path):
+    """Liste des animations : (durée, répétitions, transition, motifs)."""
+    animations = []
+    with open(path) as f:
+        for number, line in enumerate(f, 1):
+            line = line.split("#")[0].strip()
+            if not line:
+                continue
+            head, frames = line.split(":")
+            delay, repeat, transition = head.split()
+            frames = [int(frame, 2) for frame in frames.split()]
+            if not frames or not 1 <= int(delay) <= 255 or not 1 <= int(repeat) <= 255:
+                sys.exit("%s:%d : animation invalide" % (path, number))
+            animations.append((int(delay), int(repeat), TRANSITIONS.index(transition.upper()), frames))
+    return animations
+
+
+def image(animations):
+    """Image binaire du spectacle, telle qu'elle est rangée en EEPROM."""
+    frames = [frame for a in animations for frame in a[3]]
+    if len(animations) > MAX_ANIMATIONS or len(frames) > MAX_FRAMES:
+        sys.exit("spectacle trop grand : %d animations (16 au plus), %d motifs (384 au plus)"
+                 % (len(animations), len(frames)))
+    data = struct.pack("<BH", len(animations), len(frames))
+    start = 0
+    for delay, repeat, transition, pattern in animations:
+        data += struct.pack("<HBBBB", start, len(pattern), delay, repeat, transition)
+        start += len(pattern)
+    return data + bytes(frames)
+
+
+def packet(command, payload):
+    body = bytes([ord(command), len(payload)]) + payload
+    return bytes([SYNC]) + body + bytes([crc8(body)])
+
+
+def packets(data):
+    yield packet("B", struct.pack("<H", len(data)))
+    for offset in range(0, len(data), CHUNK):
+        yield packet("W", struct.pack("<H", offset) + data[offset:offset + CHUNK])
+    yield packet("C", struct.pack("<H", crc16(data)))
+
+
+def upload(data, device):
+    import serial
+
+    with serial.Serial(device, 115200, timeout=2) as port:
+        time.sleep(2)  # redémarrage de la carte à l'ouverture du port
+        start = time.monotonic()
+        for p in packets(data):
+            port.write(p)
+            reply = port.read(1)
+            if reply != bytes([ACK]):
+                sys.exit("paquet '%s' refusé par la carte (%r)" % (chr(p[1]), reply))
+        print("%d octets téléversés en %.1f s" % (len(data), time.monotonic() - start))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Téléversement d'un spectacle en EEPROM.")
+    parser.add_argument("show", help="description du spectacle")
+    parser.add_argument("mode", choices=("port", "file"))
+    parser.add_argument("target", help="port série ou fichier de sortie")
+    args = parser.parse_args()
+
+    data = image(parse(args.show))
+
+    if args.mode == "port":
+        upload(data, args.target)
+    else:
+        with open(args.target, "wb") as f:
+            for p in packets(data):
+                f.write(p)
+        print("%d octets d'image, CRC-16 0x%04x" % (len(data), crc16(data)))
+
+
+if __name__ == "__main__":
+    main()
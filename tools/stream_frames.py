@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+# -------------------------------------------------------------------------
+# Atelier de programmation Robotic 974
+# -------------------------------------------------------------------------
+# Émission d'un flux de motifs pour l'exercice 13, et vérification
+# -------------------------------------------------------------------------
+#
+# Le flux de test est une suite d'octets dont deux valeurs consécutives
+# diffèrent toujours (chaque motif vaut le précédent plus 37, modulo 256) :
+# chaque motif affiché se repère donc dans la trace des broches.
+#
+# Usage :
+#
+#   stream_frames.py port /dev/ttyUSB0 [-r 4000] [-n 40000]
+#
+#       Émet le flux sur la liaison série (1 Mbit/s), à la cadence indiquée,
+#       et affiche les bilans renvoyés par la carte (nécessite pyserial).
+#
+#   stream_frames.py file flux.bin [-n 40000]
+#
+#       Écrit le flux dans un fichier, à transmettre au programme compilé
+#       dans l'environnement native :
+#
+#           program 10 1000 flux.bin 4000 > trace.txt
+#
+#   stream_frames.py verify trace.txt
+#
+#       Reconstitue les motifs affichés à partir de la trace des broches
+#       (D5 à D12) et vérifie qu'ils se suivent dans l'ordre du flux, sans
+#       qu'aucun ne manque.
+
+import argparse
+import sys
+import time
+
+STEP = 37
+LED_PINS = range(5, 13)
+
+
+def frames(count):
+    """Flux de test de `count` motifs."""
+    return bytes((i * STEP) & 0xff for i in range(count))
+
+
+def send(args):
+    import serial
+
+    data = frames(args.count)
+    period = 1.0 / args.rate
+    chunk = max(1, args.rate // 1000)
+
+    with serial.Serial(args.target, 1000000, timeout=0) as port:
+        start = time.perf_counter()
+        for i in range(0, len(data), chunk):
+            # Les motifs sont émis par paquets d'une milliseconde environ,
+            # calés sur l'horloge de l'hôte pour ne pas dériver.
+            delay = start + i * period - time.perf_counter()
+            if delay > 0:
+                time.sleep(delay)
+            port.write(data[i:i + chunk])
+            sys.stdout.write(port.read(256).decode(errors="replace"))
+        time.sleep(1.5)
+        sys.stdout.write(port.read(4096).decode(errors="replace"))
+
+
+def verify(args):
+    # Le premier motif du flux (0) ne change l'état d'aucune broche.
+    state = {pin: 0 for pin in LED_PINS}
+    shown = [0]
+    events = {}
+    with open(args.target) as f:
+        for line in f:
+            t, pin, level = map(int, line.split())
+            events.setdefault(t, []).append((pin, level))
+    for t in sorted(events):
+        for pin, level in events[t]:
+            state[pin] = level
+        shown.append(sum(state[pin] << i for i, pin in enumerate(LED_PINS)))
+
+    for n, frame in enumerate(shown):
+        if frame != (n * STEP) & 0xff:
+            print("motif #%d : 0x%02x affiché, 0x%02x attendu" % (n, frame, (n * STEP) & 0xff))
+            return 1
+    print("%d motifs affichés dans l'ordre, aucun motif manquant" % len(shown))
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Flux de motifs de l'exercice 13.")
+    parser.add_argument("mode", choices=("port", "file", "verify"))
+    parser.add_argument("target", help="port série, fichier de sortie ou trace à vérifier")
+    parser.add_argument("-r", "--rate", type=int, default=4000, help="motifs par seconde")
+    parser.add_argument("-n", "--count", type=int, default=40000, help="nombre de motifs")
+    args = parser.parse_args()
+
+    if args.mode == "port":
+        send(args)
+    elif args.mode == "file":
+        with open(args.target, "wb") as f:
+            f.write(frames(args.count))
+    else:
+        return verify(args)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())